@@ -0,0 +1,29 @@
+/**
+ * @file bench_main.cpp
+ * @brief Main entry point for the BoyBoy emulator benchmarks.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <benchmark/benchmark.h>
+
+// boyboy
+#include "boyboy/common/log/logging.h"
+
+int main(int argc, char** argv)
+{
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    // Keep logging out of the measured loops
+    boyboy::common::log::init("logs/bench_boyboy.log", true);
+    boyboy::common::log::set_level(boyboy::common::log::LogLevel::Warn);
+
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::benchmark::Shutdown();
+
+    boyboy::common::log::shutdown();
+    return 0;
+}
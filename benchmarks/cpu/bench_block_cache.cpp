@@ -0,0 +1,87 @@
+/**
+ * @file bench_block_cache.cpp
+ * @brief Predecoded block cache benchmarks in TickMode::Instruction.
+ *
+ * Runs the same workloads with the block cache disabled (0), enabled (1), with block batching (2)
+ * and with batching and superinstructions (3). The label reports the block cache hit rate of the
+ * last iteration.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <format>
+#include <string>
+
+#include "helpers/rom_runner.h"
+
+namespace boyboy::bench {
+
+namespace {
+
+constexpr uint64_t InstructionsPerIteration = 500'000;
+
+void bm_block_cache(benchmark::State& state, const std::string& rom)
+{
+    RomRunner runner(rom, core::cpu::TickMode::Instruction);
+    runner.cpu().enable_block_cache(state.range(0) != 0);
+    runner.cpu().enable_block_batching(state.range(0) >= 2);
+    runner.cpu().enable_fusion(state.range(0) == 3);
+
+    auto& block_cache = runner.cpu().get_block_cache();
+
+    // Batched and fused instructions run inside a single tick
+    uint64_t instructions = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        runner.reset();
+        block_cache.reset_stats();
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(runner.run(InstructionsPerIteration));
+        instructions +=
+            InstructionsPerIteration + block_cache.stats().batched + block_cache.stats().fused;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(instructions));
+
+    const auto& stats = block_cache.stats();
+    if (auto lookups = stats.hits + stats.misses; lookups != 0) {
+        state.SetLabel(std::format(
+            "hit rate {:.1f}%",
+            100.0 * static_cast<double>(stats.hits) / static_cast<double>(lookups)
+        ));
+    }
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(bm_block_cache, ld_r_r, CpuTest06Rom)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(3)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_block_cache, op_r_r, CpuTest09Rom)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(3)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_block_cache, bit_ops, CpuTest10Rom)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(3)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_block_cache, op_a_hl, CpuTest11Rom)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(3)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace boyboy::bench
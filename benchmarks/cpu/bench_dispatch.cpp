@@ -0,0 +1,53 @@
+/**
+ * @file bench_dispatch.cpp
+ * @brief Opcode dispatch benchmarks in TickMode::Instruction.
+ *
+ * The dispatch engine is selected at build time, so compare a default build against a
+ * -DSWITCH_DISPATCH=ON build. The benchmark label reports which engine was compiled in.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+
+#include "helpers/rom_runner.h"
+
+namespace boyboy::bench {
+
+namespace {
+
+constexpr uint64_t InstructionsPerIteration = 500'000;
+
+#ifdef SWITCH_DISPATCH
+constexpr const char* DispatchEngine = "switch";
+#else
+constexpr const char* DispatchEngine = "table";
+#endif
+
+void bm_dispatch(benchmark::State& state, const std::string& rom)
+{
+    RomRunner runner(rom, core::cpu::TickMode::Instruction);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        runner.reset();
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(runner.run(InstructionsPerIteration));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * InstructionsPerIteration));
+    state.SetLabel(DispatchEngine);
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(bm_dispatch, ld_r_r, CpuTest06Rom)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_dispatch, op_r_r, CpuTest09Rom)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_dispatch, bit_ops, CpuTest10Rom)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_dispatch, op_a_hl, CpuTest11Rom)->Unit(benchmark::kMillisecond);
+
+} // namespace boyboy::bench
@@ -0,0 +1,77 @@
+/**
+ * @file rom_runner.cpp
+ * @brief Headless ROM runner for the BoyBoy benchmarks.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include "helpers/rom_runner.h"
+
+#include <filesystem>
+#include <stdexcept>
+
+// boyboy
+#include "boyboy/common/errors.h"
+#include "boyboy/common/log/logging.h"
+#include "boyboy/core/cartridge/cartridge_loader.h"
+
+namespace boyboy::bench {
+
+using namespace boyboy::common;
+
+std::string rom_path(const std::string& rom)
+{
+    return (std::filesystem::path(BOYBOY_BENCH_ROMS_DIR) / rom).string();
+}
+
+RomRunner::RomRunner(const std::string& rom, core::cpu::TickMode mode)
+    : mode_(mode),
+      io_(std::make_shared<core::io::Io>()),
+      mmu_(std::make_shared<core::mmu::Mmu>(io_)),
+      cpu_(std::make_unique<core::cpu::Cpu>(mmu_)),
+      ppu_(std::make_shared<core::ppu::Ppu>(mmu_.get())),
+      timer_(std::make_shared<core::io::Timer>()),
+      joypad_(std::make_shared<core::io::Joypad>()),
+      serial_(std::make_shared<core::io::Serial>())
+{
+    io_->register_component(ppu_);
+    io_->register_component(timer_);
+    io_->register_component(joypad_);
+    io_->register_component(serial_);
+
+    try {
+        cart_ = core::cartridge::CartridgeLoader::load(rom_path(rom));
+    }
+    catch (const errors::ChecksumError& e) {
+        log::warn("[BENCH] Error loading ROM {}: {}", rom, e.what());
+    }
+
+    if (!cart_ || !cart_->is_loaded()) {
+        throw std::runtime_error("Failed to load ROM: " + rom);
+    }
+
+    reset();
+}
+
+void RomRunner::reset()
+{
+    mmu_->init();
+    io_->init();
+    mmu_->map_rom(*cart_);
+    cpu_->reset();
+    cpu_->set_tick_mode(mode_);
+}
+
+uint64_t RomRunner::run(uint64_t ticks)
+{
+    uint64_t cycles = 0;
+    for (uint64_t i = 0; i < ticks; ++i) {
+        auto tick_cycles = cpu_->tick();
+        mmu_->tick_dma(tick_cycles);
+        io_->tick(tick_cycles);
+        cycles += tick_cycles;
+    }
+    return cycles;
+}
+
+} // namespace boyboy::bench
@@ -0,0 +1,83 @@
+/**
+ * @file rom_runner.h
+ * @brief Headless ROM runner for the BoyBoy benchmarks.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// boyboy
+#include "boyboy/core/cartridge/cartridge.h"
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/cycles.h"
+#include "boyboy/core/io/io.h"
+#include "boyboy/core/io/joypad.h"
+#include "boyboy/core/io/serial.h"
+#include "boyboy/core/io/timer.h"
+#include "boyboy/core/mmu/mmu.h"
+#include "boyboy/core/ppu/ppu.h"
+
+namespace boyboy::bench {
+
+// Test ROMs used as benchmark workloads (relative to the tests ROMs directory)
+const std::string BlarggCpuRoms = "cpu/blargg/individual/";
+const std::string CpuTest04Rom  = BlarggCpuRoms + "04-op r,imm.gb";
+const std::string CpuTest06Rom  = BlarggCpuRoms + "06-ld r,r.gb";
+const std::string CpuTest09Rom  = BlarggCpuRoms + "09-op r,r.gb";
+const std::string CpuTest10Rom  = BlarggCpuRoms + "10-bit ops.gb";
+const std::string CpuTest11Rom  = BlarggCpuRoms + "11-op a,(hl).gb";
+
+/**
+ * @brief Absolute path of a test ROM, relative to the tests ROMs directory.
+ *
+ * @param rom ROM path relative to tests/roms.
+ * @return std::string Absolute ROM path.
+ */
+std::string rom_path(const std::string& rom);
+
+/**
+ * @brief Runs a ROM without display, ticking the same components as the emulator frame loop.
+ *
+ */
+class RomRunner {
+public:
+    explicit RomRunner(
+        const std::string& rom, core::cpu::TickMode mode = core::cpu::TickMode::Instruction
+    );
+
+    /**
+     * @brief Restart the ROM from the initial CPU state.
+     *
+     */
+    void reset();
+
+    /**
+     * @brief Run a number of CPU ticks.
+     *
+     * @param ticks Number of CPU ticks (instructions in TickMode::Instruction).
+     * @return uint64_t Number of T-cycles elapsed.
+     */
+    uint64_t run(uint64_t ticks);
+
+    [[nodiscard]] core::cpu::Cpu& cpu() { return *cpu_; }
+    [[nodiscard]] core::mmu::Mmu& mmu() { return *mmu_; }
+
+private:
+    core::cpu::TickMode mode_;
+
+    std::shared_ptr<core::io::Io> io_;
+    std::shared_ptr<core::mmu::Mmu> mmu_;
+    std::unique_ptr<core::cpu::Cpu> cpu_;
+    std::shared_ptr<core::ppu::Ppu> ppu_;
+    std::shared_ptr<core::io::Timer> timer_;
+    std::shared_ptr<core::io::Joypad> joypad_;
+    std::shared_ptr<core::io::Serial> serial_;
+    std::unique_ptr<core::cartridge::Cartridge> cart_;
+};
+
+} // namespace boyboy::bench
@@ -0,0 +1,86 @@
+/**
+ * @file bench_mmu.cpp
+ * @brief Mmu::read_byte/write_byte benchmarks per memory region.
+ *
+ * Reads or writes the first bytes of a region in a loop, with a cartridge mapped and VRAM/OAM unlocked.
+ * Run on two builds to compare memory map changes, the plain memory regions only cost a page
+ * table lookup while the others go through their region handler.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "helpers/rom_runner.h"
+
+// boyboy
+#include "boyboy/core/io/registers.h"
+#include "boyboy/core/mmu/constants.h"
+
+namespace boyboy::bench {
+
+namespace {
+
+constexpr uint16_t AccessesPerIteration = 4096;
+
+void bm_read_byte(benchmark::State& state, uint16_t start, size_t size)
+{
+    RomRunner runner(CpuTest04Rom, core::cpu::TickMode::Instruction);
+    auto& mmu = runner.mmu();
+    mmu.lock_vram(false);
+    mmu.lock_oam(false);
+
+    for (auto _ : state) {
+        for (uint16_t i = 0; i < AccessesPerIteration; ++i) {
+            benchmark::DoNotOptimize(mmu.read_byte(static_cast<uint16_t>(start + (i % size))));
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * AccessesPerIteration));
+}
+
+void bm_write_byte(benchmark::State& state, uint16_t start, size_t size)
+{
+    RomRunner runner(CpuTest04Rom, core::cpu::TickMode::Instruction);
+    auto& mmu = runner.mmu();
+    mmu.lock_vram(false);
+    mmu.lock_oam(false);
+
+    for (auto _ : state) {
+        for (uint16_t i = 0; i < AccessesPerIteration; ++i) {
+            mmu.write_byte(static_cast<uint16_t>(start + (i % size)), static_cast<uint8_t>(i));
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * AccessesPerIteration));
+}
+
+} // namespace
+
+using namespace boyboy::core::mmu;
+using namespace boyboy::core::io;
+
+BENCHMARK_CAPTURE(bm_read_byte, rom_bank0, ROMBank0Start, 256);
+BENCHMARK_CAPTURE(bm_read_byte, rom_bank1, ROMBank1Start, 256);
+BENCHMARK_CAPTURE(bm_read_byte, vram, VRAMStart, 256);
+BENCHMARK_CAPTURE(bm_read_byte, sram, SRAMStart, 256);
+BENCHMARK_CAPTURE(bm_read_byte, wram, WRAM0Start, 256);
+BENCHMARK_CAPTURE(bm_read_byte, echo, ECHOStart, 256);
+BENCHMARK_CAPTURE(bm_read_byte, oam, OAMStart, OAMSize);
+BENCHMARK_CAPTURE(bm_read_byte, io_timer, IoReg::Timer::DIV, 4);
+BENCHMARK_CAPTURE(bm_read_byte, hram, HRAMStart, HRAMSize);
+BENCHMARK_CAPTURE(bm_read_byte, ie, IEAddr, 1);
+
+// ROM writes are MBC register writes and the other timer registers change the timer state
+BENCHMARK_CAPTURE(bm_write_byte, sram, SRAMStart, 256);
+BENCHMARK_CAPTURE(bm_write_byte, wram, WRAM0Start, 256);
+BENCHMARK_CAPTURE(bm_write_byte, oam, OAMStart, OAMSize);
+BENCHMARK_CAPTURE(bm_write_byte, io_tma, IoReg::Timer::TMA, 1);
+BENCHMARK_CAPTURE(bm_write_byte, hram, HRAMStart, HRAMSize);
+BENCHMARK_CAPTURE(bm_write_byte, ie, IEAddr, 1);
+
+} // namespace boyboy::bench
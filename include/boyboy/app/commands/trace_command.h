@@ -0,0 +1,37 @@
+/**
+ * @file trace_command.h
+ * @brief Trace command for the BoyBoy emulator.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "boyboy/app/commands/command.h"
+
+namespace boyboy::app::commands {
+
+class TraceCommand : public ICommand {
+public:
+    [[nodiscard]] std::string_view name() const override { return Name; }
+    [[nodiscard]] std::string_view description() const override { return Description; }
+    int execute(App& app, const CommandContext& context) override;
+
+    // Accessors
+    [[nodiscard]] const std::string& get_trace_path() const { return trace_path_; }
+    void set_trace_path(const std::string& path) { trace_path_ = path; }
+    [[nodiscard]] bool is_disassemble() const { return disassemble_; }
+    void set_disassemble(bool disassemble) { disassemble_ = disassemble; }
+
+private:
+    static constexpr std::string_view Name = "trace";
+    static constexpr std::string_view Description = "Decode a CPU trace file";
+
+    std::string trace_path_;
+    bool disassemble_{false};
+};
+
+} // namespace boyboy::app::commands
@@ -34,6 +34,11 @@ struct ConfigKeys {
         static constexpr std::string_view Speed = "speed";
         static constexpr std::string_view TickMode = "tick_mode";
         static constexpr std::string_view FetchExecOverlap = "cpu_overlap";
+        static constexpr std::string_view BlockCache = "block_cache";
+        static constexpr std::string_view BlockBatching = "block_batching";
+        static constexpr std::string_view IdleLoopSkip = "idle_loop_skip";
+        static constexpr std::string_view Superinstructions = "superinstructions";
+        static constexpr std::string_view Microcode = "microcode";
     };
     struct Video {
         static constexpr std::string_view Section = "video";
@@ -48,6 +53,9 @@ struct ConfigKeys {
     struct Debug {
         static constexpr std::string_view Section = "debug";
         static constexpr std::string_view LogLevel = "log_level";
+        static constexpr std::string_view Instrumentation = "instrumentation";
+        static constexpr std::string_view Trace = "trace";
+        static constexpr std::string_view Coverage = "coverage";
     };
 
     // Full keys for easy access
@@ -57,6 +65,16 @@ struct ConfigKeys {
                                                        std::string(Emulator::TickMode);
     inline static const std::string EmulatorFEOverlap = std::string(Emulator::Section) + "." +
                                                         std::string(Emulator::FetchExecOverlap);
+    inline static const std::string EmulatorBlockCache = std::string(Emulator::Section) + "." +
+                                                         std::string(Emulator::BlockCache);
+    inline static const std::string EmulatorBlockBatching = std::string(Emulator::Section) + "." +
+                                                            std::string(Emulator::BlockBatching);
+    inline static const std::string EmulatorIdleLoopSkip = std::string(Emulator::Section) + "." +
+                                                           std::string(Emulator::IdleLoopSkip);
+    inline static const std::string EmulatorSuperinstructions =
+        std::string(Emulator::Section) + "." + std::string(Emulator::Superinstructions);
+    inline static const std::string EmulatorMicrocode = std::string(Emulator::Section) + "." +
+                                                        std::string(Emulator::Microcode);
     inline static const std::string VideoScale = std::string(Video::Section) + "." +
                                                  std::string(Video::Scale);
     inline static const std::string VideoVSync = std::string(Video::Section) + "." +
@@ -67,16 +85,30 @@ struct ConfigKeys {
                                                         std::string(Saves::SaveInterval);
     inline static const std::string DebugLogLevel = std::string(Debug::Section) + "." +
                                                     std::string(Debug::LogLevel);
+    inline static const std::string DebugInstrumentation = std::string(Debug::Section) + "." +
+                                                           std::string(Debug::Instrumentation);
+    inline static const std::string DebugTrace = std::string(Debug::Section) + "." +
+                                                 std::string(Debug::Trace);
+    inline static const std::string DebugCoverage = std::string(Debug::Section) + "." +
+                                                    std::string(Debug::Coverage);
 
     inline static const std::vector<std::string> KeyList = {
         EmulatorSpeed,
         EmulatorTickMode,
         EmulatorFEOverlap,
+        EmulatorBlockCache,
+        EmulatorBlockBatching,
+        EmulatorIdleLoopSkip,
+        EmulatorSuperinstructions,
+        EmulatorMicrocode,
         VideoScale,
         VideoVSync,
         SavesAutoSave,
         SavesSaveInterval,
         DebugLogLevel,
+        DebugInstrumentation,
+        DebugTrace,
+        DebugCoverage,
     };
 };
 
@@ -94,11 +126,19 @@ private:
         {ConfigKeys::EmulatorSpeed, Type::Int},
         {ConfigKeys::EmulatorTickMode, Type::String},
         {ConfigKeys::EmulatorFEOverlap, Type::Bool},
+        {ConfigKeys::EmulatorBlockCache, Type::Bool},
+        {ConfigKeys::EmulatorBlockBatching, Type::Bool},
+        {ConfigKeys::EmulatorIdleLoopSkip, Type::Bool},
+        {ConfigKeys::EmulatorSuperinstructions, Type::Bool},
+        {ConfigKeys::EmulatorMicrocode, Type::Bool},
         {ConfigKeys::VideoScale, Type::Int},
         {ConfigKeys::VideoVSync, Type::Bool},
         {ConfigKeys::SavesAutoSave, Type::Bool},
         {ConfigKeys::SavesSaveInterval, Type::Int},
         {ConfigKeys::DebugLogLevel, Type::String},
+        {ConfigKeys::DebugInstrumentation, Type::Bool},
+        {ConfigKeys::DebugTrace, Type::Bool},
+        {ConfigKeys::DebugCoverage, Type::Bool},
     };
 };
 
@@ -108,6 +148,11 @@ struct Config {
         int speed = ConfigLimits::Emulator::SpeedRange.default_value;
         std::string tick_mode = std::string(ConfigLimits::Emulator::TickModeOptions.default_value);
         bool fe_overlap = false;
+        bool block_cache = false;
+        bool block_batching = false;
+        bool idle_loop_skip = false;
+        bool superinstructions = false;
+        bool microcode = false;
     } emulator; // NOLINT
 
     struct Video {
@@ -122,6 +167,9 @@ struct Config {
 
     struct Debug {
         std::string log_level = std::string(ConfigLimits::Debug::LogLevelOptions.default_value);
+        bool instrumentation = false;
+        bool trace = false;
+        bool coverage = false;
     } debug; // NOLINT
 
     static Config default_config() { return Config{}; }
@@ -219,6 +267,21 @@ private:
         {ConfigKeys::EmulatorFEOverlap, ConfigAccessor{[](Config& c) {
              return &c.emulator.fe_overlap;
          }}},
+        {ConfigKeys::EmulatorBlockCache, ConfigAccessor{[](Config& c) {
+             return &c.emulator.block_cache;
+         }}},
+        {ConfigKeys::EmulatorBlockBatching, ConfigAccessor{[](Config& c) {
+             return &c.emulator.block_batching;
+         }}},
+        {ConfigKeys::EmulatorIdleLoopSkip, ConfigAccessor{[](Config& c) {
+             return &c.emulator.idle_loop_skip;
+         }}},
+        {ConfigKeys::EmulatorSuperinstructions, ConfigAccessor{[](Config& c) {
+             return &c.emulator.superinstructions;
+         }}},
+        {ConfigKeys::EmulatorMicrocode, ConfigAccessor{[](Config& c) {
+             return &c.emulator.microcode;
+         }}},
         {ConfigKeys::VideoScale, ConfigAccessor{[](Config& c) {
              return &c.video.scale;
          }}},
@@ -234,6 +297,15 @@ private:
         {ConfigKeys::DebugLogLevel, ConfigAccessor{[](Config& c) {
              return &c.debug.log_level;
          }}},
+        {ConfigKeys::DebugInstrumentation, ConfigAccessor{[](Config& c) {
+             return &c.debug.instrumentation;
+         }}},
+        {ConfigKeys::DebugTrace, ConfigAccessor{[](Config& c) {
+             return &c.debug.trace;
+         }}},
+        {ConfigKeys::DebugCoverage, ConfigAccessor{[](Config& c) {
+             return &c.debug.coverage;
+         }}},
     };
 
     static bool parse_bool(std::string_view value)
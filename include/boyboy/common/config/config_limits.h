@@ -49,8 +49,9 @@ struct ConfigLimits {
         static constexpr std::string_view FastMode = "fast";
         static constexpr std::string_view NormalMode = "normal";
         static constexpr std::string_view PrecisionMode = "precision";
-        static constexpr std::array<std::string_view, 3> TickModes = {
-            FastMode, NormalMode, PrecisionMode
+        static constexpr std::string_view CatchUpMode = "catchup";
+        static constexpr std::array<std::string_view, 4> TickModes = {
+            FastMode, NormalMode, PrecisionMode, CatchUpMode
         };
         static constexpr Options<std::string_view> TickModeOptions = {
             .options = TickModes, .default_value = FastMode
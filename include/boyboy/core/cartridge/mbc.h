@@ -75,6 +75,12 @@ public:
     [[nodiscard]] uint8_t read(uint16_t addr) const;
     void write(uint16_t addr, uint8_t value);
 
+    // 256-byte ROM page currently mapped at addr (0x0000-0x7FFF), nullptr if unmapped
+    [[nodiscard]] const uint8_t* rom_page(uint16_t addr) const;
+
+    // 256-byte SRAM page currently mapped at addr (0xA000-0xBFFF), nullptr if disabled or unmapped
+    [[nodiscard]] const uint8_t* ram_page(uint16_t addr) const;
+
     // Full SRAM data access
     [[nodiscard]] std::vector<uint8_t> get_ram() const;
     void set_ram(std::span<const uint8_t> ram);
@@ -0,0 +1,210 @@
+/**
+ * @file block_cache.h
+ * @brief Predecoded basic-block cache for the BoyBoy CPU interpreter.
+ *
+ * Straight-line runs of instructions are decoded once into micro-ops that carry their handler,
+ * immediate operands and cycle costs. Blocks are keyed on (ROM bank, PC), so the same address in
+ * different MBC banks never aliases. Only ROM, WRAM and HRAM code is cached; blocks living in RAM
+ * are dropped whenever one of their pages is written.
+ *
+ * Blocks can also be run in batches (see Cpu::enable_block_batching), executing several micro-ops
+ * per CPU tick. Micro-ops record which memory they access so the CPU can stop a batch before any
+ * instruction that could observe peripherals lagging behind, and batches end at the next
+ * peripheral event so interrupts aren't delayed.
+ *
+ * With fusion enabled (see Cpu::enable_fusion), micro-ops starting a known hot sequence also carry
+ * a superinstruction (see fusion.h) running the whole sequence in a single dispatch. The covered
+ * micro-ops stay in the block, so the CPU can fall back to them whenever the superinstruction
+ * can't run, e.g. when one of its register pairs points to IO.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "boyboy/core/cpu/fusion.h"
+#include "boyboy/core/cpu/instructions.h"
+#include "boyboy/core/mmu/constants.h"
+
+namespace boyboy::core::mmu {
+// Forward declaration
+class Mmu;
+} // namespace boyboy::core::mmu
+
+namespace boyboy::core::cpu {
+
+/**
+ * @brief Memory accessed by a micro-op, resolved at decode time when the address is static.
+ */
+enum class MemAccess : uint8_t {
+    None,   // no memory access, or a static address in plain memory (ROM, WRAM, HRAM)
+    HL,     // address in HL
+    BC,     // address in BC
+    DE,     // address in DE
+    SP,     // stack access
+    IoRead, // read of a static IO address, never batched but can start a superinstruction
+    Unsafe, // IO access or interrupt/CPU state change, never batched
+};
+
+/**
+ * @brief Whether an address is plain memory, with no side effects on peripherals.
+ * @param addr Address to check.
+ * @return true for ROM, WRAM and HRAM addresses.
+ */
+[[nodiscard]] constexpr bool is_plain_memory(uint16_t addr)
+{
+    return addr <= mmu::ROMEnd || (addr >= mmu::WRAMStart && addr <= mmu::WRAMEnd) ||
+           (addr >= mmu::HRAMStart && addr <= mmu::HRAMEnd);
+}
+
+/**
+ * @brief Predecoded instruction ready to be executed without touching the memory bus.
+ */
+struct MicroOp {
+    OpcodeHandler handler{nullptr};
+    uint16_t pc{};
+    std::array<uint8_t, 2> operands{}; // immediate bytes following the opcode
+    uint8_t opcode{};
+    InstructionType type{InstructionType::Unprefixed};
+    uint8_t cycles{};
+    uint8_t cycles_no_branch{};
+    MemAccess access{MemAccess::None};
+
+    // Superinstruction starting at this micro-op, operands hold the ones of the whole sequence
+    OpcodeHandler fused{nullptr};
+    uint8_t fused_count{};            // micro-ops covered, including this one
+    uint8_t fused_cycles{};           // cycles of the sequence
+    uint8_t fused_cycles_no_branch{}; // cycles of the sequence if its last branch is not taken
+    uint8_t fused_tail{};             // offset from pc to the last instruction of the sequence
+    // Register pairs addressed by the sequence, e.g. HL and DE for a copy loop (the first one may
+    // be IoRead)
+    std::array<MemAccess, 2> fused_access{};
+};
+
+/**
+ * @brief Straight-line run of micro-ops ending at a control flow instruction.
+ */
+struct Block {
+    uint16_t start{};
+    uint16_t end{}; // last byte address covered by the block
+    std::vector<MicroOp> ops;
+    mutable uint64_t executions{}; // times the block was entered, for sequence profiling
+};
+
+class BlockCache {
+public:
+    struct Stats {
+        uint64_t hits{};          // block lookups served from the cache
+        uint64_t misses{};        // block lookups that needed decoding
+        uint64_t invalidations{}; // blocks dropped because their code was written
+        uint64_t batched{};       // micro-ops executed inside a batch after its first one
+        uint64_t fused{};         // micro-ops executed by a superinstruction after its first one
+    };
+
+    static constexpr size_t MaxBlockOps = 64;
+
+    BlockCache(mmu::Mmu& mmu) : mmu_(mmu) {}
+    ~BlockCache();
+
+    // delete move and copy
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+    BlockCache(BlockCache&&) = delete;
+    BlockCache& operator=(BlockCache&&) = delete;
+
+    void enable(bool enable);
+    [[nodiscard]] bool is_enabled() const { return enabled_; }
+
+    // Decode superinstructions, drops the cached blocks
+    void enable_fusion(bool enable);
+    [[nodiscard]] bool is_fusion_enabled() const { return fusion_; }
+
+    /**
+     * @brief Get the micro-op to execute at PC.
+     *
+     * Keeps walking the current block while execution falls through, otherwise looks up (or
+     * decodes) the block starting at PC.
+     *
+     * @param pc Current program counter.
+     * @return const MicroOp* Micro-op at PC or nullptr if PC is not in cacheable memory.
+     */
+    [[nodiscard]] const MicroOp* next(uint16_t pc);
+
+    /**
+     * @brief Peek the micro-op at PC in the current block, without lookups nor advancing.
+     *
+     * @param pc Current program counter.
+     * @return const MicroOp* Micro-op at PC or nullptr if execution left the current block.
+     */
+    [[nodiscard]] const MicroOp* peek(uint16_t pc) const;
+
+    /**
+     * @brief Skip micro-ops of the current block, executed by a superinstruction.
+     * @param count Micro-ops to skip.
+     */
+    void advance(size_t count)
+    {
+        if (current_ != nullptr) {
+            index_ += count;
+        }
+    }
+
+    /**
+     * @brief Notify a write to a page holding cached code.
+     *
+     * Writes to ROM are MBC register writes, which may switch banks under the current block.
+     * Writes to RAM drop every block overlapping the written page.
+     *
+     * @param addr Address written.
+     */
+    void invalidate(uint16_t addr);
+
+    // Drop all cached blocks
+    void clear();
+
+    [[nodiscard]] size_t size() const { return blocks_.size(); }
+    [[nodiscard]] const Stats& stats() const { return stats_; }
+    void reset_stats() { stats_ = {}; }
+    void count_batched() { stats_.batched++; }
+    void count_fused(uint8_t count) { stats_.fused += count; }
+
+    /**
+     * @brief Execution counts of the opcode pairs and triples run from cached blocks.
+     *
+     * Blocks are assumed to run to completion every time they are entered.
+     *
+     * @return SequenceProfile Profile of the cached and already dropped blocks.
+     */
+    [[nodiscard]] SequenceProfile profile() const;
+
+private:
+    static constexpr size_t PageCount = 256;
+
+    mmu::Mmu& mmu_;
+    bool enabled_{false};
+    bool fusion_{false};
+
+    std::unordered_map<uint32_t, Block> blocks_;
+    std::array<std::vector<uint32_t>, PageCount> page_blocks_{}; // RAM page -> block keys
+
+    // Current block cursor
+    const Block* current_{nullptr};
+    size_t index_{0};
+
+    Stats stats_{};
+    SequenceProfile retired_; // profile of the dropped blocks
+
+    [[nodiscard]] const Block* lookup(uint16_t pc);
+    [[nodiscard]] bool decode(uint16_t pc, uint16_t region_end, bool ram, Block& block) const;
+    void fuse(Block& block, bool ram) const;
+    void retire(const Block& block);
+    void watch_rom(bool watch);
+};
+
+} // namespace boyboy::core::cpu
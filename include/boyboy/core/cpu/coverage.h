@@ -0,0 +1,130 @@
+/**
+ * @file coverage.h
+ * @brief Executed code coverage bitmaps for the BoyBoy CPU.
+ *
+ * When enabled, the CPU sets one bit for every opcode it fetches: one bit per byte of every ROM
+ * bank (the bank at 0x4000-0x7FFF is the one selected in the MBC at fetch time) plus one bit per
+ * byte of WRAM and HRAM for code copied to RAM. Code running from other regions isn't recorded.
+ *
+ * Coverage file format (host endianness):
+ *   CoverageFileHeader, followed by `rom_banks` ROM bank bitmaps, the WRAM bitmap and the HRAM
+ *   bitmap. Bitmaps are arrays of uint64_t words, bit `offset % 64` of word `offset / 64` is set
+ *   if an opcode was fetched at `offset` within the bank or RAM region.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "boyboy/common/files/errors.h"
+#include "boyboy/core/mmu/constants.h"
+
+namespace boyboy::core::cpu {
+
+/**
+ * @brief Header of a coverage file.
+ */
+struct CoverageFileHeader {
+    static constexpr std::array<char, 8> Magic = {'B', 'B', 'C', 'O', 'V', 'E', 'R', '\0'};
+    static constexpr uint16_t CurrentVersion = 1;
+
+    std::array<char, 8> magic;
+    uint16_t version;
+    uint16_t rom_banks;
+    uint32_t reserved;
+};
+static_assert(sizeof(CoverageFileHeader) == 16);
+static_assert(std::is_trivially_copyable_v<CoverageFileHeader>);
+
+class CoverageMap {
+public:
+    using Word = uint64_t;
+    static constexpr size_t WordBits = 64;
+    static constexpr size_t RomBankSize = mmu::ROMBank0Size;
+
+    static constexpr size_t RomBankWords = RomBankSize / WordBits;
+    static constexpr size_t WramWords = mmu::WRAMSize / WordBits;
+    static constexpr size_t HramWords = (mmu::HRAMSize + WordBits - 1) / WordBits;
+
+    void enable(bool enable);
+    [[nodiscard]] bool is_enabled() const { return enabled_; }
+
+    // ROM banks of the loaded cartridge, banks past them grow the bitmap when executed
+    void set_rom_banks(size_t banks);
+    [[nodiscard]] size_t rom_banks() const { return rom_.size() / RomBankWords; }
+    void clear();
+
+    /**
+     * @brief Mark an opcode fetch.
+     *
+     * @param addr Address of the opcode.
+     * @param bank ROM bank mapped at 0x4000-0x7FFF, ignored elsewhere.
+     */
+    void record(uint16_t addr, uint16_t bank)
+    {
+        if (addr <= mmu::ROMEnd) {
+            size_t offset = (addr <= mmu::ROMBank0End)
+                                ? addr
+                                : (bank * RomBankSize) + (addr - mmu::ROMBank1Start);
+            if (offset >= rom_.size() * WordBits) [[unlikely]] {
+                grow(offset);
+            }
+            set(rom_.data(), offset);
+        }
+        else if (addr >= mmu::WRAMStart && addr <= mmu::WRAMEnd) {
+            set(wram_.data(), addr - mmu::WRAMStart);
+        }
+        else if (addr >= mmu::HRAMStart && addr <= mmu::HRAMEnd) {
+            set(hram_.data(), addr - mmu::HRAMStart);
+        }
+    }
+
+    // Whether an opcode was fetched at an address (bank as in record())
+    [[nodiscard]] bool is_covered(uint16_t addr, uint16_t bank) const;
+
+    // Bytes of a ROM bank holding executed opcodes
+    [[nodiscard]] size_t covered_bytes(size_t bank) const;
+
+    /**
+     * @brief Summary of the executed code, one line per ROM bank and RAM region.
+     *
+     * e.g. `ROM bank 001:   4120/16384 bytes ( 25.15%)`
+     *
+     * @return std::string Summary text.
+     */
+    [[nodiscard]] std::string summary() const;
+
+    /**
+     * @brief Write the bitmaps to a coverage file.
+     *
+     * @param path Coverage file path.
+     * @return std::expected<void, common::files::FileError> Nothing or FileError on error.
+     */
+    [[nodiscard]] std::expected<void, common::files::FileError> flush(
+        const std::filesystem::path& path
+    ) const;
+
+private:
+    bool enabled_{false};
+    std::vector<Word> rom_;
+    std::array<Word, WramWords> wram_{};
+    std::array<Word, HramWords> hram_{};
+
+    static void set(Word* bitmap, size_t offset)
+    {
+        bitmap[offset / WordBits] |= Word{1} << (offset % WordBits); // NOLINT
+    }
+
+    void grow(size_t offset); // add the banks up to a ROM offset
+};
+
+} // namespace boyboy::core::cpu
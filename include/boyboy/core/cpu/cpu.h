@@ -8,23 +8,36 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string_view>
 
 #include "boyboy/common/utils.h"
+#include "boyboy/core/cpu/block_cache.h"
+#include "boyboy/core/cpu/coverage.h"
 #include "boyboy/core/cpu/cycles.h"
+#include "boyboy/core/cpu/fusion.h"
+#include "boyboy/core/cpu/idle_loop.h"
 #include "boyboy/core/cpu/instructions.h"
 #include "boyboy/core/cpu/interrupt_handler.h"
+#include "boyboy/core/cpu/flag_result.h"
+#include "boyboy/core/cpu/microcode.h"
 #include "boyboy/core/cpu/opcodes.h"
 #include "boyboy/core/cpu/registers.h"
 #include "boyboy/core/cpu/state.h"
+#include "boyboy/core/cpu/trace_buffer.h"
+#include "boyboy/core/mmu/constants.h"
 #include "boyboy/core/mmu/mmu.h"
 
 namespace boyboy::core::cpu {
 
 class Cpu {
 public:
-    Cpu(std::shared_ptr<mmu::Mmu> mmu) : mmu_(std::move(mmu)), interrupt_handler_(*this, *mmu_) {}
+    Cpu(std::shared_ptr<mmu::Mmu> mmu)
+        : mmu_(std::move(mmu)), interrupt_handler_(*this, *mmu_), block_cache_(*mmu_),
+          idle_loop_(*mmu_)
+    {
+    }
     ~Cpu() = default;
 
     // delete move and copy
@@ -42,15 +55,25 @@ public:
     [[nodiscard]] uint16_t get_register(Reg16Name reg) const;
     void set_register(Reg8Name reg, uint8_t value);
     void set_register(Reg16Name reg, uint16_t value);
-    [[nodiscard]] uint16_t get_sp() const { return registers_.sp; }
-    [[nodiscard]] uint16_t get_pc() const { return registers_.pc; }
-    void set_sp(uint16_t sp) { registers_.sp = sp; }
-    void set_pc(uint16_t pc) { registers_.pc = pc; }
-    void push_pc() { push_r16(Reg16Name::PC); } // Push current PC to stack
+    [[nodiscard]] uint16_t get_sp() const { return registers_.sp(); }
+    [[nodiscard]] uint16_t get_pc() const { return registers_.pc(); }
+    void set_sp(uint16_t sp) { registers_.sp(sp); }
+    void set_pc(uint16_t pc) { registers_.pc(pc); }
+    void push_pc(); // Push current PC to stack
+
+    // Compile-time register accessors, resolved without switching on the register name
+    template <Reg8Name R>
+    [[nodiscard]] uint8_t get_register() const;
+    template <Reg16Name R>
+    [[nodiscard]] uint16_t get_register() const;
+    template <Reg8Name R>
+    void set_register(uint8_t value);
+    template <Reg16Name R>
+    void set_register(uint16_t value);
 
     // Flag accessors
-    [[nodiscard]] bool get_flag(uint8_t flag) const { return registers_.af.get_flag(flag); }
-    void set_flag(uint8_t flag, bool value) { registers_.af.set_flag(flag, value); }
+    [[nodiscard]] bool get_flag(uint8_t flag) const { return (registers_.f() & flag) != 0; }
+    void set_flag(uint8_t flag, bool value) { registers_.flag(flag, value); }
     [[nodiscard]] uint8_t get_flags() const { return registers_.f(); }
 
     // State accessors
@@ -60,6 +83,10 @@ public:
     [[nodiscard]] bool is_ime_scheduled() const { return ime_scheduled_ > 0; }
     [[nodiscard]] bool is_halted() const { return halted_; }
     void set_halted(bool halted);
+
+    // Architectural state snapshots
+    [[nodiscard]] CpuState snapshot() const;
+    void restore(const CpuState& state);
     [[nodiscard]] uint64_t get_cycles() const { return cycles_; }
     void set_cycles(uint64_t cycles) { cycles_ = cycles; }
     void add_cycles(uint8_t cycles) { cycles_ += cycles; }
@@ -69,14 +96,125 @@ public:
     void set_tick_mode(TickMode mode);
 
     [[nodiscard]] bool is_fe_overlap_enabled() const { return fe_overlap_; }
-    void enable_fe_overlap(bool enable) { fe_overlap_ = enable; }
+    void enable_fe_overlap(bool enable);
+
+    // Microcoded execution, memory accesses on their own M-cycle (M-cycle and T-cycle modes only)
+    [[nodiscard]] bool is_microcode_enabled() const { return microcode_; }
+    void enable_microcode(bool enable);
+
+    // Predecoded block cache (only used in TickMode::Instruction and TickMode::CatchUp)
+    [[nodiscard]] bool is_block_cache_enabled() const { return block_cache_.is_enabled(); }
+    void enable_block_cache(bool enable) { block_cache_.enable(enable); }
+    [[nodiscard]] BlockCache& get_block_cache() { return block_cache_; }
+    [[nodiscard]] const BlockCache& get_block_cache() const { return block_cache_; }
+
+    // Batched block execution (TickMode::Instruction only, enables the block cache)
+    [[nodiscard]] bool is_block_batching_enabled() const { return block_batching_; }
+    void enable_block_batching(bool enable);
+
+    // Superinstructions for hot sequences (TickMode::Instruction only, enables the block cache)
+    [[nodiscard]] bool is_fusion_enabled() const { return block_cache_.is_fusion_enabled(); }
+    void enable_fusion(bool enable);
+
+    /**
+     * @brief Set the callback ticking the peripherals in TickMode::CatchUp.
+     *
+     * Before an instruction reads or writes memory backed by a peripheral (VRAM, OAM, I/O or
+     * cartridge RAM), the peripherals are ticked up to the M-cycle of the access. tick() then
+     * only returns the T-cycles of the instruction left to tick.
+     *
+     * @param callback Called with the T-cycles to tick the peripherals by.
+     */
+    using SyncCallback = std::function<void(TCycle)>;
+    void set_sync_callback(SyncCallback callback) { sync_cb_ = std::move(callback); }
+
+    /**
+     * @brief Fast-forward a halted CPU with nothing to wake it up.
+     *
+     * Equivalent to ticking the CPU until the given number of cycles elapse, rounded up to the
+     * tick mode granularity.
+     *
+     * @param cycles T-cycles until the next event that could wake the CPU up.
+     * @return TCycle T-cycles skipped, 0 if the CPU can't be fast-forwarded.
+     */
+    TCycle fast_forward(TCycle cycles);
+
+    // Idle loop detection (TickMode::Instruction only)
+    [[nodiscard]] bool is_idle_loop_skip_enabled() const { return idle_loop_.is_enabled(); }
+    void enable_idle_loop_skip(bool enable) { idle_loop_.enable(enable); }
+    [[nodiscard]] IdleLoopDetector& get_idle_loop_detector() { return idle_loop_; }
+    [[nodiscard]] const IdleLoopDetector& get_idle_loop_detector() const { return idle_loop_; }
+
+    /**
+     * @brief Skip whole iterations of the idle loop the CPU is spinning in.
+     *
+     * Equivalent to running the loop for the skipped cycles, which never reach the next
+     * peripheral event.
+     *
+     * @param cycles_to_event T-cycles until the next peripheral event (see Io::cycles_to_event).
+     * @param max_cycles Max T-cycles to skip.
+     * @return TCycle T-cycles skipped, 0 if the CPU isn't in a confirmed idle loop.
+     */
+    TCycle skip_idle_loop(TCycle cycles_to_event, TCycle max_cycles);
 
     // Execution state accessors
     [[nodiscard]] const ExecutionState& get_execution_state() const { return exec_state_; }
 
+    // Binary trace of the last executed instructions
+    [[nodiscard]] bool is_trace_enabled() const { return trace_.is_enabled(); }
+    void enable_trace(bool enable)
+    {
+        trace_.enable(enable);
+        select_tick();
+    }
+    [[nodiscard]] TraceBuffer& get_trace_buffer() { return trace_; }
+    [[nodiscard]] const TraceBuffer& get_trace_buffer() const { return trace_; }
+
+    // Executed code bitmaps per ROM bank
+    [[nodiscard]] bool is_coverage_enabled() const { return coverage_.is_enabled(); }
+    void enable_coverage(bool enable)
+    {
+        coverage_.enable(enable);
+        select_tick();
+    }
+    [[nodiscard]] CoverageMap& get_coverage() { return coverage_; }
+    [[nodiscard]] const CoverageMap& get_coverage() const { return coverage_; }
+
     // Execution functions
     TCycle tick();
-    uint8_t fetch();
+
+    /**
+     * @brief Tick specialized on the tick mode, fetch/execute overlap and step kind.
+     *
+     * Same as tick() without any configuration branch, for callers that select the
+     * instantiation once (fetch/execute overlap only applies to M-cycle and T-cycle modes, see
+     * get_step_kind() for the step kind).
+     *
+     * @return TCycle T-cycles ticked.
+     */
+    template <TickMode Mode, bool FeOverlap, StepKind Step = StepKind::Plain>
+    TCycle tick();
+
+    // Step kind of the current configuration: recording, then batching
+    [[nodiscard]] StepKind get_step_kind() const;
+
+    uint8_t fetch()
+    {
+        // Operands of a predecoded micro-op don't go through the memory bus
+        if (operands_ != nullptr) {
+            registers_.advance_pc();
+            return *operands_++;
+        }
+
+        // Sequential fetches within the current page read it directly
+        uint16_t pc = registers_.pc();
+        if ((pc >> 8) == fetch_page_tag_ &&
+            fetch_map_generation_ == mmu_->map_generation()) [[likely]] {
+            registers_.advance_pc();
+            return fetch_page_[pc & 0xFF];
+        }
+        return fetch_slow();
+    }
     [[nodiscard]] uint8_t peek() const; // fetch without PC increment
     uint8_t execute(uint8_t opcode, InstructionType instr_type = InstructionType::Unprefixed);
 
@@ -122,15 +260,123 @@ private:
     bool halt_bug_{false};
     bool fe_overlap_{false};
     bool branch_taken_{false}; // Whether a condition branch has been taken
+    bool block_batching_{false};
+    bool microcode_{false};
 
     ExecutionState exec_state_;
 
+    BlockCache block_cache_;
+    const uint8_t* operands_{nullptr}; // predecoded operands of the micro-op being executed
+
+    // Page holding PC for direct fetches (see Mmu::fetch_page), refreshed on page crossings,
+    // jumps and remaps. The HALT bug invalidates it so its repeated fetch takes the slow path.
+    static constexpr uint16_t NoFetchPage = 0x100;
+    const uint8_t* fetch_page_{nullptr};
+    uint16_t fetch_page_tag_{NoFetchPage}; // PC >> 8 of fetch_page_
+    uint32_t fetch_map_generation_{0};
+    uint8_t fetch_slow();
+    void invalidate_fetch_page() { fetch_page_tag_ = NoFetchPage; }
+
+    IdleLoopDetector idle_loop_;
+
+    // Access timing of the current tick in TickMode::CatchUp
+    SyncCallback sync_cb_{nullptr};
+    uint16_t access_pc_{0};     // PC at the start of the instruction being executed
+    TCycle access_base_{0};     // T-cycles of the tick before the instruction (interrupt service)
+    uint8_t data_accesses_{0};  // memory reads and writes done by the instruction so far
+    TCycle synced_cycles_{0};   // T-cycles of the tick the peripherals were already ticked by
+    void time_instruction(TCycle base);
+    void time_access(uint16_t addr);
+
+    // Microcoded execution state of the current instruction
+    MicroLatches micro_;
+    void begin_microprogram(InstructionType type, uint8_t opcode);
+    void micro_tick(); // run the steps of the M-cycle that just ended
+    void micro_execute();
+    void flush_micro_writes();
+    [[nodiscard]] uint16_t micro_address(MicroAddr addr) const;
+
+    // Memory accesses of the instruction handlers, timed in TickMode::CatchUp and served from the
+    // latches while a microprogram runs the handler
+    enum class BusMode : uint8_t { Direct, CatchUp, Latched };
+    BusMode bus_mode_{BusMode::Direct};
+    uint8_t bus_read(uint16_t addr)
+    {
+        if (bus_mode_ != BusMode::Direct) [[unlikely]] {
+            return bus_read_slow(addr);
+        }
+        return mmu_->read_byte(addr);
+    }
+    void bus_write(uint16_t addr, uint8_t value)
+    {
+        if (bus_mode_ != BusMode::Direct) [[unlikely]] {
+            bus_write_slow(addr, value);
+            return;
+        }
+        mmu_->write_byte(addr, value);
+    }
+    uint8_t bus_read_slow(uint16_t addr);
+    void bus_write_slow(uint16_t addr, uint8_t value);
+
+    TraceBuffer trace_;
+    void record_trace(); // store the state at the start of the next instruction
+
+    CoverageMap coverage_;
+    void record_coverage() // mark the opcode at PC as executed
+    {
+        uint16_t pc = registers_.pc();
+        coverage_.record(pc, code_bank(pc));
+    }
+
+    // ROM bank of code at an address, 0 outside of the switchable bank
+    [[nodiscard]] uint16_t code_bank(uint16_t addr) const
+    {
+        bool banked = addr >= mmu::ROMBank1Start && addr <= mmu::ROMBank1End;
+        return banked ? mmu_->rom_bank() : uint16_t{0};
+    }
+
+    // tick() instantiation for the current tick mode, fetch/execute overlap and step kind
+    using TickFn = TCycle (Cpu::*)();
+    TickFn tick_fn_{&Cpu::tick<TickMode::MCycle, false>};
+    void select_tick();
+    template <TickMode Mode>
+    static TickFn select_cycle_tick(bool fe_overlap, bool recorded);
+
+    template <TickMode Mode, StepKind Step>
     uint8_t step();
+    TCycle step_batch();
+    template <bool FeOverlap, StepKind Step>
     void tick_cycles(Cycles cycles);
 
+    template <bool FeOverlap, StepKind Step>
     void fetch_stage();
     void execute_stage();
 
+    /**
+     * @brief Execute a predecoded micro-op from the block cache, or its superinstruction.
+     *
+     * @tparam Fuse Whether superinstructions may run (see is_fusable()).
+     * @param op Micro-op to execute.
+     * @param branch_pc Address of the executed instruction, moved to the last instruction of the
+     * superinstruction if any.
+     * @return uint8_t T-cycles executed.
+     */
+    template <bool Fuse>
+    uint8_t execute(const MicroOp& op, uint16_t& branch_pc);
+    [[nodiscard]] bool is_batchable(MemAccess access) const;
+    [[nodiscard]] bool is_fusable(const MicroOp& op) const;
+
+    // Superinstruction running a sequence of handlers, defined in fusion.cpp
+    template <FusedStep First, FusedStep... Rest>
+    void fused();
+
+    // Feed backward branches to the idle loop detector, true if an idle loop is confirmed
+    bool observe_branch(uint16_t pc);
+
+    // Generated switch-based dispatch, returns the instruction cycles (see SWITCH_DISPATCH)
+    uint8_t dispatch(uint8_t opcode);
+    uint8_t dispatch_cb(uint8_t opcode);
+
     void schedule_interrupt();
 
     [[nodiscard]] bool handle_interrupts(Cycles cycles);
@@ -144,6 +390,7 @@ private:
         return common::utils::to_u16(msb, lsb);
     }
     void reset_flags() { registers_.f(0); }
+    void set_flags(const FlagResult& result) { registers_.f(result.flags()); }
 
     // ALU operations
     void add(uint8_t val, bool use_carry);
@@ -154,31 +401,51 @@ private:
     void cp(uint8_t val);
 
     // ========== CPU Instructions definitions ==========
-    // Generic unprefixed CPU instructions
-    void ld_r8_n8(Reg8Name r8);
-    void ld_r8_r8(Reg8Name dst, Reg8Name src);
-    void ld_r8_at_r16(Reg8Name dst, Reg16Name src);
-    void ld_at_r16_r8(Reg16Name dst, Reg8Name src);
-    void ld_r16_n16(Reg16Name r16);
-
-    void inc_r16(Reg16Name r16);
-    void dec_r16(Reg16Name r16);
-    void add_hl_r16(Reg16Name r16);
-
-    void inc_r8(Reg8Name r8);
-    void dec_r8(Reg8Name r8);
-
-    void add_a_r8(Reg8Name r8);
-    void adc_a_r8(Reg8Name r8);
-    void sub_a_r8(Reg8Name r8);
-    void sbc_a_r8(Reg8Name r8);
-    void and_a_r8(Reg8Name r8);
-    void xor_a_r8(Reg8Name r8);
-    void or_a_r8(Reg8Name r8);
-    void cp_a_r8(Reg8Name r8);
-
-    void pop_r16(Reg16Name r16);
-    void push_r16(Reg16Name r16);
+    // Generic unprefixed CPU instructions, specialized on their register operands
+    template <Reg8Name R8>
+    void ld_r8_n8();
+    template <Reg8Name Dst, Reg8Name Src>
+    void ld_r8_r8();
+    template <Reg8Name Dst, Reg16Name Src>
+    void ld_r8_at_r16();
+    template <Reg16Name Dst, Reg8Name Src>
+    void ld_at_r16_r8();
+    template <Reg16Name R16>
+    void ld_r16_n16();
+
+    template <Reg16Name R16>
+    void inc_r16();
+    template <Reg16Name R16>
+    void dec_r16();
+    template <Reg16Name R16>
+    void add_hl_r16();
+
+    template <Reg8Name R8>
+    void inc_r8();
+    template <Reg8Name R8>
+    void dec_r8();
+
+    template <Reg8Name R8>
+    void add_a_r8();
+    template <Reg8Name R8>
+    void adc_a_r8();
+    template <Reg8Name R8>
+    void sub_a_r8();
+    template <Reg8Name R8>
+    void sbc_a_r8();
+    template <Reg8Name R8>
+    void and_a_r8();
+    template <Reg8Name R8>
+    void xor_a_r8();
+    template <Reg8Name R8>
+    void or_a_r8();
+    template <Reg8Name R8>
+    void cp_a_r8();
+
+    template <Reg16Name R16>
+    void pop_r16();
+    template <Reg16Name R16>
+    void push_r16();
 
     void jp(uint16_t addr);
     void jp_z(uint16_t addr);
@@ -186,25 +453,40 @@ private:
     void jp_c(uint16_t addr);
     void jp_nc(uint16_t addr);
 
-    void rst(uint8_t vector);
+    template <uint8_t Vector>
+    void rst();
 
     static void illegal_opcode(uint8_t opcode);
 
-    // Generic CB-prefixed CPU instructions
-    void rlc_r8(Reg8Name r8);
-    void rrc_r8(Reg8Name r8);
-    void rl_r8(Reg8Name r8);
-    void rr_r8(Reg8Name r8);
-    void sla_r8(Reg8Name r8);
-    void sra_r8(Reg8Name r8);
-    void srl_r8(Reg8Name r8);
-    void swap_r8(Reg8Name r8);
-    void bit_b_r8(uint8_t bit, Reg8Name r8);
-    void bit_b_at_hl(uint8_t bit);
-    void res_b_r8(uint8_t bit, Reg8Name r8);
-    void res_b_at_hl(uint8_t bit);
-    void set_b_r8(uint8_t bit, Reg8Name r8);
-    void set_b_at_hl(uint8_t bit);
+    // Generic CB-prefixed CPU instructions, specialized on their bit and register operands
+    template <Reg8Name R8>
+    void rlc_r8();
+    template <Reg8Name R8>
+    void rrc_r8();
+    template <Reg8Name R8>
+    void rl_r8();
+    template <Reg8Name R8>
+    void rr_r8();
+    template <Reg8Name R8>
+    void sla_r8();
+    template <Reg8Name R8>
+    void sra_r8();
+    template <Reg8Name R8>
+    void srl_r8();
+    template <Reg8Name R8>
+    void swap_r8();
+    template <uint8_t Bit, Reg8Name R8>
+    void bit_b_r8();
+    template <uint8_t Bit>
+    void bit_b_at_hl();
+    template <uint8_t Bit, Reg8Name R8>
+    void res_b_r8();
+    template <uint8_t Bit>
+    void res_b_at_hl();
+    template <uint8_t Bit, Reg8Name R8>
+    void set_b_r8();
+    template <uint8_t Bit>
+    void set_b_at_hl();
 
     // Autogenerated CPU instructions definitions from Opcodes.json
     // clang-format off
@@ -213,8 +495,57 @@ private:
     // clang-format on
 
     friend class InstructionTable;
+    friend class FusionTable;
 };
 
+// tick() instantiations, defined in cpu.cpp
+extern template TCycle Cpu::tick<TickMode::Instruction, false, StepKind::Plain>();
+extern template TCycle Cpu::tick<TickMode::Instruction, false, StepKind::Batched>();
+extern template TCycle Cpu::tick<TickMode::Instruction, false, StepKind::Recorded>();
+extern template TCycle Cpu::tick<TickMode::CatchUp, false, StepKind::Plain>();
+extern template TCycle Cpu::tick<TickMode::CatchUp, false, StepKind::Recorded>();
+extern template TCycle Cpu::tick<TickMode::MCycle, false, StepKind::Plain>();
+extern template TCycle Cpu::tick<TickMode::MCycle, false, StepKind::Recorded>();
+extern template TCycle Cpu::tick<TickMode::MCycle, true, StepKind::Plain>();
+extern template TCycle Cpu::tick<TickMode::MCycle, true, StepKind::Recorded>();
+extern template TCycle Cpu::tick<TickMode::TCycle, false, StepKind::Plain>();
+extern template TCycle Cpu::tick<TickMode::TCycle, false, StepKind::Recorded>();
+extern template TCycle Cpu::tick<TickMode::TCycle, true, StepKind::Plain>();
+extern template TCycle Cpu::tick<TickMode::TCycle, true, StepKind::Recorded>();
+
+// ----- Interrupt checks -----
+
+inline bool InterruptHandler::should_service() const
+{
+    return cpu_.get_ime() && (pending() != 0);
+}
+
+// ----- Compile-time register accessors -----
+
+template <Reg8Name R>
+uint8_t Cpu::get_register() const
+{
+    return registers_.get<R>();
+}
+
+template <Reg16Name R>
+uint16_t Cpu::get_register() const
+{
+    return registers_.get<R>();
+}
+
+template <Reg8Name R>
+void Cpu::set_register(uint8_t value)
+{
+    registers_.set<R>(value);
+}
+
+template <Reg16Name R>
+void Cpu::set_register(uint16_t value)
+{
+    registers_.set<R>(value);
+}
+
 // ----- Stub disabling macros for implemented opcodes -----
 
 // ----------- Unprefixed instructions macros ----------
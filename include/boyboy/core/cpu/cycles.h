@@ -20,6 +20,7 @@ using MCycle = uint32_t;
 // Cycle duration constants
 constexpr TCycle FetchCycles = 4;             // Fetch duration in T-cycles
 constexpr TCycle InterruptServiceCycles = 20; // Interrupt service duration in T-cycles
+constexpr TCycle MaxBatchCycles = 64;         // Max T-cycles run in a batch (next events end it first)
 
 /**
  * @brief CPU ticking modes.
@@ -29,6 +30,18 @@ enum class TickMode : uint8_t {
     TCycle,      // Executes in T-cycle steps
     MCycle,      // Executes in M-cycle steps
     Instruction, // Executes a full instruction at a time
+    CatchUp,     // Executes a full instruction at a time, peripherals caught up on timed accesses
+};
+
+/**
+ * @brief Per-instruction work of a CPU tick besides executing it.
+ *
+ * Selected with the tick instantiation, so the stepping loop has no configuration branch.
+ */
+enum class StepKind : uint8_t {
+    Plain,    // One instruction per tick (or tick cycles in the M-cycle and T-cycle modes)
+    Batched,  // Cached blocks run in batches (TickMode::Instruction only)
+    Recorded, // Every instruction recorded by the trace and/or coverage, no batches nor fusion
 };
 
 /**
@@ -76,7 +89,7 @@ constexpr MCycle to_mcycles(TCycle cycles)
 /**
  * @brief Converts a TickMode to its Cycles analog.
  *
- * For TickMode::Instruction returns Cycles::TCycle.
+ * For TickMode::Instruction and TickMode::CatchUp returns Cycles::TCycle.
  *
  * @param mode TickMode to convert.
  * @return Cycles Converted Cycles.
@@ -86,6 +99,17 @@ constexpr Cycles tickmode_to_cycles(TickMode mode)
     return (mode == TickMode::MCycle) ? Cycles::MCycle : Cycles::TCycle;
 }
 
+/**
+ * @brief Checks whether a TickMode executes a full instruction per tick.
+ *
+ * @param mode TickMode to check.
+ * @return bool True for TickMode::Instruction and TickMode::CatchUp.
+ */
+constexpr bool is_instruction_stepped(TickMode mode)
+{
+    return mode == TickMode::Instruction || mode == TickMode::CatchUp;
+}
+
 // String conversions
 
 inline static const char* to_string(TickMode mode)
@@ -97,6 +121,8 @@ inline static const char* to_string(TickMode mode)
             return "M-Cycle";
         case TickMode::Instruction:
             return "Instruction";
+        case TickMode::CatchUp:
+            return "Catch-Up";
         default:
             return "Unknown";
     }
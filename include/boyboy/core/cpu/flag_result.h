@@ -0,0 +1,82 @@
+/**
+ * @file flag_result.h
+ * @brief Flag results of the BoyBoy CPU ALU operations.
+ *
+ * ALU operations describe their flag effects as a FlagResult (operation, operands and result)
+ * instead of updating Z/N/H/C one by one, so F is computed and written once per instruction.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "boyboy/core/cpu/registers.h"
+
+namespace boyboy::core::cpu {
+
+/**
+ * @brief Operation family that produced the flags.
+ */
+enum class FlagOp : uint8_t {
+    None,    // no flags
+    Add,     // ADD/ADC: Z 0 H C
+    Sub,     // SUB/SBC/CP: Z 1 H C
+    And,     // AND: Z 0 1 0
+    Logic,   // OR/XOR/SWAP: Z 0 0 0
+    Inc,     // INC r8: Z 0 H -
+    Dec,     // DEC r8: Z 1 H -
+    Shift,   // CB rotates and shifts: Z 0 0 C
+    RotateA, // RLCA/RRCA/RLA/RRA: 0 0 0 C
+};
+
+/**
+ * @brief Inputs needed to compute the flags of an operation.
+ */
+struct FlagResult {
+    FlagOp op{FlagOp::None};
+    uint8_t result{}; // operation result
+    uint8_t lhs{};    // left operand (Add/Sub)
+    uint8_t rhs{};    // right operand (Add/Sub)
+    uint8_t carry{};  // carry in (Add/Sub), previous carry (Inc/Dec) or carry out (shifts)
+
+    /**
+     * @brief Compute the F register value.
+     *
+     * @return uint8_t Flags in the F register layout (lower nibble always 0).
+     */
+    [[nodiscard]] constexpr uint8_t flags() const
+    {
+        auto bit = [](bool set, uint8_t flag) { return set ? flag : uint8_t{0}; };
+        uint8_t zero = bit(result == 0, Flag::Zero);
+
+        switch (op) {
+            case FlagOp::Add:
+                return zero | bit(((lhs & 0x0F) + (rhs & 0x0F) + carry) > 0x0F, Flag::HalfCarry) |
+                       bit((lhs + rhs + carry) > 0xFF, Flag::Carry);
+            case FlagOp::Sub:
+                return zero | Flag::Substract |
+                       bit((lhs & 0x0F) < ((rhs & 0x0F) + carry), Flag::HalfCarry) |
+                       bit(lhs < (rhs + carry), Flag::Carry);
+            case FlagOp::And:
+                return zero | Flag::HalfCarry;
+            case FlagOp::Logic:
+                return zero;
+            case FlagOp::Inc:
+                return zero | bit((result & 0x0F) == 0x00, Flag::HalfCarry) |
+                       bit(carry != 0, Flag::Carry);
+            case FlagOp::Dec:
+                return zero | Flag::Substract | bit((result & 0x0F) == 0x0F, Flag::HalfCarry) |
+                       bit(carry != 0, Flag::Carry);
+            case FlagOp::Shift:
+                return zero | bit(carry != 0, Flag::Carry);
+            case FlagOp::RotateA:
+                return bit(carry != 0, Flag::Carry);
+            default:
+                return 0;
+        }
+    }
+};
+
+} // namespace boyboy::core::cpu
@@ -0,0 +1,113 @@
+/**
+ * @file fusion.h
+ * @brief Superinstructions for hot opcode sequences of the BoyBoy CPU interpreter.
+ *
+ * Adjacent instructions that often run together, like `dec b; jr nz` or `ld a, [hl+]; ld [de], a`,
+ * can be executed by a single fused handler from the block cache. The fused set is data driven:
+ * the block cache records how often each opcode pair and triple runs (SequenceProfile), and
+ * scripts/generate_opcodes.py turns the top sequences of a profile into fused handlers.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "boyboy/core/cpu/instructions.h"
+
+namespace boyboy::core::cpu {
+
+// Opcode with its prefix, e.g. 0x012 for LD [DE], A or 0x17C for BIT 7, H
+using FusedOpcode = uint16_t;
+
+static constexpr FusedOpcode CBFusedFlag = 0x100;
+static constexpr FusedOpcode NoFusedOpcode = 0xFFFF;
+
+[[nodiscard]] constexpr FusedOpcode fused_opcode(InstructionType type, uint8_t opcode)
+{
+    return (type == InstructionType::CBPrefixed) ? (CBFusedFlag | opcode) : opcode;
+}
+
+/**
+ * @brief Instruction run by a fused handler.
+ */
+struct FusedStep {
+    OpcodeHandler handler;
+    bool prefixed; // CB-prefixed, skips two opcode bytes
+};
+
+/**
+ * @brief Fused handler for a sequence of opcodes.
+ */
+struct Superinstruction {
+    static constexpr size_t MaxOps = 3;
+
+    std::array<FusedOpcode, MaxOps> ops;
+    uint8_t length; // instructions in the sequence
+    OpcodeHandler handler;
+};
+
+class FusionTable {
+public:
+    /**
+     * @brief Find the longest superinstruction starting a sequence of opcodes.
+     *
+     * @param ops Opcodes starting at the instruction to fuse.
+     * @return const Superinstruction* Superinstruction or nullptr if none matches.
+     */
+    [[nodiscard]] static const Superinstruction* find(std::span<const FusedOpcode> ops);
+
+    // Autogenerated superinstructions (see generated/fused.inc)
+    static const std::vector<Superinstruction> Superinstructions;
+};
+
+/**
+ * @brief Execution counts of adjacent opcode pairs and triples.
+ */
+class SequenceProfile {
+public:
+    using Sequence = std::array<FusedOpcode, Superinstruction::MaxOps>; // NoFusedOpcode padded
+
+    struct Entry {
+        Sequence ops;
+        uint64_t count;
+    };
+
+    /**
+     * @brief Add the pairs and triples of a straight-line run of instructions.
+     *
+     * @param ops Opcodes in execution order.
+     * @param count Times the run was executed.
+     */
+    void add(std::span<const FusedOpcode> ops, uint64_t count);
+    void merge(const SequenceProfile& other);
+    void clear() { counts_.clear(); }
+
+    [[nodiscard]] size_t size() const { return counts_.size(); }
+    [[nodiscard]] uint64_t count(const Sequence& ops) const;
+
+    // Most executed sequences first
+    [[nodiscard]] std::vector<Entry> top(size_t max_entries) const;
+
+    /**
+     * @brief Export the profile as CSV, as read by scripts/generate_opcodes.py.
+     *
+     * One `count,sequence,mnemonics` row per sequence, e.g. `1200,05 20,"DEC B; JR NZ, e8"`.
+     *
+     * @param max_entries Max sequences to export, most executed first.
+     * @return std::string CSV text.
+     */
+    [[nodiscard]] std::string to_csv(size_t max_entries) const;
+
+private:
+    std::map<Sequence, uint64_t> counts_;
+};
+
+} // namespace boyboy::core::cpu
@@ -0,0 +1,136 @@
+/**
+ * @file idle_loop.h
+ * @brief Idle (busy-wait) loop detection for the BoyBoy CPU.
+ *
+ * Many ROMs poll a register instead of using HALT, e.g. `ldh a, [LY]; cp 144; jr nz, @-4`. Such a
+ * loop is idle when its body has no side effects and only reads memory that can't change until
+ * the next peripheral event: every iteration then starts from the same CPU state. The detector
+ * checks loop bodies statically and confirms them at runtime by comparing the registers between
+ * two consecutive iterations with no event in between, so the emulator can skip whole iterations
+ * up to the next event. Loops reading or running from pages trapped by watchpoints are never idle,
+ * every access there has to reach the watchpoints.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "boyboy/core/cpu/cycles.h"
+
+namespace boyboy::core::mmu {
+// Forward declaration
+class Mmu;
+} // namespace boyboy::core::mmu
+
+namespace boyboy::core::cpu {
+
+/**
+ * @brief Loop closed by a backward branch, as analyzed by the detector.
+ */
+struct IdleLoop {
+    uint16_t start{};  // loop head, branch target
+    uint16_t branch{}; // address of the backward branch
+    uint16_t bank{};   // ROM bank mapped when the loop was analyzed
+    TCycle period{};   // T-cycles per iteration, 0 if the loop can't be idle
+    bool indirect{};   // polls through a register pair, analysis depends on register values
+
+    [[nodiscard]] bool is_idle_candidate() const { return period != 0; }
+};
+
+class IdleLoopDetector {
+public:
+    // Registers compared between iterations: AF, BC, DE, HL and SP
+    using RegisterSnapshot = std::array<uint16_t, 5>;
+
+    struct Stats {
+        uint64_t detected{};       // idle loop confirmations
+        uint64_t skipped_cycles{}; // T-cycles skipped inside idle loops
+    };
+
+    static constexpr uint16_t MaxLoopBytes = 16;
+    static constexpr TCycle NoEvent = std::numeric_limits<TCycle>::max(); // see IoComponent
+
+    IdleLoopDetector(const mmu::Mmu& mmu) : mmu_(mmu) {}
+
+    void enable(bool enable);
+    [[nodiscard]] bool is_enabled() const { return enabled_; }
+
+    /**
+     * @brief Observe a taken branch to a lower or equal address.
+     *
+     * @param branch_pc Address of the branch instruction.
+     * @param target Branch target (current PC).
+     * @param regs Registers after the branch.
+     * @param cycles CPU cycle count after the branch.
+     * @return true if the loop is confirmed idle.
+     */
+    bool observe(
+        uint16_t branch_pc, uint16_t target, const RegisterSnapshot& regs, uint64_t cycles
+    );
+
+    /**
+     * @brief Whether the CPU sits at the head of the observed loop, right after its branch.
+     *
+     * @param pc Current program counter.
+     * @param cycles Current CPU cycle count, must match the last observation.
+     */
+    [[nodiscard]] bool is_at_head(uint16_t pc, uint64_t cycles) const
+    {
+        return analyzed_ && pc == loop_.start && cycles == last_cycles_ &&
+               map_generation_ == current_map_generation();
+    }
+
+    /**
+     * @brief Skip whole iterations of the confirmed idle loop, called at the loop head.
+     *
+     * The polled memory may have changed during the last iteration, so iterations are only
+     * skipped if the next event is the same one seen from the previous loop head.
+     *
+     * @param cycles_to_event T-cycles until the next peripheral event (NoEvent if none).
+     * @param max_cycles Max T-cycles to skip.
+     * @return TCycle T-cycles skipped (a multiple of the loop period).
+     */
+    TCycle skip(TCycle cycles_to_event, TCycle max_cycles);
+
+    // Forget the current loop
+    void reset();
+
+    [[nodiscard]] const IdleLoop& loop() const { return loop_; }
+    [[nodiscard]] const Stats& stats() const { return stats_; }
+    void reset_stats() { stats_ = {}; }
+
+    /**
+     * @brief Analyze the body of a loop.
+     *
+     * @param start Loop head.
+     * @param branch Address of the backward branch closing the loop.
+     * @param regs Registers at the loop head, used to resolve polled register pairs.
+     * @return IdleLoop Analyzed loop, with a zero period if it can't be idle.
+     */
+    [[nodiscard]] IdleLoop analyze(
+        uint16_t start, uint16_t branch, const RegisterSnapshot& regs
+    ) const;
+
+private:
+    const mmu::Mmu& mmu_;
+    bool enabled_{false};
+
+    IdleLoop loop_{};
+    bool analyzed_{false};
+    bool confirmed_{false};
+    RegisterSnapshot regs_{};
+    uint32_t map_generation_{}; // MMU map the loop was analyzed with, see Mmu::map_generation()
+    uint64_t last_cycles_{};
+    uint64_t next_event_{}; // absolute cycle of the next event, seen from the last loop head
+
+    Stats stats_{};
+
+    [[nodiscard]] uint16_t bank_at(uint16_t addr) const;
+    [[nodiscard]] uint32_t current_map_generation() const;
+};
+
+} // namespace boyboy::core::cpu
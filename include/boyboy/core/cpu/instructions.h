@@ -16,6 +16,8 @@ class Cpu;
 
 using OpcodeHandler = void (Cpu::*)();
 
+// Every field of an instruction, built from the InstructionTable arrays for decoding and
+// disassembly (the execution paths read the hot arrays directly)
 struct Instruction {
     std::string_view mnemonic;
     uint8_t length;
@@ -26,4 +28,4 @@ struct Instruction {
 
 enum class InstructionType : uint8_t { Unprefixed, CBPrefixed };
 
-} // namespace boyboy::core::cpu
\ No newline at end of file
+} // namespace boyboy::core::cpu
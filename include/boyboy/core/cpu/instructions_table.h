@@ -2,12 +2,19 @@
  * @file instructions_table.h
  * @brief CPU instructions table for the BoyBoy emulator.
  *
+ * The instruction metadata is split by field into constexpr arrays indexed by
+ * [InstructionType][opcode]: the handlers and cycle counts read on every executed instruction are
+ * kept together in the hot arrays, apart from the mnemonics and lengths only used to decode and
+ * disassemble.
+ *
  * @license GPLv3 (see LICENSE file)
  */
 
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <string_view>
 #include <utility>
 
 #include "boyboy/core/cpu/cpu.h"
@@ -19,29 +26,60 @@ class InstructionTable {
 public:
     static void execute(Cpu& cpu, OpcodeHandler exec_fn) { (cpu.*exec_fn)(); }
 
-    static const std::array<Instruction, 256>& get_instruction_table(InstructionType type)
+    // Hot metadata, every uint8_t opcode is a valid index, no need for bounds checking
+    [[nodiscard]] static constexpr OpcodeHandler handler(InstructionType type, uint8_t opcode)
+    {
+        return Handlers[std::to_underlying(type)][opcode];
+    }
+
+    [[nodiscard]] static constexpr uint8_t cycles(InstructionType type, uint8_t opcode)
+    {
+        return Cycles[std::to_underlying(type)][opcode];
+    }
+
+    [[nodiscard]] static constexpr uint8_t cycles_no_branch(InstructionType type, uint8_t opcode)
     {
-        return (type == InstructionType::Unprefixed) ? Opcodes : CBOpcodes;
+        return CyclesNoBranch[std::to_underlying(type)][opcode];
     }
 
-    static const Instruction& get_instruction(InstructionType type, uint8_t opcode)
+    // Cold metadata
+    [[nodiscard]] static constexpr std::string_view mnemonic(InstructionType type, uint8_t opcode)
     {
-        const auto& table = get_instruction_table(type);
-        return table.at(opcode);
+        return Mnemonics[std::to_underlying(type)][opcode];
     }
 
-    static const Instruction& get_instruction(Opcode opcode)
+    [[nodiscard]] static constexpr uint8_t length(InstructionType type, uint8_t opcode)
+    {
+        return Lengths[std::to_underlying(type)][opcode];
+    }
+
+    // All the fields of an instruction, for decoding and disassembly
+    [[nodiscard]] static constexpr Instruction get_instruction(InstructionType type, uint8_t opcode)
+    {
+        return {
+            .mnemonic = mnemonic(type, opcode),
+            .length = length(type, opcode),
+            .cycles = cycles(type, opcode),
+            .cycles_no_branch = cycles_no_branch(type, opcode),
+            .execute = handler(type, opcode),
+        };
+    }
+
+    [[nodiscard]] static constexpr Instruction get_instruction(Opcode opcode)
     {
         return get_instruction(InstructionType::Unprefixed, std::to_underlying(opcode));
     }
 
-    static const Instruction& get_instruction(CBOpcode opcode)
+    [[nodiscard]] static constexpr Instruction get_instruction(CBOpcode opcode)
     {
         return get_instruction(InstructionType::CBPrefixed, std::to_underlying(opcode));
     }
 
-    static const std::array<Instruction, 256> Opcodes;
-    static const std::array<Instruction, 256> CBOpcodes;
+    // Autogenerated hot tables from Opcodes.json: Handlers, Cycles, CyclesNoBranch
+#include "boyboy/core/cpu/generated/instruction_tables.inc"
+
+    // Autogenerated cold tables from Opcodes.json: Mnemonics, Lengths
+#include "boyboy/core/cpu/generated/instruction_metadata.inc"
 };
 
-} // namespace boyboy::core::cpu
\ No newline at end of file
+} // namespace boyboy::core::cpu
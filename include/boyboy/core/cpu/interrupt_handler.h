@@ -24,7 +24,7 @@ class Cpu;
 
 class InterruptHandler {
 public:
-    InterruptHandler(Cpu& cpu, mmu::Mmu& mmu) : cpu_(cpu), mmu_(mmu) {}
+    InterruptHandler(Cpu& cpu, mmu::Mmu& mmu);
     ~InterruptHandler() = default;
 
     // delete move and copy
@@ -39,17 +39,17 @@ public:
     void enable(Interrupt interrupt);
     [[nodiscard]] bool is_requested(Interrupt interrupt) const;
     [[nodiscard]] bool is_enabled(Interrupt interrupt) const;
-    [[nodiscard]] uint8_t pending() const;
+    [[nodiscard]] uint8_t pending() const { return regs_.pending(); }
     [[nodiscard]] bool is_servicing() const { return cycles_left_ > 0; }
-    [[nodiscard]] bool should_service() const;
-    [[nodiscard]] bool should_wake_up() const;
+    [[nodiscard]] inline bool should_service() const; // defined in cpu.h
+    [[nodiscard]] bool should_wake_up() const { return pending() != 0; }
 
-    [[nodiscard]] uint8_t get_ie() const;
-    [[nodiscard]] uint8_t get_if() const;
+    [[nodiscard]] uint8_t get_ie() const { return regs_.ie(); }
+    [[nodiscard]] uint8_t get_if() const { return regs_.iflag(); }
 
 private:
     Cpu& cpu_;
-    mmu::Mmu& mmu_;
+    InterruptRegisters& regs_; // owned by the I/O, kept in sync on IE/IF writes
 
     // Interrupt service status
     TCycle cycles_left_{};
@@ -58,9 +58,6 @@ private:
     void service_interrupt(Interrupt interrupt);
     void clear_interrupt(Interrupt interrupt);
 
-    void set_ie(uint8_t value);
-    void set_if(uint8_t value);
-
     [[nodiscard]] TCycle service_cycles() const;
 };
 
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <array>
+#include <bit>
 #include <cstdint>
 #include <functional>
 #include <utility>
@@ -53,17 +54,60 @@ struct InterruptVectors {
 
     static constexpr InterruptVector get_vector(Interrupt interrupt)
     {
-        int bit_pos = 0;
-        auto interrupt_mask = std::to_underlying(interrupt);
-        while ((interrupt_mask & 1) == 0) {
-            interrupt_mask >>= 1;
-            bit_pos++;
-        }
-
-        return Vectors.at(bit_pos);
+        return Vectors.at(std::countr_zero(std::to_underlying(interrupt)));
     }
 };
 
+/**
+ * @brief IE and IF registers with their pending mask (IE & IF) cached.
+ *
+ * The mask is only updated when a register is written or an interrupt requested, so the CPU can
+ * check for pending interrupts with a single load and pick the highest priority one (lowest bit)
+ * with std::countr_zero.
+ */
+class InterruptRegisters {
+public:
+    static constexpr uint8_t Mask = 0x1F; // bits backed by an interrupt source
+
+    [[nodiscard]] uint8_t ie() const { return ie_; }
+    [[nodiscard]] uint8_t iflag() const { return if_; }
+    [[nodiscard]] uint8_t pending() const { return pending_; }
+
+    void set_ie(uint8_t value)
+    {
+        ie_ = value;
+        update();
+    }
+    void set_if(uint8_t value)
+    {
+        if_ = value;
+        update();
+    }
+    void request(Interrupt interrupt)
+    {
+        if_ |= std::to_underlying(interrupt);
+        update();
+    }
+    void clear(Interrupt interrupt)
+    {
+        if_ &= ~std::to_underlying(interrupt);
+        update();
+    }
+
+    // Highest priority interrupt of a non-empty mask
+    [[nodiscard]] static Interrupt highest_priority(uint8_t mask)
+    {
+        return static_cast<Interrupt>(1 << std::countr_zero(mask));
+    }
+
+private:
+    uint8_t ie_{};
+    uint8_t if_{};
+    uint8_t pending_{};
+
+    void update() { pending_ = ie_ & if_ & Mask; }
+};
+
 // Interrupt request callback
 using InterruptRequestCallback = std::function<void(Interrupt)>;
 
@@ -0,0 +1,107 @@
+/**
+ * @file microcode.h
+ * @brief M-cycle microprograms for the BoyBoy CPU.
+ *
+ * The M-cycle and T-cycle tick modes used to run an instruction handler when its last M-cycle
+ * ended, so every memory access of the instruction happened on that M-cycle. With microcode
+ * enabled each instruction follows its microprogram instead, one step per M-cycle after the
+ * opcode fetch: operand fetches and memory reads are latched on their own M-cycle, the handler
+ * runs on the latched values and its writes are queued until the M-cycle they happen on.
+ *
+ * Microprograms are generated from Opcodes.json by scripts/generate_opcodes.py --microcode.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "boyboy/core/cpu/instructions.h"
+
+namespace boyboy::core::cpu {
+
+/**
+ * @brief Action of a microprogram step.
+ */
+enum class MicroAction : uint8_t {
+    Fetch,    // latch the next operand byte at PC
+    Read,     // latch a memory read
+    Write,    // perform the next write queued by the handler
+    Internal, // no bus activity
+    Execute,  // run the handler within the M-cycle of the previous step, doesn't take one
+};
+
+/**
+ * @brief Address of a Read or Write step.
+ */
+enum class MicroAddr : uint8_t {
+    None,
+    BC,
+    DE,
+    HL,
+    SP,  // SP, then SP+1 (pops)
+    A16, // latched a16 operand
+    A8,  // 0xFF00 + latched a8 operand
+    C,   // 0xFF00 + C
+};
+
+struct MicroStep {
+    MicroAction action;
+    MicroAddr addr{MicroAddr::None};
+};
+
+/**
+ * @brief Steps of an instruction after its opcode fetch(es), taken branch steps last.
+ *
+ * Single M-cycle instructions and instructions without a microprogram have no steps, they run
+ * when their last M-cycle ends.
+ */
+struct Microprogram {
+    static constexpr size_t MaxSteps = 6;
+
+    std::array<MicroStep, MaxSteps> steps{};
+    uint8_t length{0};   // steps in the program
+    uint8_t mcycles{0};  // M-cycles of the steps run when not branching
+    uint8_t operands{0}; // operand bytes of the instruction, latched by the Execute step
+};
+
+/**
+ * @brief Values latched by the steps of the instruction being executed.
+ */
+struct MicroLatches {
+    static constexpr size_t MaxAccesses = 2;
+
+    const Microprogram* program{nullptr};
+    uint8_t step{0};
+    uint8_t skip{0}; // M-cycles before the first step (fetch/execute overlap)
+    bool executed{false};
+
+    std::array<uint8_t, 2> operands{};
+    uint8_t fetched{0};
+
+    std::array<uint16_t, MaxAccesses> read_addrs{};
+    std::array<uint8_t, MaxAccesses> read_values{};
+    uint8_t reads{0};
+    uint8_t next_read{0};
+
+    std::array<uint16_t, MaxAccesses> write_addrs{};
+    std::array<uint8_t, MaxAccesses> write_values{};
+    uint8_t writes{0};
+    uint8_t next_write{0};
+};
+
+class MicrocodeTable {
+public:
+    static const Microprogram& get(InstructionType type, uint8_t opcode)
+    {
+        return (type == InstructionType::Unprefixed) ? Opcodes[opcode] : CBOpcodes[opcode];
+    }
+
+    static const std::array<Microprogram, 256> Opcodes;
+    static const std::array<Microprogram, 256> CBOpcodes;
+};
+
+} // namespace boyboy::core::cpu
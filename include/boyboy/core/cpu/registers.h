@@ -6,11 +6,14 @@
  */
 #pragma once
 
-#include <bit>
+#include <array>
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
 #include <ostream>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 namespace boyboy::core::cpu {
 
@@ -94,133 +97,146 @@ inline std::ostream& operator<<(std::ostream& os, RegName r)
     return os << to_string(r);
 }
 
-class Register16 {
-    static_assert(
-        std::endian::native == std::endian::little,
-        "This implementation assumes little-endian architecture"
-    );
+/**
+ * @brief Flat CPU register file.
+ *
+ * Registers live in a plain byte array, with register pairs stored low byte first, so 8-bit
+ * halves and 16-bit pairs are found through constexpr index maps and can be indexed directly by
+ * name, at runtime (debugger, tests) or at compile time (generic instruction handlers):
+ *
+ *   index:  0  1  2  3  4  5  6  7  8  9  10 11
+ *   byte:   F  A  C  B  E  D  L  H  SP    PC
+ *
+ * Pairs are composed from their bytes, so the layout doesn't depend on the host endianness.
+ * The lower nibble of F always reads as 0, it is masked on every write.
+ */
+struct Registers {
+    static constexpr size_t Size = 12;
+    static constexpr uint8_t FlagsMask = 0xF0;
 
-public:
-    constexpr Register16(uint16_t val = 0) : value_(val) {}
+    std::array<uint8_t, Size> bytes{};
 
-    // 16 bit access
-    constexpr operator uint16_t() const { return value_; }
-    constexpr Register16& operator=(uint16_t new_val)
+    // Byte index of an 8-bit register
+    [[nodiscard]] static constexpr size_t index(Reg8Name reg)
     {
-        value_ = new_val;
-        return *this;
+        constexpr std::array<size_t, 8> Indices = {1, 0, 3, 2, 5, 4, 7, 6}; // A F B C D E H L
+        return Indices[std::to_underlying(reg)];
     }
 
-    // High byte access (le: upper 8 bits)
-    [[nodiscard]] constexpr uint8_t high() const { return value_ >> 8; }
-    constexpr void high(uint8_t h) { value_ = (value_ & 0x00FF) | (static_cast<uint16_t>(h) << 8); }
-
-    // Low byte access (le: lower 8 bits)
-    [[nodiscard]] constexpr uint8_t low() const { return value_ & 0xFF; }
-    constexpr void low(uint8_t l) { value_ = (value_ & 0xFF00) | l; }
+    // Byte index of the low half of a 16-bit register
+    [[nodiscard]] static constexpr size_t index(Reg16Name reg)
+    {
+        return size_t{2} * std::to_underlying(reg);
+    }
 
-    // Postfix operations
-    constexpr Register16 operator++(int)
+    // Runtime indexed access
+    [[nodiscard]] constexpr uint8_t get(Reg8Name reg) const { return bytes[index(reg)]; }
+    constexpr void set(Reg8Name reg, uint8_t val)
     {
-        Register16 old = *this;
-        ++value_;
-        return old;
+        bytes[index(reg)] = (reg == Reg8Name::F) ? (val & FlagsMask) : val;
     }
-    constexpr Register16 operator--(int)
+    [[nodiscard]] constexpr uint16_t get(Reg16Name reg) const { return load(index(reg)); }
+    constexpr void set(Reg16Name reg, uint16_t val)
     {
-        Register16 old = *this;
-        --value_;
-        return old;
+        store(index(reg), (reg == Reg16Name::AF) ? (val & (0xFF00 | FlagsMask)) : val);
     }
 
-    // Prefix operations
-    constexpr Register16& operator++()
+    // Compile-time indexed access
+    template <Reg8Name R>
+    [[nodiscard]] constexpr uint8_t get() const
     {
-        ++value_;
-        return *this;
+        return bytes[index(R)];
     }
-    constexpr Register16& operator--()
+    template <Reg8Name R>
+    constexpr void set(uint8_t val)
     {
-        --value_;
-        return *this;
+        if constexpr (R == Reg8Name::F) {
+            val &= FlagsMask;
+        }
+        bytes[index(R)] = val;
     }
-
-protected:
-    [[nodiscard]] constexpr uint16_t get_value() const { return value_; }
-    constexpr void set_value(uint16_t val) { value_ = val; }
-
-private:
-    uint16_t value_;
-};
-
-// Special handling for AF (Accumulator & Flags) register (F uses only upper 4 bits)
-class AFRegister : public Register16 {
-public:
-    constexpr AFRegister(uint16_t val = 0) : Register16(val & 0xFFF0) {}
-
-    constexpr AFRegister& operator=(uint16_t new_val)
+    template <Reg16Name R>
+    [[nodiscard]] constexpr uint16_t get() const
     {
-        set_value(new_val & 0xFFF0);
-        return *this;
+        return load(index(R));
+    }
+    template <Reg16Name R>
+    constexpr void set(uint16_t val)
+    {
+        if constexpr (R == Reg16Name::AF) {
+            val &= 0xFF00 | FlagsMask;
+        }
+        store(index(R), val);
     }
 
-    // Add const version of low() to prevent hiding the base class method
-    using Register16::low;
+    // 8-bit register accessors for convenience
+    [[nodiscard]] constexpr uint8_t a() const { return get<Reg8Name::A>(); }
+    constexpr void a(uint8_t val) { set<Reg8Name::A>(val); }
 
-    // Override the non-const version to mask the lower 4 bits
-    constexpr void low(uint8_t l) { set_value((get_value() & 0xFF00) | (l & 0xF0)); }
+    [[nodiscard]] constexpr uint8_t f() const { return get<Reg8Name::F>(); }
+    constexpr void f(uint8_t val) { set<Reg8Name::F>(val); }
 
-    // Flag access methods
-    [[nodiscard]] constexpr bool zero_flag() const { return get_flag(Flag::Zero); }
-    constexpr void zero_flag(bool set) { set_flag(Flag::Zero, set); }
+    [[nodiscard]] constexpr uint8_t b() const { return get<Reg8Name::B>(); }
+    constexpr void b(uint8_t val) { set<Reg8Name::B>(val); }
 
-    [[nodiscard]] constexpr bool carry_flag() const { return get_flag(Flag::Carry); }
-    constexpr void carry_flag(bool set) { set_flag(Flag::Carry, set); }
+    [[nodiscard]] constexpr uint8_t c() const { return get<Reg8Name::C>(); }
+    constexpr void c(uint8_t val) { set<Reg8Name::C>(val); }
 
-    [[nodiscard]] constexpr bool substract_flag() const { return get_flag(Flag::Substract); }
-    constexpr void substract_flag(bool set) { set_flag(Flag::Substract, set); }
+    [[nodiscard]] constexpr uint8_t d() const { return get<Reg8Name::D>(); }
+    constexpr void d(uint8_t val) { set<Reg8Name::D>(val); }
 
-    [[nodiscard]] constexpr bool half_carry_flag() const { return get_flag(Flag::HalfCarry); }
-    constexpr void half_carry_flag(bool set) { set_flag(Flag::HalfCarry, set); }
+    [[nodiscard]] constexpr uint8_t e() const { return get<Reg8Name::E>(); }
+    constexpr void e(uint8_t val) { set<Reg8Name::E>(val); }
 
-    // private:
-    // Generic flag access
-    [[nodiscard]] constexpr bool get_flag(uint8_t flag) const { return (get_value() & flag) != 0; }
-    constexpr void set_flag(uint8_t flag, bool set)
-    {
-        uint8_t f = low();
-        low(set ? (f | flag) : (f & ~flag));
-    }
-};
+    [[nodiscard]] constexpr uint8_t h() const { return get<Reg8Name::H>(); }
+    constexpr void h(uint8_t val) { set<Reg8Name::H>(val); }
 
-struct Registers {
-    AFRegister af;
-    Register16 bc, de, hl, sp, pc;
+    [[nodiscard]] constexpr uint8_t l() const { return get<Reg8Name::L>(); }
+    constexpr void l(uint8_t val) { set<Reg8Name::L>(val); }
 
-    // 8-bit register accessors for convenience
-    [[nodiscard]] uint8_t a() const { return af.high(); }
-    void a(uint8_t val) { af.high(val); }
+    // 16-bit register accessors for convenience
+    [[nodiscard]] constexpr uint16_t af() const { return get<Reg16Name::AF>(); }
+    constexpr void af(uint16_t val) { set<Reg16Name::AF>(val); }
 
-    [[nodiscard]] uint8_t f() const { return af.low(); }
-    void f(uint8_t val) { af.low(val); }
+    [[nodiscard]] constexpr uint16_t bc() const { return get<Reg16Name::BC>(); }
+    constexpr void bc(uint16_t val) { set<Reg16Name::BC>(val); }
 
-    [[nodiscard]] uint8_t b() const { return bc.high(); }
-    void b(uint8_t val) { bc.high(val); }
+    [[nodiscard]] constexpr uint16_t de() const { return get<Reg16Name::DE>(); }
+    constexpr void de(uint16_t val) { set<Reg16Name::DE>(val); }
 
-    [[nodiscard]] uint8_t c() const { return bc.low(); }
-    void c(uint8_t val) { bc.low(val); }
+    [[nodiscard]] constexpr uint16_t hl() const { return get<Reg16Name::HL>(); }
+    constexpr void hl(uint16_t val) { set<Reg16Name::HL>(val); }
 
-    [[nodiscard]] uint8_t d() const { return de.high(); }
-    void d(uint8_t val) { de.high(val); }
+    [[nodiscard]] constexpr uint16_t sp() const { return get<Reg16Name::SP>(); }
+    constexpr void sp(uint16_t val) { set<Reg16Name::SP>(val); }
 
-    [[nodiscard]] uint8_t e() const { return de.low(); }
-    void e(uint8_t val) { de.low(val); }
+    [[nodiscard]] constexpr uint16_t pc() const { return get<Reg16Name::PC>(); }
+    constexpr void pc(uint16_t val) { set<Reg16Name::PC>(val); }
 
-    [[nodiscard]] uint8_t h() const { return hl.high(); }
-    void h(uint8_t val) { hl.high(val); }
+    // Advance PC, returning its previous value
+    constexpr uint16_t advance_pc(uint16_t count = 1)
+    {
+        uint16_t old = pc();
+        pc(old + count);
+        return old;
+    }
 
-    [[nodiscard]] uint8_t l() const { return hl.low(); }
-    void l(uint8_t val) { hl.low(val); }
+    // Flag access
+    [[nodiscard]] constexpr bool flag(uint8_t mask) const { return (f() & mask) != 0; }
+    constexpr void flag(uint8_t mask, bool set) { f(set ? (f() | mask) : (f() & ~mask)); }
+
+private:
+    [[nodiscard]] constexpr uint16_t load(size_t idx) const
+    {
+        return static_cast<uint16_t>(bytes[idx] | (bytes[idx + 1] << 8));
+    }
+    constexpr void store(size_t idx, uint16_t val)
+    {
+        bytes[idx] = static_cast<uint8_t>(val & 0xFF);
+        bytes[idx + 1] = static_cast<uint8_t>(val >> 8);
+    }
 };
+static_assert(sizeof(Registers) == Registers::Size);
+static_assert(std::is_trivially_copyable_v<Registers>);
 
 } // namespace boyboy::core::cpu
\ No newline at end of file
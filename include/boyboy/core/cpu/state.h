@@ -7,10 +7,13 @@
 
 #pragma once
 
+#include <cstdint>
+#include <type_traits>
 #include <utility>
 
 #include "boyboy/core/cpu/cycles.h"
 #include "boyboy/core/cpu/instructions.h"
+#include "boyboy/core/cpu/registers.h"
 
 namespace boyboy::core::cpu {
 
@@ -58,7 +61,7 @@ struct ExecutionState {
     Stage stage{Stage::Fetch};
     uint8_t fetched{0};
     TCycle cycles_left{FetchCycles};
-    const Instruction* instr = nullptr;
+    InstructionType instr_type{InstructionType::Unprefixed};
     bool branching{false};
 
     void init()
@@ -66,7 +69,7 @@ struct ExecutionState {
         stage = Stage::Fetch;
         cycles_left = FetchCycles;
         fetched = 0;
-        instr = nullptr;
+        instr_type = InstructionType::Unprefixed;
         branching = false;
     }
 
@@ -75,4 +78,19 @@ struct ExecutionState {
     [[nodiscard]] bool has_stage(Stage flag) const { return has_flag(stage, flag); }
 };
 
+/**
+ * @brief Architectural CPU state, trivially copyable for cheap snapshots (see Cpu::snapshot).
+ */
+struct CpuState {
+    Registers registers;
+    ExecutionState exec;
+    uint64_t cycles{0};
+    uint8_t ime_scheduled{0};
+    bool ime{false};
+    bool halted{false};
+    bool halt_bug{false};
+    bool branch_taken{false};
+};
+static_assert(std::is_trivially_copyable_v<CpuState>);
+
 } // namespace boyboy::core::cpu
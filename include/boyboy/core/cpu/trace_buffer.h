@@ -0,0 +1,170 @@
+/**
+ * @file trace_buffer.h
+ * @brief Binary execution trace ring buffer for the BoyBoy CPU.
+ *
+ * When enabled, the CPU stores a fixed-size record (PC, bytes at PC, registers, cycles and ROM
+ * bank) for every instruction it starts, overwriting the oldest ones. The buffer can be flushed to
+ * a compact binary file at any time, including from a signal handler on crash, and decoded offline
+ * into Gameboy Doctor compatible text with `boyboy trace`.
+ *
+ * Trace file format (host endianness):
+ *   TraceFileHeader, followed by `count` TraceRecord entries, oldest first.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "boyboy/common/files/errors.h"
+
+namespace boyboy::core::cpu {
+
+/**
+ * @brief CPU state at the start of an instruction.
+ */
+struct TraceRecord {
+    static constexpr uint8_t ImeFlag = 0x01;
+
+    uint64_t cycles;
+    uint16_t pc;
+    uint16_t sp;
+    uint16_t af;
+    uint16_t bc;
+    uint16_t de;
+    uint16_t hl;
+    uint16_t bank;               // ROM bank mapped at 0x4000-0x7FFF if PC is there, 0 otherwise
+    std::array<uint8_t, 4> mem;  // bytes at PC
+    uint8_t state;               // ImeFlag
+    std::array<uint8_t, 5> pad;  // keeps records 32 bytes long in files
+};
+static_assert(sizeof(TraceRecord) == 32);
+static_assert(std::is_trivially_copyable_v<TraceRecord>);
+
+/**
+ * @brief Header of a trace file.
+ */
+struct TraceFileHeader {
+    static constexpr std::array<char, 8> Magic = {'B', 'B', 'T', 'R', 'A', 'C', 'E', '\0'};
+    static constexpr uint16_t CurrentVersion = 1;
+
+    std::array<char, 8> magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+};
+static_assert(sizeof(TraceFileHeader) == 16);
+static_assert(std::is_trivially_copyable_v<TraceFileHeader>);
+
+class TraceBuffer {
+public:
+    static constexpr size_t DefaultCapacity = size_t{1} << 16; // records, 2 MiB
+
+    /**
+     * @brief Construct a trace buffer, its memory is allocated when first enabled.
+     * @param capacity Max records kept, rounded up to a power of two.
+     */
+    explicit TraceBuffer(size_t capacity = DefaultCapacity);
+    ~TraceBuffer();
+
+    TraceBuffer(const TraceBuffer&) = delete;
+    TraceBuffer& operator=(const TraceBuffer&) = delete;
+    TraceBuffer(TraceBuffer&&) = delete;
+    TraceBuffer& operator=(TraceBuffer&&) = delete;
+
+    void enable(bool enable);
+    [[nodiscard]] bool is_enabled() const { return enabled_; }
+
+    /**
+     * @brief Store a record, overwriting the oldest one if full.
+     *
+     * Single producer: readers on other threads or signal handlers never block the CPU, they
+     * might only see the record being overwritten torn.
+     *
+     * @param record Record to store.
+     */
+    void push(const TraceRecord& record)
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        records_[head & mask_] = record;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    [[nodiscard]] size_t capacity() const { return mask_ + 1; }
+    [[nodiscard]] size_t size() const;
+    void clear() { head_.store(0, std::memory_order_release); }
+
+    // Records currently held, oldest first
+    [[nodiscard]] std::vector<TraceRecord> snapshot() const;
+
+    /**
+     * @brief Write the records to a trace file.
+     *
+     * @param path Trace file path.
+     * @return std::expected<void, common::files::FileError> Nothing or FileError on error.
+     */
+    [[nodiscard]] std::expected<void, common::files::FileError> flush(
+        const std::filesystem::path& path
+    ) const;
+
+    /**
+     * @brief Flush the buffer to a file when the process crashes or receives SIGUSR1.
+     *
+     * Crashes (SIGSEGV, SIGBUS, SIGILL, SIGFPE and SIGABRT) flush and then re-raise the signal
+     * with its default action, SIGUSR1 flushes on demand and lets the emulator run. Only one
+     * buffer can be installed at a time.
+     *
+     * @param path Trace file path.
+     */
+    void install_signal_handlers(const std::filesystem::path& path) const;
+    static void remove_signal_handlers();
+
+    /**
+     * @brief Read a trace file.
+     *
+     * @param path Trace file path.
+     * @return std::expected<std::vector<TraceRecord>, common::files::FileError> Records, oldest
+     * first, or FileError on error.
+     */
+    [[nodiscard]] static std::expected<std::vector<TraceRecord>, common::files::FileError> load(
+        const std::filesystem::path& path
+    );
+
+    /**
+     * @brief Format a record as a Gameboy Doctor log line.
+     *
+     * e.g. `A:01 F:B0 B:00 C:13 D:00 E:D8 H:01 L:4D SP:FFFE PC:0100 PCMEM:00,C3,13,02`
+     *
+     * @param record Record to format.
+     * @return std::string Log line, without line break.
+     */
+    [[nodiscard]] static std::string to_doctor(const TraceRecord& record);
+
+private:
+    bool enabled_{false};
+    size_t mask_;
+    std::vector<TraceRecord> records_;
+    std::atomic<uint64_t> head_{0}; // records pushed since the last clear
+
+    // Records held for a given head, none until the buffer is allocated
+    [[nodiscard]] uint64_t held(uint64_t head) const
+    {
+        return records_.empty() ? 0 : std::min<uint64_t>(head, capacity());
+    }
+
+    // Async-signal-safe flush to an open file descriptor
+    bool write_to(int fd) const;
+    static void on_signal(int signal);
+};
+
+} // namespace boyboy::core::cpu
@@ -26,9 +26,16 @@ namespace boyboy::core::display {
 
 static constexpr int DefaultScale = 4;
 
+// Emulator controls bound to keys
+enum class Hotkey : uint8_t {
+    Pause, // P: pause or resume
+    Step,  // N: run a single CPU tick while paused
+};
+
 class Display {
 public:
     using ButtonCallback = std::function<void(io::Button button, bool pressed)>;
+    using HotkeyCallback = std::function<void(Hotkey hotkey)>;
 
     Display(int scale = DefaultScale) : scale_(scale) {}
 
@@ -46,8 +53,9 @@ public:
     void set_scale(int scale) { scale_ = scale; }
     void set_vsync(bool vsync) { vsync_ = vsync; }
 
-    // Button event callback
+    // Button and hotkey event callbacks
     void set_button_cb(ButtonCallback cb) { button_cb_ = std::move(cb); }
+    void set_hotkey_cb(HotkeyCallback cb) { hotkey_cb_ = std::move(cb); }
 
 private:
     int width_ = ppu::LCDWidth;
@@ -56,6 +64,7 @@ private:
     bool vsync_ = true;
 
     ButtonCallback button_cb_;
+    HotkeyCallback hotkey_cb_;
 
     SDL_Window* window_ = nullptr;
     SDL_GLContext gl_context_ = nullptr;
@@ -63,6 +72,7 @@ private:
     GLuint shader_program_{};
 
     void handle_key_event(const SDL_Event& event, bool pressed);
+    void handle_hotkey_event(const SDL_Event& event);
 
     void init_opengl();
 };
@@ -7,14 +7,22 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <memory>
+#include <optional>
 #include <string>
 
+#include "boyboy/core/mmu/watchpoints.h"
+
 // Core components forward declarations
 namespace boyboy::core {
 namespace cpu {
 class Cpu;
-}
+enum class TickMode : uint8_t;
+enum class StepKind : uint8_t;
+} // namespace cpu
 namespace mmu {
 class Mmu;
 }
@@ -31,7 +39,8 @@ enum class Button : uint8_t;
 } // namespace io
 namespace display {
 class Display;
-}
+enum class Hotkey : uint8_t;
+} // namespace display
 namespace cartridge {
 class Cartridge;
 }
@@ -70,8 +79,36 @@ public:
     // Configuration
     void apply_config(const common::config::Config& config);
 
-    // Button event handler
+    // Debugging
+    void dump_trace() const;    // writes the CPU trace next to the ROM saves (debug.trace only)
+    void dump_coverage() const; // writes the coverage file and summary (debug.coverage only)
+
+    // Watchpoints (see mmu/watchpoints.h): a hit breaks out of the frame and pauses the emulator
+    size_t add_watchpoint(uint16_t start, uint16_t end, mmu::WatchKind kinds);
+    bool remove_watchpoint(size_t id);
+    void set_watch_callback(mmu::Watchpoints::Callback callback); // decides which hits break
+    [[nodiscard]] const std::optional<mmu::WatchHit>& watch_hit() const;
+
+    // Pause control: run() keeps polling events but doesn't emulate while paused
+    [[nodiscard]] bool is_paused() const { return paused_; }
+    void pause() { paused_ = true; }
+    void resume(); // drops the pending hit, the frame carries on where it broke
+    void step();   // runs a single CPU tick (a whole batch with block batching) and stays paused
+
+    /**
+     * @brief Emulate frames without the display until a watchpoint breaks.
+     *
+     * Resumes first, so a frame left unfinished by a previous break is completed and counts as
+     * one of the frames.
+     *
+     * @param max_frames Frames to emulate at most.
+     * @return std::optional<mmu::WatchHit> Hit that paused the emulator, if any.
+     */
+    std::optional<mmu::WatchHit> run_until_watch(size_t max_frames);
+
+    // Button and hotkey event handlers
     void on_button_event(io::Button button, bool pressed);
+    void on_hotkey(display::Hotkey hotkey);
 
 private:
     // System components
@@ -90,15 +127,58 @@ private:
     bool running_ = false;
     bool started_ = false;
     bool frame_rate_limited_ = true;
+    bool paused_ = false; // on a watchpoint break, or by the user
     int speed_ = 1;
 
     // Statistics
     uint64_t instruction_count_ = 0;
     uint64_t cycle_count_ = 0;
 
+    // Emulation loop specialized on the configuration, selected by apply_config()
+    using EmulateFrameFn = void (Emulator::*)();
+    EmulateFrameFn emulate_frame_fn_;
+    bool instrumented_ = false;
+    void select_emulate_frame_fn();
+
     // Emulation methods
-    void emulate_frame();
+    void emulate_frame() { (this->*emulate_frame_fn_)(); }
+    template <
+        cpu::TickMode Mode,
+        bool FeOverlap,
+        cpu::StepKind Step,
+        bool Instrumented,
+        bool Watched>
+    void emulate_frame(); // Watched loops break on watchpoint hits
+    template <cpu::TickMode Mode>
+    static EmulateFrameFn select_emulate_frame(
+        bool fe_overlap, cpu::StepKind step, bool instrumented, bool watched
+    );
+    template <cpu::TickMode Mode, bool FeOverlap>
+    static EmulateFrameFn select_emulate_frame(
+        cpu::StepKind step, bool instrumented, bool watched
+    );
+    template <cpu::TickMode Mode, bool FeOverlap, cpu::StepKind Step>
+    static EmulateFrameFn select_emulate_frame(bool instrumented, bool watched);
+
+    template <bool Instrumented>
+    uint32_t fast_forward_halt(); // T-cycles skipped while halted
+    template <bool Instrumented>
+    uint32_t skip_idle_loop(); // T-cycles skipped inside an idle loop
+    void tick_peripherals(uint32_t cycles);
     void render_frame();
+    void end_frame(); // frame statistics, the PPU starts the next frame
+    bool check_watch_break(); // logs a watchpoint break and pauses
+
+    // Export the opcode sequences run from the block cache (see generate_opcodes.py --fusion)
+    void export_sequence_profile() const;
+
+    // Export the per-opcode profile (ENABLE_PROFILING only)
+    void export_opcode_profile() const;
+
+    // Export the guest call stacks as folded stacks (ENABLE_PROFILING only)
+    void export_call_profile() const;
+
+    [[nodiscard]] std::filesystem::path trace_path() const;
 };
 
 } // namespace boyboy::core::emulator
\ No newline at end of file
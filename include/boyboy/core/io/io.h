@@ -40,6 +40,9 @@ public:
     void write(uint16_t addr, uint8_t value);
     void tick(uint16_t cycles);
 
+    // T-cycles until the next event of any component (see IoComponent::cycles_to_event)
+    [[nodiscard]] uint32_t cycles_to_event() const;
+
     /**
      * @brief Register an I/O component.
      *
@@ -67,7 +70,7 @@ public:
         }
 
         comp->set_interrupt_cb([this](cpu::Interrupt interrupt) {
-            this->write(IoReg::Interrupts::IF, std::to_underlying(interrupt));
+            interrupts_.request(interrupt);
         });
 
         components_.push_back(comp);
@@ -90,6 +93,10 @@ public:
     [[nodiscard]] const std::shared_ptr<Apu>& apu() const;
     [[nodiscard]] std::shared_ptr<Apu> apu();
 
+    // IE and IF registers (IE is mapped at 0xFFFF by the MMU)
+    [[nodiscard]] cpu::InterruptRegisters& interrupts() { return interrupts_; }
+    [[nodiscard]] const cpu::InterruptRegisters& interrupts() const { return interrupts_; }
+
 private:
     std::shared_ptr<ppu::Ppu> ppu_;
     std::shared_ptr<Timer> timer_;
@@ -100,6 +107,9 @@ private:
     // Components registry
     std::vector<std::shared_ptr<IoComponent>> components_;
 
+    // Interrupt registers with their cached pending mask
+    cpu::InterruptRegisters interrupts_;
+
     // Register address space for unmapped addresses
     std::array<uint8_t, mmu::IOSize> registers_{};
 
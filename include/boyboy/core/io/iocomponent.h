@@ -8,6 +8,7 @@
 #pragma once
 
 #include <cstdint>
+#include <limits>
 
 #include "boyboy/core/cpu/interrupts.h"
 
@@ -15,6 +16,9 @@ namespace boyboy::core::io {
 
 class IoComponent {
 public:
+    // No event can happen without CPU intervention (see cycles_to_event)
+    static constexpr uint32_t NoEvent = std::numeric_limits<uint32_t>::max();
+
     virtual ~IoComponent() = default;
 
     // Initialize component
@@ -26,6 +30,10 @@ public:
     // Called every N CPU cycles to update the component state
     virtual void tick(uint16_t cycles) = 0;
 
+    // T-cycles until the next state change the CPU could observe (interrupt request, PPU mode
+    // change...), assuming no register writes in between. Used to fast-forward a halted CPU.
+    [[nodiscard]] virtual uint32_t cycles_to_event() const = 0;
+
     // Read/write I/O registers
     [[nodiscard]] virtual uint8_t read(uint16_t addr) const = 0;
     virtual void write(uint16_t addr, uint8_t value) = 0;
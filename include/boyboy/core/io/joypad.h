@@ -25,6 +25,7 @@ public:
     void init() override;
     void reset() override;
     void tick(uint16_t cycles) override;
+    [[nodiscard]] uint32_t cycles_to_event() const override;
     [[nodiscard]] uint8_t read(uint16_t addr) const override;
     void write(uint16_t addr, uint8_t value) override;
     void set_interrupt_cb(cpu::InterruptRequestCallback callback) override;
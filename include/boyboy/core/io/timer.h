@@ -10,9 +10,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
-#include <functional>
 
 #include "boyboy/core/io/iocomponent.h"
 
@@ -24,6 +24,7 @@ public:
     void init() override;
     void reset() override;
     void tick(uint16_t cycles) override;
+    [[nodiscard]] uint32_t cycles_to_event() const override;
     [[nodiscard]] uint8_t read(uint16_t addr) const override;
     void write(uint16_t addr, uint8_t value) override;
     void set_interrupt_cb(cpu::InterruptRequestCallback callback) override;
@@ -101,11 +102,10 @@ private:
     bool tima_overflow_{false};
     bool tima_reload_{false};
 
-    // Schedulers for TIMA overflow and reload delays
+    // Schedulers for TIMA overflow and reload delays, the timer runs the event when they elapse
     struct Scheduler {
         bool scheduled;
         uint8_t remaining;
-        std::function<void(void)> execute;
 
         void schedule(uint8_t delay)
         {
@@ -113,13 +113,15 @@ private:
             remaining = delay;
         }
 
-        void update(uint8_t cycles)
+        // Returns whether the delay elapsed
+        [[nodiscard]] bool update(uint8_t cycles)
         {
             remaining -= std::min(remaining, cycles);
-            if (remaining == 0 && execute != nullptr) {
-                execute();
+            if (remaining == 0) {
                 scheduled = false;
+                return true;
             }
+            return false;
         }
 
         void reset()
@@ -129,25 +131,19 @@ private:
         }
     };
 
-    Scheduler tima_reload_scheduler_{
-        .scheduled = false,
-        .remaining = 0,
-        .execute = [this]() { tima_reload_ = false; },
-    };
+    Scheduler tima_reload_scheduler_{.scheduled = false, .remaining = 0};
+    Scheduler tima_overflow_scheduler_{.scheduled = false, .remaining = 0};
 
-    Scheduler tima_overflow_scheduler_{
-        .scheduled = false,
-        .remaining = 0,
-        .execute =
-            [this]() {
-                tima_ = tma_;
-                request_interrupt_(cpu::Interrupt::Timer);
-
-                // Start reload
-                tima_reload_ = true;
-                tima_reload_scheduler_.schedule(TimaDelayCycles);
-            },
-    };
+    // TIMA overflow delay elapsed
+    void reload_tima()
+    {
+        tima_ = tma_;
+        request_interrupt_(cpu::Interrupt::Timer);
+
+        // Start reload
+        tima_reload_ = true;
+        tima_reload_scheduler_.schedule(TimaDelayCycles);
+    }
 
     void schedule_overflow()
     {
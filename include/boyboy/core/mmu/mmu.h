@@ -17,6 +17,13 @@
  * FFFF        Interrupt Enable Register
  * ================================================================
  *
+ * Accesses first go through a page table with one entry per 256-byte page: plain memory pages
+ * (ROM banks, VRAM, enabled SRAM, WRAM and its ECHO mirror) hold a host pointer and are read or
+ * written directly, other pages (I/O, locked, unmapped, sharing regions, watched code) are null
+ * and resolved through their memory region, or by address for the cartridge and the OAM to IE
+ * pages. The table is kept up to date on bank switches, lock transitions and remaps. Pages covered by watchpoints are trapped the same way (see
+ * watchpoints.h).
+ *
  * @license GPLv3 (see LICENSE file)
  */
 
@@ -30,8 +37,10 @@
 #include <memory>
 #include <optional>
 #include <span>
+#include <utility>
 
 #include "boyboy/core/mmu/constants.h"
+#include "boyboy/core/mmu/watchpoints.h"
 
 // Forward declarations
 namespace boyboy::core {
@@ -47,8 +56,11 @@ namespace boyboy::core::mmu {
 
 class Mmu {
 public:
-    using IoWriteCallback = std::function<void(uint16_t, uint8_t)>;
-    using IoReadCallback = std::function<void(uint16_t, uint8_t)>;
+    // I/O access hooks, called with the context they were set with
+    using IoWriteCallback = void (*)(void* context, uint16_t addr, uint8_t value);
+    using IoReadCallback = void (*)(void* context, uint16_t addr, uint8_t value);
+    using CodeWriteCallback = std::function<void(uint16_t)>;
+    using BusCallback = std::function<void(uint16_t, uint8_t, bool)>;
 
     Mmu(std::shared_ptr<io::Io> io);
 
@@ -59,6 +71,22 @@ public:
     // Maps ROM memory into own memory map
     void map_rom(cartridge::Cartridge& cart);
 
+    /**
+     * @brief Map the whole address space to flat RAM (CPU conformance tests).
+     *
+     * Every address reads and writes the given RAM: no cartridge, I/O, locks, mirrors or fetch
+     * pages. Without a callback the RAM is accessed directly through the page table. The regular
+     * memory map is restored by init().
+     *
+     * @param ram RAM backing the address space.
+     * @param callback Called with the address, value and whether it's a write on every access
+     * (optional).
+     */
+    void map_flat_ram(std::span<uint8_t, MemoryMapSize> ram, BusCallback callback = nullptr);
+
+    // Currently selected ROM bank mapped at 0x4000-0x7FFF
+    [[nodiscard]] uint16_t rom_bank() const;
+
     // Memory access
 
     /**
@@ -70,7 +98,13 @@ public:
      * @param unlocked Whether to bypass VRAM/OAM locks (for PPU access).
      * @return uint8_t Value read from memory.
      */
-    [[nodiscard]] uint8_t read_byte(uint16_t addr, bool unlocked = false) const;
+    [[nodiscard]] uint8_t read_byte(uint16_t addr, bool unlocked = false) const
+    {
+        if (const auto* page = page_table(unlocked).read[addr >> 8]; page != nullptr) [[likely]] {
+            return page[addr & 0xFF];
+        }
+        return read_region(addr, unlocked);
+    }
 
     /**
      * @brief Write a byte to memory.
@@ -81,7 +115,14 @@ public:
      * @param value Value to write.
      * @param unlocked Whether to bypass VRAM/OAM locks (for PPU access).
      */
-    void write_byte(uint16_t addr, uint8_t value, bool unlocked = false);
+    void write_byte(uint16_t addr, uint8_t value, bool unlocked = false)
+    {
+        if (auto* page = page_table(unlocked).write[addr >> 8]; page != nullptr) [[likely]] {
+            page[addr & 0xFF] = value;
+            return;
+        }
+        write_region(addr, value, unlocked);
+    }
 
     // Memory access convenience methods for CPU/PPU
     // PPU has full memory access, while CPU might be locked from VRAM/OAM depending on PPU mode
@@ -90,28 +131,125 @@ public:
     void cpu_write(uint16_t addr, uint8_t value) { write_byte(addr, value, false); }
     void ppu_write(uint16_t addr, uint8_t value) { write_byte(addr, value, true); }
 
+    /**
+     * @brief Get the 256-byte page holding an address for direct instruction fetches.
+     *
+     * Only ROM and WRAM pages can be read directly, other regions have side effects, locks or
+     * mirroring and must go through read_byte(). Pages stay valid until map_generation()
+     * changes, writes to WRAM are seen through the page.
+     *
+     * @param addr Address within the page.
+     * @return const uint8_t* Start of the page, or nullptr if it can't be read directly.
+     */
+    [[nodiscard]] const uint8_t* fetch_page(uint16_t addr) const;
+
+    // Bumped whenever the pages returned by fetch_page() might change (ROM bank switch, remap)
+    [[nodiscard]] uint32_t map_generation() const { return map_generation_; }
+
     // Memory access for wider ranges than 1 byte (not used in core)
     [[nodiscard]] uint16_t read_word(uint16_t addr) const;
     void write_word(uint16_t addr, uint16_t value);
     void copy(uint16_t dst_addr, std::span<uint8_t> src);
 
     // Memory lock handling for VRAM/OAM CPU-PPU exclusion
-    void lock_vram(bool lock) { lock_vram_ = lock; };
-    void lock_oam(bool lock) { lock_oam_ = lock; };
+    void lock_vram(bool lock)
+    {
+        if (lock != lock_vram_) {
+            lock_vram_ = lock;
+            map_pages(VRAMStart, VRAMEnd);
+        }
+    }
+    void lock_oam(bool lock)
+    {
+        if (lock != lock_oam_) {
+            lock_oam_ = lock;
+            map_pages(OAMStart, NotUsableEnd);
+        }
+    }
     [[nodiscard]] bool is_vram_locked() const { return lock_vram_; }
     [[nodiscard]] bool is_oam_locked() const { return lock_oam_; }
 
-    // DMA transfer
+    /**
+     * @brief Start an OAM DMA transfer.
+     *
+     * OAM belongs to the transfer for the next DMATransferCycles: CPU reads return OpenBus and
+     * writes are ignored. The payload is copied at once when the transfer completes, or up to
+     * the byte reached so far when the PPU reads OAM, or something writes to the source page or
+     * the cartridge registers before.
+     *
+     * @param value Source page (source address >> 8).
+     */
     void start_dma(uint8_t value);
-    void tick_dma(uint16_t cycles);
+
+    // Advance the DMA transfer, a single flag check while no transfer is active
+    void tick_dma(uint32_t cycles)
+    {
+        if (dma_.active) [[unlikely]] {
+            advance_dma(cycles);
+        }
+    }
+    [[nodiscard]] bool is_dma_active() const { return dma_.active; }
 
     // Access to I/O handler
     [[nodiscard]] std::shared_ptr<io::Io> io() { return io_; }
     [[nodiscard]] const std::shared_ptr<io::Io>& io() const { return io_; }
 
     // IO read/write callbacks
-    void set_io_write_callback(IoWriteCallback callback);
-    void set_io_read_callback(IoReadCallback callback);
+    void set_io_write_callback(IoWriteCallback callback, void* context = nullptr);
+    void set_io_read_callback(IoReadCallback callback, void* context = nullptr);
+
+    // Code write tracking: writes to watched 256-byte pages notify the callback (see BlockCache)
+    void set_code_write_callback(CodeWriteCallback callback);
+    void watch_code_page(uint8_t page, bool watch);
+    [[nodiscard]] bool is_code_page_watched(uint8_t page) const { return code_pages_.at(page); }
+
+    /**
+     * @brief Watch an address range for CPU accesses (see watchpoints.h).
+     *
+     * The pages of the range are trapped while the watchpoint exists: reads and writes through
+     * read_byte()/write_byte() are checked, PPU accesses aren't, and fetch_page() stops returning
+     * them so fetches are checked by the CPU (see check_fetch()). Code predecoded before isn't
+     * trapped, the caller drops it. Mirrors are watched with the memory they access: a WRAM range
+     * traps its ECHO RAM pages too, and their hits report the WRAM address.
+     *
+     * @param start First address watched.
+     * @param end Last address watched (inclusive).
+     * @param kinds Accesses watched.
+     * @return size_t Watchpoint ID, for remove_watchpoint().
+     */
+    size_t add_watchpoint(uint16_t start, uint16_t end, WatchKind kinds);
+    bool remove_watchpoint(size_t id);
+    void clear_watchpoints();
+    [[nodiscard]] const Watchpoints& watchpoints() const { return watchpoints_; }
+    void set_watch_callback(Watchpoints::Callback callback)
+    {
+        watchpoints_.set_callback(std::move(callback));
+    }
+
+    // Pending watchpoint break, kept until cleared
+    [[nodiscard]] const std::optional<WatchHit>& watch_hit() const { return watchpoints_.hit(); }
+    void clear_watch_hit() { watchpoints_.clear_hit(); }
+
+    // Instruction fetches from trapped pages, which fetch_page() doesn't return
+    [[nodiscard]] bool is_fetch_trapped(uint16_t addr) const
+    {
+        return !watchpoints_.empty() &&
+               has_flag(
+                   watchpoints_.page_kinds(unmirror(addr) >> 8),
+                   WatchKind::Read | WatchKind::Execute
+               );
+    }
+    void check_fetch(uint16_t addr, uint8_t value)
+    {
+        watchpoints_.check(unmirror(addr), value, WatchKind::Execute);
+    }
+
+    // Reads from trapped pages, which have to reach the watchpoints one by one
+    [[nodiscard]] bool is_read_trapped(uint16_t addr) const
+    {
+        return !watchpoints_.empty() &&
+               has_flag(watchpoints_.page_kinds(unmirror(addr) >> 8), WatchKind::Read);
+    }
 
     // For debugging: dump memory region to file
     void dump(uint16_t start_addr, uint16_t end_addr, const std::string& filename = "") const;
@@ -130,10 +268,24 @@ private:
         IO,
         HRAM,
         IEReg,
+        Flat,    // Whole address space, only mapped by map_flat_ram()
         OpenBus, // Invalid region
         Count,
     };
 
+    // Accesses of the regions that aren't plain data, dispatched by handler_read()/handler_write()
+    enum class RegionHandler : uint8_t {
+        None,      // plain data
+        Rom,       // cartridge reads, MBC register writes
+        Sram,      // cartridge reads and writes
+        Unloaded,  // ROM/SRAM before a cartridge is mapped
+        NotUsable, // reads 0x00, writes ignored
+        Io,
+        IEReg,
+        Flat,    // flat RAM with a bus callback
+        OpenBus, // unmapped
+    };
+
     struct MemoryRegion {
         MemoryRegionID id = MemoryRegionID::OpenBus;
         uint16_t start{};
@@ -142,15 +294,13 @@ private:
 
         // Protection flags
         bool read_only = false;
-        bool mirrored = false;
         bool io_register = false;
 
-        // Optional mirror
+        // Optional mirrored region, data is a view of its storage
         std::optional<MemoryRegionID> mirror = std::nullopt;
 
-        // Optional I/O callbacks
-        std::function<uint8_t(uint16_t)> read_handler = nullptr;
-        std::function<void(uint16_t, uint8_t)> write_handler = nullptr;
+        // Accesses handled by the MMU rather than data
+        RegionHandler handler = RegionHandler::None;
 
         // TODO: use helpers
         // Helpers
@@ -161,18 +311,14 @@ private:
     struct Dma {
         bool active = false;
         uint16_t src = 0;
-        uint16_t dst = OAMStart;
-        int bytes_remaining = 0;
-        uint16_t tick_counter = 0;
-        uint16_t cks = 0; // debug variable to track transfer content
-
-        void start(uint8_t value);
-        void tick(uint16_t cycles, Mmu& mmu);
-        void reset();
+        uint16_t elapsed = 0; // T-cycles since the start
+        uint16_t copied = 0;  // bytes already copied to OAM
+
+        void reset() { *this = Dma{}; }
     };
 
-    // DMA state
-    Dma dma_;
+    // DMA state, mutable with OAM as the payload is copied when OAM is read (see sync_dma())
+    mutable Dma dma_;
 
     // I/O handler
     std::shared_ptr<io::Io> io_;
@@ -180,6 +326,37 @@ private:
     // Optional I/O read/write callbacks
     IoWriteCallback io_write_callback_ = nullptr;
     IoReadCallback io_read_callback_ = nullptr;
+    void* io_write_context_ = nullptr;
+    void* io_read_context_ = nullptr;
+
+    // Flat RAM bus callback (see map_flat_ram())
+    BusCallback flat_callback_ = nullptr;
+
+    // OAM and not usable share page 0xFE, I/O, HRAM and IE page 0xFF: both are accessed by address
+    // rather than through their regions, unless map_flat_ram() mapped them over
+    bool high_pages_direct_ = true;
+
+    // Watchpoints, mutable as reads record their hits
+    mutable Watchpoints watchpoints_;
+    void update_watch_traps();
+
+    // Code write tracking
+    static constexpr size_t PageCount = MemoryMapSize >> 8;
+    std::array<bool, PageCount> code_pages_{};
+    CodeWriteCallback code_write_callback_ = nullptr;
+
+    // Page table, nullptr for pages resolved through their memory region (writes to watched code
+    // pages included, to notify them)
+    struct PageTable {
+        std::array<const uint8_t*, PageCount> read{};
+        std::array<uint8_t*, PageCount> write{};
+    };
+    PageTable cpu_pages_; // VRAM/OAM locks applied
+    PageTable ppu_pages_; // unlocked accesses
+
+    // Mapped cartridge (for accesses and bank queries)
+    cartridge::Cartridge* cart_ = nullptr;
+    uint32_t map_generation_ = 0;
 
     // ROM load status flag
     bool rom_loaded_ = false;
@@ -189,11 +366,10 @@ private:
     bool lock_oam_{false};
 
     // Memory banks
-    std::array<uint8_t, VRAMSize> vram_{}; // video ram
-    std::array<uint8_t, WRAMSize> wram_{}; // work ram
-    std::array<uint8_t, OAMSize> oam_{};   // sprite attribute table
-    std::array<uint8_t, HRAMSize> hram_{}; // high ram
-    uint8_t ier_{};                        // interrupt enable register
+    std::array<uint8_t, VRAMSize> vram_{};        // video ram
+    std::array<uint8_t, WRAMSize> wram_{};        // work ram
+    mutable std::array<uint8_t, OAMSize> oam_{}; // sprite attribute table (see dma_)
+    std::array<uint8_t, HRAMSize> hram_{};        // high ram
 
     // Memory map table for region mapping
     std::array<MemoryRegion, static_cast<size_t>(MemoryRegionID::Count)> memory_map_{};
@@ -212,6 +388,15 @@ private:
     void init_memory_map();
     void init_region_lut();
 
+    // Page table updates, whenever the memory behind a page or its access might change
+    [[nodiscard]] const PageTable& page_table(bool unlocked) const
+    {
+        return unlocked ? ppu_pages_ : cpu_pages_;
+    }
+    void map_page(uint8_t page);
+    void map_page_aliases(uint8_t page); // the page and its mirrors
+    void map_pages(uint16_t start_addr, uint16_t end_addr);
+
     // Memory region lookup
     [[nodiscard]] MemoryRegion& region_lookup(uint16_t addr) { return *region_lut_[addr]; }
     [[nodiscard]] const MemoryRegion& region_lookup(uint16_t addr) const
@@ -227,6 +412,61 @@ private:
                 (region_id == MemoryRegionID::OAM || region_id == MemoryRegionID::NotUsable));
     }
 
+    // Address an access lands on, mirrored addresses resolved to their target
+    [[nodiscard]] uint16_t unmirror(uint16_t addr) const
+    {
+        const auto& region = region_lookup(addr);
+        if (!region.mirror) {
+            return addr;
+        }
+        return static_cast<uint16_t>(map(*region.mirror).start + (addr - region.start));
+    }
+
+    // Notify writes to pages holding cached code
+    void notify_code_write(uint16_t addr)
+    {
+        addr = unmirror(addr);
+        if (code_pages_[addr >> 8] && code_write_callback_) [[unlikely]] {
+            code_write_callback_(addr);
+        }
+    }
+
+    // Memory region accesses, for pages without a page table entry
+    [[nodiscard]] uint8_t read_region(uint16_t addr, bool unlocked) const;
+    void write_region(uint16_t addr, uint8_t value, bool unlocked);
+
+    // Region accesses on their own (mapped), and with the DMA bus and watchpoints (observed)
+    [[nodiscard]] uint8_t read_mapped(uint16_t addr, bool unlocked) const;
+    [[nodiscard]] uint8_t read_observed(uint16_t addr, bool unlocked) const;
+    void write_mapped(uint16_t addr, uint8_t value, bool unlocked);
+    void write_observed(uint16_t addr, uint8_t value, bool unlocked);
+
+    // Cartridge ROM and SRAM addresses, accessed through the MBC unless in the page table
+    [[nodiscard]] static bool is_cartridge_address(uint16_t addr)
+    {
+        return addr <= ROMBank1End || (addr >= SRAMStart && addr <= SRAMEnd);
+    }
+
+    // Pages 0xFE-0xFF accesses (OAM to IE), without mirrors (see high_pages_direct_)
+    [[nodiscard]] uint8_t read_high_pages(uint16_t addr, bool unlocked) const;
+    void write_high_pages(uint16_t addr, uint8_t value, bool unlocked);
+
+    // Region handlers, the MBC register writes and unmapped accesses are out of line
+    [[nodiscard]] uint8_t handler_read(const MemoryRegion& region, uint16_t addr) const;
+    void handler_write(const MemoryRegion& region, uint16_t addr, uint8_t value);
+    void mbc_register_write(uint16_t addr, uint8_t value);
+    [[nodiscard]] static uint8_t unmapped_read(const MemoryRegion& region, uint16_t addr);
+    static void unmapped_write(const MemoryRegion& region, uint16_t addr, uint8_t value);
+
+    // DMA transfer progress: completion, and the bytes copied so far when OAM is observed
+    void advance_dma(uint32_t cycles);
+    void sync_dma() const { copy_dma(dma_.elapsed / (DMATransferCycles / DMATransferSize)); }
+    [[nodiscard]] bool is_dma_source(uint16_t addr) const
+    {
+        return (unmirror(addr) >> 8) == (unmirror(dma_.src) >> 8);
+    }
+    void copy_dma(uint16_t bytes) const;
+
     // I/O read/write handlers
     void io_write(uint16_t addr, uint8_t value);
     [[nodiscard]] uint8_t io_read(uint16_t addr) const;
@@ -0,0 +1,189 @@
+/**
+ * @file watchpoints.h
+ * @brief Memory watchpoints for the BoyBoy emulator.
+ *
+ * A watchpoint covers an address range for CPU reads, writes and/or instruction fetches. The
+ * 256-byte pages it touches are trapped: the MMU drops their direct page table entries, so only
+ * their accesses take the slow path where the exact ranges are checked. Other pages keep their
+ * direct accesses, and runs without watchpoints don't check anything.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace boyboy::core::mmu {
+
+enum class WatchKind : uint8_t {
+    None = 0,
+    Read = 1 << 0,    // CPU reads, instruction fetches included
+    Write = 1 << 1,   // CPU writes
+    Execute = 1 << 2, // instruction fetches
+};
+
+constexpr WatchKind operator|(WatchKind lhs, WatchKind rhs) noexcept
+{
+    return static_cast<WatchKind>(std::to_underlying(lhs) | std::to_underlying(rhs));
+}
+
+constexpr WatchKind operator&(WatchKind lhs, WatchKind rhs) noexcept
+{
+    return static_cast<WatchKind>(std::to_underlying(lhs) & std::to_underlying(rhs));
+}
+
+constexpr WatchKind operator|=(WatchKind& lhs, WatchKind rhs) noexcept
+{
+    lhs = lhs | rhs;
+    return lhs;
+}
+
+constexpr bool has_flag(WatchKind value, WatchKind flag) noexcept
+{
+    return (value & flag) != WatchKind::None;
+}
+
+// Name of a single access kind
+constexpr const char* to_string(WatchKind kind)
+{
+    switch (kind) {
+        case WatchKind::Read:
+            return "read";
+        case WatchKind::Write:
+            return "write";
+        case WatchKind::Execute:
+            return "execute";
+        default:
+            return "unknown";
+    }
+}
+
+struct Watchpoint {
+    size_t id;
+    uint16_t start;
+    uint16_t end; // inclusive
+    WatchKind kinds;
+};
+
+struct WatchHit {
+    size_t id; // watchpoint hit
+    uint16_t addr;
+    uint8_t value; // value read, written or fetched
+    WatchKind kind;
+};
+
+class Watchpoints {
+public:
+    // Called on every hit, returns whether the emulation should break
+    using Callback = std::function<bool(const WatchHit&)>;
+
+    static constexpr size_t PageCount = 256;
+
+    /**
+     * @brief Add a watchpoint.
+     *
+     * @param start First address watched.
+     * @param end Last address watched (inclusive).
+     * @param kinds Accesses watched.
+     * @return size_t Watchpoint ID, for remove().
+     */
+    size_t add(uint16_t start, uint16_t end, WatchKind kinds)
+    {
+        if (start > end) {
+            std::swap(start, end);
+        }
+        watchpoints_.push_back({.id = next_id_, .start = start, .end = end, .kinds = kinds});
+        update_pages();
+        return next_id_++;
+    }
+
+    /**
+     * @brief Remove a watchpoint.
+     *
+     * @param id Watchpoint ID returned by add().
+     * @return bool Whether the watchpoint existed.
+     */
+    bool remove(size_t id)
+    {
+        auto removed = std::erase_if(watchpoints_, [id](const auto& wp) { return wp.id == id; });
+        update_pages();
+        return removed > 0;
+    }
+
+    void clear()
+    {
+        watchpoints_.clear();
+        update_pages();
+    }
+
+    [[nodiscard]] bool empty() const { return watchpoints_.empty(); }
+    [[nodiscard]] const std::vector<Watchpoint>& list() const { return watchpoints_; }
+
+    // Accesses watched somewhere in a page
+    [[nodiscard]] WatchKind page_kinds(uint8_t page) const { return pages_[page]; }
+
+    /**
+     * @brief Check an access to a trapped page against the watchpoints.
+     *
+     * A hit calls the callback, and is kept as the pending break unless the callback declines
+     * it (without callback every hit breaks). The first pending break is kept until clear_hit().
+     *
+     * @param addr Address accessed.
+     * @param value Value read, written or fetched.
+     * @param kind Access kind.
+     * @return bool Whether the access hit a watchpoint.
+     */
+    bool check(uint16_t addr, uint8_t value, WatchKind kind)
+    {
+        if (!has_flag(pages_[addr >> 8], kind)) {
+            return false;
+        }
+
+        auto it = std::ranges::find_if(watchpoints_, [addr, kind](const auto& wp) {
+            return addr >= wp.start && addr <= wp.end && has_flag(wp.kinds, kind);
+        });
+        if (it == watchpoints_.end()) {
+            return false;
+        }
+
+        WatchHit hit{.id = it->id, .addr = addr, .value = value, .kind = kind};
+        if ((!callback_ || callback_(hit)) && !hit_) {
+            hit_ = hit;
+        }
+        return true;
+    }
+
+    void set_callback(Callback callback) { callback_ = std::move(callback); }
+
+    // Pending break, until clear_hit()
+    [[nodiscard]] const std::optional<WatchHit>& hit() const { return hit_; }
+    void clear_hit() { hit_.reset(); }
+
+private:
+    std::vector<Watchpoint> watchpoints_;
+    std::array<WatchKind, PageCount> pages_{}; // union of the kinds watched in each page
+    size_t next_id_ = 0;
+
+    Callback callback_ = nullptr;
+    std::optional<WatchHit> hit_;
+
+    void update_pages()
+    {
+        pages_.fill(WatchKind::None);
+        for (const auto& wp : watchpoints_) {
+            for (unsigned page = wp.start >> 8; page <= (wp.end >> 8); ++page) {
+                pages_[page] |= wp.kinds;
+            }
+        }
+    }
+};
+
+} // namespace boyboy::core::mmu
@@ -0,0 +1,141 @@
+/**
+ * @file call_profiler.h
+ * @brief Guest call-stack profiler for the CPU.
+ *
+ * Keeps a shadow call stack of the emulated program from CALL, RST and interrupt entries and
+ * RET/RETI, with routines keyed on their ROM bank and address. Every emulated cycle is attributed
+ * to the call stack running at the time, and the stacks can be exported in the folded format used
+ * by flamegraph tools (flamegraph.pl, inferno, speedscope).
+ *
+ * Returns unwind the shadow stack by SP rather than by count: RET pops every frame whose return
+ * address is at or below SP, so routines that drop their return address or return to a pushed
+ * address don't desynchronize the stack.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace boyboy::core::profiling {
+
+class CallProfiler {
+public:
+    static constexpr size_t MaxDepth = 256; // deeper calls are attributed to their caller
+    static constexpr uint32_t Root = 0;     // cycles outside of any call
+
+    CallProfiler() { reset(); }
+
+    /**
+     * @brief Enter a routine.
+     *
+     * @param bank ROM bank of the routine, 0 outside of 0x4000-0x7FFF.
+     * @param addr Address of the routine.
+     * @param sp SP after pushing the return address.
+     */
+    void call(uint16_t bank, uint16_t addr, uint16_t sp)
+    {
+        if (stack_.size() >= MaxDepth) {
+            return;
+        }
+
+        uint32_t frame = (uint32_t{bank} << 16) | addr;
+        uint64_t key = (uint64_t{current_} << 32) | frame;
+        auto [it, inserted] = children_.try_emplace(key, static_cast<uint32_t>(nodes_.size()));
+        if (inserted) {
+            nodes_.push_back({.parent = current_, .frame = frame, .cycles = 0});
+        }
+
+        current_ = it->second;
+        stack_.push_back({.node = current_, .sp = sp});
+    }
+
+    /**
+     * @brief Return from the routines whose return address is at SP or deeper.
+     *
+     * @param sp SP before popping the return address.
+     */
+    void ret(uint16_t sp)
+    {
+        while (!stack_.empty() && stack_.back().sp <= sp) {
+            current_ = nodes_[stack_.back().node].parent;
+            stack_.pop_back();
+        }
+    }
+
+    /**
+     * @brief Attribute emulated cycles to the current call stack.
+     * @param cycles T-cycles.
+     */
+    void add_cycles(uint64_t cycles) { nodes_[current_].cycles += cycles; }
+
+    [[nodiscard]] size_t depth() const { return stack_.size(); }
+
+    /**
+     * @brief Drop all the recorded stacks.
+     */
+    void reset()
+    {
+        nodes_.assign(1, Node{.parent = Root, .frame = 0, .cycles = 0});
+        children_.clear();
+        stack_.clear();
+        current_ = Root;
+    }
+
+    /**
+     * @brief Export the recorded stacks as folded stacks.
+     *
+     * One `frame;frame;... cycles` line per call stack that used cycles, outermost frame first,
+     * sorted by stack. Frames are `bank:address` in hex, e.g. `root;00:0150;01:4A2F 1234`.
+     *
+     * @return std::string Folded stacks text.
+     */
+    [[nodiscard]] std::string to_folded() const
+    {
+        std::vector<std::string> lines;
+        for (uint32_t id = 0; id < nodes_.size(); ++id) {
+            if (nodes_[id].cycles == 0) {
+                continue;
+            }
+
+            std::string stack;
+            for (uint32_t node = id; node != Root; node = nodes_[node].parent) {
+                auto frame = nodes_[node].frame;
+                stack.insert(0, std::format(";{:02X}:{:04X}", frame >> 16, frame & 0xFFFF));
+            }
+            lines.push_back(std::format("root{} {}\n", stack, nodes_[id].cycles));
+        }
+
+        std::ranges::sort(lines);
+        std::string folded;
+        for (const auto& line : lines) {
+            folded += line;
+        }
+        return folded;
+    }
+
+private:
+    struct Node {
+        uint32_t parent;
+        uint32_t frame; // bank << 16 | address
+        uint64_t cycles;
+    };
+    struct Frame {
+        uint32_t node;
+        uint16_t sp;
+    };
+
+    std::vector<Node> nodes_;                         // call tree, nodes_[Root] is the root
+    std::unordered_map<uint64_t, uint32_t> children_; // (parent << 32 | frame) -> node
+    std::vector<Frame> stack_;                        // shadow call stack
+    uint32_t current_{Root};
+};
+
+} // namespace boyboy::core::profiling
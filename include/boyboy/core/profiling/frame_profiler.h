@@ -3,7 +3,7 @@
  * @brief Frame profiler for measuring FPS and performance metrics.
  *
  * Provides types and a class for collecting and reporting frame-based statistics,
- * such as FPS, IPS, CPS, and per-component timing.
+ * such as FPS, IPS, CPS, per-component timing and per-frame event counters.
  *
  * @license GPLv3 (see LICENSE file)
  */
@@ -64,11 +64,58 @@ inline FrameTimes& operator+=(FrameTimes& lhs, const FrameTimes& rhs)
 }
 
 /**
- * @brief Per-frame data: instruction/cycle counts and optional timing.
+ * @brief Enum for per-frame event counters.
+ */
+enum class FrameCounter : uint8_t {
+    BlockCacheHits,
+    BlockCacheMisses,
+    BlockCacheInvalidations,
+    BatchedInstructions,
+    FusedInstructions,
+    HaltSkippedCycles,
+    IdleLoopSkippedCycles,
+    Count
+};
+
+/**
+ * @brief Convert FrameCounter enum to string.
+ * @param counter FrameCounter value.
+ * @return String representation.
+ */
+inline std::string to_string(FrameCounter counter)
+{
+    switch (counter) {
+        case FrameCounter::BlockCacheHits:
+            return "BlockCacheHits";
+        case FrameCounter::BlockCacheMisses:
+            return "BlockCacheMisses";
+        case FrameCounter::BlockCacheInvalidations:
+            return "BlockCacheInvalidations";
+        case FrameCounter::BatchedInstructions:
+            return "BatchedInstructions";
+        case FrameCounter::FusedInstructions:
+            return "FusedInstructions";
+        case FrameCounter::HaltSkippedCycles:
+            return "HaltSkippedCycles";
+        case FrameCounter::IdleLoopSkippedCycles:
+            return "IdleLoopSkippedCycles";
+        default:
+            return "Unknown";
+    }
+}
+
+/**
+ * @brief Array of per-frame event counters.
+ */
+using FrameCounters = std::array<uint64_t, static_cast<size_t>(FrameCounter::Count)>;
+
+/**
+ * @brief Per-frame data: instruction/cycle counts, event counters and optional timing.
  */
 struct FrameData {
     uint64_t instruction_count{0};
     uint64_t cycle_count{0};
+    FrameCounters counters{};
     std::optional<FrameTimes> times_us;
 
     /**
@@ -80,6 +127,7 @@ struct FrameData {
     {
         instruction_count += other.instruction_count;
         cycle_count += other.cycle_count;
+        std::ranges::transform(counters, other.counters, counters.begin(), std::plus<>{});
         if (other.times_us) {
             if (!times_us) {
                 times_us.emplace();
@@ -96,6 +144,7 @@ struct FrameData {
     {
         instruction_count = 0;
         cycle_count = 0;
+        counters.fill(0);
         if (times_us) {
             times_us.emplace();
         }
@@ -180,6 +229,16 @@ public:
         }
     }
 
+    /**
+     * @brief Add to a per-frame event counter for the current interval.
+     * @param counter Counter to increment.
+     * @param value Amount to add.
+     */
+    void add_counter(FrameCounter counter, uint64_t value)
+    {
+        frame_stats_.frame_data.counters.at(static_cast<size_t>(counter)) += value;
+    }
+
     /**
      * @brief Output a final report of all accumulated stats.
      *
@@ -217,6 +276,8 @@ public:
             }
         }
 
+        log_msg += format_counters(frame_data.counters);
+
         common::log::info("----- Frame Profiler Report -----");
         common::log::info("{}", log_msg);
         common::log::info("---------------------------------");
@@ -266,8 +327,38 @@ private:
             }
         }
 
+        log_msg += format_counters(frame_data.counters);
+
         common::log::info("{}", log_msg);
     }
+
+    /**
+     * @brief Format the non-zero event counters (and derived rates) for logging.
+     * @param counters Counters to format.
+     * @return Formatted string, empty if all counters are zero.
+     */
+    static std::string format_counters(const FrameCounters& counters)
+    {
+        std::string msg;
+        for (size_t i = 0; i < static_cast<size_t>(FrameCounter::Count); ++i) {
+            if (counters.at(i) != 0) {
+                msg += std::format(
+                    " | {}: {}", to_string(static_cast<FrameCounter>(i)), counters.at(i)
+                );
+            }
+        }
+
+        auto hits = counters.at(static_cast<size_t>(FrameCounter::BlockCacheHits));
+        auto misses = counters.at(static_cast<size_t>(FrameCounter::BlockCacheMisses));
+        if (hits + misses != 0) {
+            msg += std::format(
+                " | BlockCacheHitRate: {:.1f}%",
+                100.0 * static_cast<double>(hits) / static_cast<double>(hits + misses)
+            );
+        }
+
+        return msg;
+    }
 };
 
 } // namespace boyboy::core::profiling
\ No newline at end of file
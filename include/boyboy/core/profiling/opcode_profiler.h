@@ -0,0 +1,211 @@
+/**
+ * @file opcode_profiler.h
+ * @brief Per-opcode execution profiler for the CPU.
+ *
+ * Records execution counts, emulated cycles and sampled host time for every unprefixed and
+ * CB-prefixed opcode, to find the instruction handlers worth optimizing first.
+ * Only one execution every SampleInterval is timed, keeping the clock reads off most instructions.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace boyboy::core::profiling {
+
+/**
+ * @brief Stats recorded for a single opcode.
+ */
+struct OpcodeStats {
+    uint64_t count{0};      // executions
+    uint64_t cycles{0};     // emulated T-cycles
+    uint64_t samples{0};    // timed executions
+    uint64_t sampled_ns{0}; // host time of the timed executions
+
+    /**
+     * @brief Average host time per execution, from the timed executions.
+     * @return double Average nanoseconds, 0 if never timed.
+     */
+    [[nodiscard]] double avg_ns() const
+    {
+        return (samples != 0) ? static_cast<double>(sampled_ns) / static_cast<double>(samples)
+                              : 0.0;
+    }
+
+    /**
+     * @brief Estimated host time of all the executions.
+     * @return double Total nanoseconds, extrapolated from the timed executions.
+     */
+    [[nodiscard]] double total_ns() const { return avg_ns() * static_cast<double>(count); }
+};
+
+/**
+ * @brief Per-opcode execution profiler.
+ *
+ * Opcodes are indexed with their prefix: 0x000-0x0FF unprefixed and 0x100-0x1FF CB-prefixed.
+ */
+class OpcodeProfiler {
+public:
+    using clock = std::chrono::high_resolution_clock;
+    using duration = std::chrono::nanoseconds;
+    using time_point = std::chrono::time_point<clock>;
+
+    static constexpr size_t OpcodeCount = 512;
+    static constexpr uint64_t SampleInterval = 64; // must be a power of two
+
+    // Mnemonics indexed like the opcodes, used to label the exports
+    using Mnemonics = std::span<const std::string_view, OpcodeCount>;
+
+    [[nodiscard]] static constexpr size_t index(bool prefixed, uint8_t opcode)
+    {
+        return (prefixed ? 0x100 : 0x000) | opcode;
+    }
+
+    /**
+     * @brief Start an opcode execution, timing it once every SampleInterval executions.
+     */
+    void start()
+    {
+        sampling_ = (executions_++ & (SampleInterval - 1)) == 0;
+        if (sampling_) {
+            start_time_ = clock::now();
+        }
+    }
+
+    /**
+     * @brief Stop the execution started last and record it.
+     * @param prefixed Whether the opcode is CB-prefixed.
+     * @param opcode Opcode executed.
+     * @param cycles T-cycles executed.
+     */
+    void stop(bool prefixed, uint8_t opcode, uint8_t cycles)
+    {
+        auto& stats = stats_[index(prefixed, opcode)];
+        if (sampling_) {
+            auto elapsed = std::chrono::duration_cast<duration>(clock::now() - start_time_);
+            stats.sampled_ns += elapsed.count();
+            stats.samples++;
+            sampling_ = false;
+        }
+        stats.count++;
+        stats.cycles += cycles;
+    }
+
+    /**
+     * @brief Record an untimed execution, e.g. an instruction run by a superinstruction.
+     * @param prefixed Whether the opcode is CB-prefixed.
+     * @param opcode Opcode executed.
+     * @param cycles T-cycles executed.
+     */
+    void record(bool prefixed, uint8_t opcode, uint8_t cycles)
+    {
+        auto& stats = stats_[index(prefixed, opcode)];
+        stats.count++;
+        stats.cycles += cycles;
+    }
+
+    [[nodiscard]] const OpcodeStats& stats(bool prefixed, uint8_t opcode) const
+    {
+        return stats_[index(prefixed, opcode)];
+    }
+
+    /**
+     * @brief Reset all the recorded stats.
+     */
+    void reset()
+    {
+        stats_ = {};
+        executions_ = 0;
+        sampling_ = false;
+    }
+
+    /**
+     * @brief Export the executed opcodes as CSV.
+     *
+     * One `opcode,mnemonic,count,cycles,samples,avg_ns,total_ns` row per opcode, e.g.
+     * `CB7C,"BIT 7, H",1200,9600,19,3.21,3852.00`.
+     *
+     * @param mnemonics Mnemonics of the opcodes.
+     * @return std::string CSV text.
+     */
+    [[nodiscard]] std::string to_csv(Mnemonics mnemonics) const
+    {
+        std::string csv = "opcode,mnemonic,count,cycles,samples,avg_ns,total_ns\n";
+        for (size_t i = 0; i < OpcodeCount; ++i) {
+            const auto& stats = stats_[i];
+            if (stats.count == 0) {
+                continue;
+            }
+            csv += std::format(
+                "{},\"{}\",{},{},{},{:.2f},{:.2f}\n",
+                opcode_id(i),
+                mnemonics[i],
+                stats.count,
+                stats.cycles,
+                stats.samples,
+                stats.avg_ns(),
+                stats.total_ns()
+            );
+        }
+        return csv;
+    }
+
+    /**
+     * @brief Export the executed opcodes as JSON.
+     *
+     * An array of objects with the same fields as the CSV export.
+     *
+     * @param mnemonics Mnemonics of the opcodes.
+     * @return std::string JSON text.
+     */
+    [[nodiscard]] std::string to_json(Mnemonics mnemonics) const
+    {
+        std::string json = "[";
+        bool first = true;
+        for (size_t i = 0; i < OpcodeCount; ++i) {
+            const auto& stats = stats_[i];
+            if (stats.count == 0) {
+                continue;
+            }
+            json += std::format(
+                "{}\n  {{\"opcode\": \"{}\", \"mnemonic\": \"{}\", \"count\": {}, \"cycles\": {}, "
+                "\"samples\": {}, \"avg_ns\": {:.2f}, \"total_ns\": {:.2f}}}",
+                first ? "" : ",",
+                opcode_id(i),
+                mnemonics[i],
+                stats.count,
+                stats.cycles,
+                stats.samples,
+                stats.avg_ns(),
+                stats.total_ns()
+            );
+            first = false;
+        }
+        json += first ? "]\n" : "\n]\n";
+        return json;
+    }
+
+private:
+    std::array<OpcodeStats, OpcodeCount> stats_{};
+    uint64_t executions_{0};
+    bool sampling_{false};
+    time_point start_time_{};
+
+    // Opcode as in the opcode tables, e.g. "05" or "CB7C"
+    [[nodiscard]] static std::string opcode_id(size_t index)
+    {
+        return (index >= 0x100) ? std::format("CB{:02X}", index & 0xFF)
+                                : std::format("{:02X}", index);
+    }
+};
+
+} // namespace boyboy::core::profiling
@@ -9,8 +9,10 @@
  */
 
 #pragma once
+#include "boyboy/core/profiling/call_profiler.h"
 #include "boyboy/core/profiling/frame_profiler.h"
 #include "boyboy/core/profiling/hot_profiler.h"
+#include "boyboy/core/profiling/opcode_profiler.h"
 #include "boyboy/core/profiling/profiler.h"
 
 namespace boyboy::core::profiling {
@@ -62,6 +64,51 @@ using ActiveProfiler = Profiler;
  */
 #define BB_HOT_PROFILE_REPORT() boyboy::core::profiling::hot_profile_report()
 
+/**
+ * @brief Start an opcode execution for the opcode profiler (sampled timing).
+ */
+#define BB_PROFILE_OPCODE_START() boyboy::core::profiling::get_opcode_profiler().start()
+
+/**
+ * @brief Stop the opcode execution started last and record it.
+ * @param prefixed Whether the opcode is CB-prefixed.
+ * @param opcode Opcode executed.
+ * @param cycles T-cycles executed.
+ */
+#define BB_PROFILE_OPCODE_STOP(prefixed, opcode, cycles)                                           \
+    boyboy::core::profiling::get_opcode_profiler().stop(prefixed, opcode, cycles)
+
+/**
+ * @brief Record an untimed opcode execution.
+ * @param prefixed Whether the opcode is CB-prefixed.
+ * @param opcode Opcode executed.
+ * @param cycles T-cycles executed.
+ */
+#define BB_PROFILE_OPCODE(prefixed, opcode, cycles)                                                \
+    boyboy::core::profiling::get_opcode_profiler().record(prefixed, opcode, cycles)
+
+/**
+ * @brief Enter a guest routine in the call-stack profiler.
+ * @param bank ROM bank of the routine.
+ * @param addr Address of the routine.
+ * @param sp SP after pushing the return address.
+ */
+#define BB_PROFILE_GUEST_CALL(bank, addr, sp)                                                      \
+    boyboy::core::profiling::get_call_profiler().call(bank, addr, sp)
+
+/**
+ * @brief Return from guest routines in the call-stack profiler.
+ * @param sp SP before popping the return address.
+ */
+#define BB_PROFILE_GUEST_RET(sp) boyboy::core::profiling::get_call_profiler().ret(sp)
+
+/**
+ * @brief Attribute emulated cycles to the current guest call stack.
+ * @param cycles T-cycles.
+ */
+#define BB_PROFILE_GUEST_CYCLES(cycles)                                                            \
+    boyboy::core::profiling::get_call_profiler().add_cycles(cycles)
+
 #else
 using ActiveProfiler = NullProfiler;
 
@@ -70,6 +117,12 @@ using ActiveProfiler = NullProfiler;
 #define BB_PROFILE_SCOPE(name)
 #define BB_PROFILE_REPORT()
 #define BB_HOT_PROFILE_REPORT()
+#define BB_PROFILE_OPCODE_START()
+#define BB_PROFILE_OPCODE_STOP(prefixed, opcode, cycles)
+#define BB_PROFILE_OPCODE(prefixed, opcode, cycles)
+#define BB_PROFILE_GUEST_CALL(bank, addr, sp)
+#define BB_PROFILE_GUEST_RET(sp)
+#define BB_PROFILE_GUEST_CYCLES(cycles)
 #endif
 
 /**
@@ -79,6 +132,14 @@ using ActiveProfiler = NullProfiler;
  */
 #define BB_PROFILE_FRAME(instr, cycles) boyboy::core::profiling::profile_frame(instr, cycles)
 
+/**
+ * @brief Add to a per-frame event counter (recorded with the next frame).
+ * @param counter FrameCounter enum value.
+ * @param value Amount to add.
+ */
+#define BB_PROFILE_COUNTER(counter, value)                                                         \
+    boyboy::core::profiling::profile_counter(counter, value)
+
 /**
  * @brief Output a frame profiler report (FPS, IPS, CPS, etc).
  */
@@ -134,6 +195,26 @@ inline HotProfiler& get_hot_profiler()
     return hot_profiler;
 }
 
+/**
+ * @brief Get the global opcode profiler instance.
+ * @return Reference to the opcode profiler.
+ */
+inline OpcodeProfiler& get_opcode_profiler()
+{
+    static OpcodeProfiler opcode_profiler;
+    return opcode_profiler;
+}
+
+/**
+ * @brief Get the global guest call-stack profiler instance.
+ * @return Reference to the call profiler.
+ */
+inline CallProfiler& get_call_profiler()
+{
+    static CallProfiler call_profiler;
+    return call_profiler;
+}
+
 /**
  * @brief Start a named profiling timer (string).
  * @param name Timer name.
@@ -245,6 +326,16 @@ inline void profile_frame(uint64_t instructions, uint64_t cycles)
     get_frame_profiler().record_frame(frame_data);
 }
 
+/**
+ * @brief Add to a per-frame event counter.
+ * @param counter FrameCounter enum value.
+ * @param value Amount to add.
+ */
+inline void profile_counter(FrameCounter counter, uint64_t value)
+{
+    get_frame_profiler().add_counter(counter, value);
+}
+
 /**
  * @brief Output a profiling report for all timers.
  */
@@ -18,6 +18,7 @@ namespace boyboy::app::commands {
 class RunCommand;
 class InfoCommand;
 class ConfigCommand;
+class TraceCommand;
 } // namespace boyboy::app::commands
 
 namespace boyboy::frontend::cli {
@@ -42,6 +43,9 @@ private:
         // Config
         std::optional<std::string> cfg_key;
         std::optional<std::string> cfg_value;
+        // Trace
+        std::string trace_path;
+        bool trace_disassemble{false};
     } options_;
 
     CLI::App app_parser_;
@@ -53,6 +57,7 @@ private:
     void register_run(app::commands::RunCommand& command);
     void register_info(app::commands::InfoCommand& command);
     void register_config(app::commands::ConfigCommand& command);
+    void register_trace(app::commands::TraceCommand& command);
 };
 
 } // namespace boyboy::frontend::cli
\ No newline at end of file
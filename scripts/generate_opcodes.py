@@ -1,16 +1,24 @@
 #!/usr/bin/env python3
 
 """
-Generate opcode tables and CPU function declarations/implementations from a JSON file.
-Reads from data/Opcodes.json and writes to src/generated/.
+Generate opcode metadata tables, switch dispatch and CPU function declarations/implementations
+from a JSON file. Reads from data/Opcodes.json and writes to src/generated/.
+
+Superinstructions for hot opcode sequences are generated from sequence profiles, as exported by
+the emulator with debug.instrumentation enabled (see SequenceProfile::to_csv).
+
+Microprograms split every instruction into the M-cycles following its opcode fetch, so that the
+M-cycle and T-cycle tick modes access memory on the same M-cycle as the hardware does.
 """
 
 import argparse
+import csv
 import json
 from pathlib import Path
 from datetime import datetime, timezone
 
 JSON_FILE = Path(__file__).parent.parent / "data/Opcodes.json"
+FUSION_PROFILE = Path(__file__).parent.parent / "data/fusion_profile.csv"
 PRIVATE_OUTPUT_DIR = Path(__file__).parent.parent / "src/boyboy/core/cpu/generated"
 PUBLIC_OUTPUT_DIR = Path(__file__).parent.parent / "include/boyboy/core/cpu/generated"
 PRIVATE_OUTPUT_DIR.mkdir(exist_ok=True)
@@ -70,6 +78,94 @@ def get_func_name(mnemonic, ops_list):
     return name
 
 
+R8 = {"A", "B", "C", "D", "E", "H", "L"}
+R16 = {"BC", "DE", "HL", "SP", "AF"}
+ALU_OPS = {"ADD", "ADC", "SUB", "SBC", "AND", "XOR", "OR", "CP"}
+CB_SHIFT_OPS = {"RLC", "RRC", "RL", "RR", "SLA", "SRA", "SRL", "SWAP"}
+CB_BIT_OPS = {"BIT", "RES", "SET"}
+
+
+def _reg(op, regs):
+    """Return the register name if the operand is a plain register in regs, else None."""
+    name = op["name"]
+    if name in regs and op.get("immediate", False):
+        return name
+    return None
+
+
+def _at_reg(op, regs):
+    """Return the register name if the operand is a plain [r16] memory access, else None."""
+    name = op["name"]
+    if (
+        name in regs
+        and not op.get("immediate", False)
+        and not op.get("increment", False)
+        and not op.get("decrement", False)
+    ):
+        return name
+    return None
+
+
+def get_template_args(mnemonic, ops_list):
+    """
+    Return (generic_handler, template_args) for opcodes implemented by a register-specialized
+    generic handler, or None if the opcode has its own individual handler.
+
+    e.g. LD B, C -> ("ld_r8_r8", ["Reg8Name::B", "Reg8Name::C"])
+    """
+    r8 = lambda name: f"Reg8Name::{name}"  # noqa: E731
+    r16 = lambda name: f"Reg16Name::{name}"  # noqa: E731
+    ops = ops_list
+    n = len(ops)
+
+    if mnemonic == "LD" and n == 2:
+        dst, src = ops
+        if _reg(dst, R8) and _reg(src, R8):
+            return ("ld_r8_r8", [r8(dst["name"]), r8(src["name"])])
+        if _reg(dst, R8) and src["name"] == "n8":
+            return ("ld_r8_n8", [r8(dst["name"])])
+        if _reg(dst, R8) and _at_reg(src, {"BC", "DE", "HL"}):
+            return ("ld_r8_at_r16", [r8(dst["name"]), r16(src["name"])])
+        if _at_reg(dst, {"BC", "DE", "HL"}) and _reg(src, R8):
+            return ("ld_at_r16_r8", [r16(dst["name"]), r8(src["name"])])
+        if _reg(dst, R16 - {"AF"}) and src["name"] == "n16":
+            return ("ld_r16_n16", [r16(dst["name"])])
+    if mnemonic in ("INC", "DEC") and n == 1:
+        if _reg(ops[0], R16 - {"AF"}):
+            return (f"{mnemonic.lower()}_r16", [r16(ops[0]["name"])])
+        if _reg(ops[0], R8):
+            return (f"{mnemonic.lower()}_r8", [r8(ops[0]["name"])])
+    if mnemonic == "ADD" and n == 2 and _reg(ops[0], {"HL"}) and _reg(ops[1], R16 - {"AF"}):
+        return ("add_hl_r16", [r16(ops[1]["name"])])
+    if mnemonic in ALU_OPS and n == 2 and _reg(ops[0], {"A"}) and _reg(ops[1], R8):
+        return (f"{mnemonic.lower()}_a_r8", [r8(ops[1]["name"])])
+    if mnemonic in ("PUSH", "POP") and n == 1 and _reg(ops[0], R16 - {"SP"}):
+        return (f"{mnemonic.lower()}_r16", [r16(ops[0]["name"])])
+    if mnemonic == "RST" and n == 1:
+        return ("rst", [f"0x{int(ops[0]['name'].replace('$', ''), 16):02X}"])
+    if mnemonic in CB_SHIFT_OPS and n == 1 and _reg(ops[0], R8):
+        return (f"{mnemonic.lower()}_r8", [r8(ops[0]["name"])])
+    if mnemonic in CB_BIT_OPS and n == 2:
+        bit = ops[0]["name"]
+        if _reg(ops[1], R8):
+            return (f"{mnemonic.lower()}_b_r8", [bit, r8(ops[1]["name"])])
+        if _at_reg(ops[1], {"HL"}):
+            return (f"{mnemonic.lower()}_b_at_hl", [bit])
+    return None
+
+
+def get_handler(mnemonic, ops_list):
+    """
+    Return the CPU handler for an opcode: a fully resolved template instantiation for the
+    register-specialized families or the individual handler name otherwise.
+    """
+    template = get_template_args(mnemonic, ops_list)
+    if template is not None:
+        (generic, args) = template
+        return f"{generic}<{', '.join(args)}>"
+    return get_func_name(mnemonic, ops_list)
+
+
 def get_mnemonic(mnemonic, ops_list):
     """Generate full mnemonic with operands."""
     if not ops_list:
@@ -108,38 +204,109 @@ def write_file_header(f, description, source_json):
     f.write(f"// ============================================================\n\n")
 
 
-def write_table(opcodes, path, description="Opcode Table"):
-    """Write the opcode table to a file."""
-    # Determine the maximum length of mnemonics for formatting
-    mnemonic_len = max(
-        len(get_mnemonic(info["mnemonic"], info.get("operands", [])))
-        for info in opcodes.values()
+def _sorted_opcodes(opcodes):
+    """Opcode entries sorted by opcode, as (code, info) tuples."""
+    return [
+        (int(code_str, 16), info)
+        for code_str, info in sorted(opcodes.items(), key=lambda x: int(x[0], 16))
+    ]
+
+
+def _write_rows(f, name, value_type, tables, values_per_line):
+    """
+    Write a static constexpr [InstructionType][opcode] table, values_per_line values per row.
+
+    tables is a list of (comment, [(code, value, row comment)]) for the unprefixed and CB-prefixed
+    opcodes.
+    """
+    f.write(
+        f"static constexpr std::array<std::array<{value_type}, 256>, 2> {name} = {{{{\n"
     )
+    for comment, entries in tables:
+        f.write(f"    // {comment}\n")
+        f.write("    {{\n")
+        for row in range(0, len(entries), values_per_line):
+            chunk = entries[row : row + values_per_line]
+            if values_per_line == 1:
+                (code, value, row_comment) = chunk[0]
+                f.write(f"        {value + ',':<48} // 0x{code:02X} {row_comment}\n")
+            else:
+                values = " ".join(f"{str(value) + ',':<3}" for (_, value, _) in chunk)
+                first = chunk[0][0]
+                last = chunk[-1][0]
+                f.write(f"        {values} // 0x{first:02X}-0x{last:02X}\n")
+        f.write("    }},\n")
+    f.write("}};\n\n")
+
+
+def write_tables(data, hot_path, cold_path):
+    """
+    Write the instruction metadata tables of InstructionTable, one array per field indexed by
+    [InstructionType][opcode].
 
-    # Generate file with the following format:
-    # table[0x00] = {.mnemonic = "NOP", .length = 1, .cycles = 4, .cycles_no_branch = 0, .execute = &Cpu::nop};
+    The hot file has the fields read on every executed instruction (handler, cycles and cycles
+    when not branching), the cold file the ones only used to decode and disassemble (mnemonic
+    and length).
+    """
+    tables = [
+        ("Unprefixed", _sorted_opcodes(data["unprefixed"])),
+        ("CB-prefixed", _sorted_opcodes(data["cbprefixed"])),
+    ]
+    for _, opcodes in tables:
+        if [code for (code, _) in opcodes] != list(range(256)):
+            raise ValueError("Opcode tables must have 256 entries")
+
+    def field(getter):
+        return [
+            (comment, [(code, getter(info), get_mnemonic(info["mnemonic"], info["operands"]))
+                       for (code, info) in opcodes])
+            for (comment, opcodes) in tables
+        ]
+
+    # static constexpr std::array<std::array<OpcodeHandler, 256>, 2> Handlers = {{ ... }};
+    with open(hot_path, "w") as f:
+        write_file_header(f, "Hot instruction metadata for InstructionTable", JSON_FILE.name)
+        handler = lambda info: f"&Cpu::{get_handler(info['mnemonic'], info['operands'])}"
+        cycles = lambda info: get_cycles(info.get("cycles", []))[0]
+        cycles_no_branch = lambda info: get_cycles(info.get("cycles", []))[1]
+        _write_rows(f, "Handlers", "OpcodeHandler", field(handler), 1)
+        _write_rows(f, "Cycles", "uint8_t", field(cycles), 16)
+        _write_rows(f, "CyclesNoBranch", "uint8_t", field(cycles_no_branch), 16)
+    print(f"[INFO] Wrote hot instruction tables to {hot_path}")
+
+    # static constexpr std::array<std::array<std::string_view, 256>, 2> Mnemonics = {{ ... }};
+    with open(cold_path, "w") as f:
+        write_file_header(f, "Cold instruction metadata for InstructionTable", JSON_FILE.name)
+        mnemonic = lambda info: f'"{get_mnemonic(info["mnemonic"], info["operands"])}"'
+        length = lambda info: info["bytes"]
+        _write_rows(f, "Mnemonics", "std::string_view", field(mnemonic), 1)
+        _write_rows(f, "Lengths", "uint8_t", field(length), 16)
+    print(f"[INFO] Wrote cold instruction tables to {cold_path}")
+
+
+def write_dispatch(opcodes, path, description="Opcode Switch Dispatch"):
+    """
+    Write the switch-based dispatch cases to a file.
+
+    Each case calls the handler directly and returns the instruction cycles, picking the
+    non-branch cycles when a conditional instruction doesn't take the branch:
+    case 0x00: nop(); return 4;
+    case 0x20: jr_nz_e8(); return branch_taken_ ? 12 : 8;
+    """
     with open(path, "w") as f:
         write_file_header(f, description, JSON_FILE.name)
         for code_str, info in sorted(opcodes.items(), key=lambda x: int(x[0], 16)):
             code = int(code_str, 16)
-            mnemonic = info["mnemonic"]
-            length = info["bytes"]
             (cycles, cycles_no_branch) = get_cycles(info.get("cycles", []))
-            operands = get_operands(info["operands"])
-            func_name = get_func_name(mnemonic, info["operands"])
-            full_mnemonic = get_mnemonic(info["mnemonic"], info["operands"])
+            handler = get_handler(info["mnemonic"], info.get("operands", []))
 
-            padding = " " * (mnemonic_len - len(full_mnemonic) + 1)
+            if cycles_no_branch != 0:
+                ret = f"branch_taken_ ? {cycles} : {cycles_no_branch}"
+            else:
+                ret = f"{cycles}"
 
-            f.write(
-                f"table[0x{code:02X}] = {{"
-                f'.mnemonic = "{full_mnemonic}",{padding}'
-                f".length = {length}, "
-                f'.cycles = {cycles},{" " * (2 - len(str(cycles)) + 1)}'
-                f'.cycles_no_branch = {cycles_no_branch},{" " * (2 - len(str(cycles_no_branch)) + 1)}'
-                f".execute = &Cpu::{func_name}}};\n"
-            )
-    print(f"[INFO] Wrote opcode table to {path}")
+            f.write(f"case 0x{code:02X}: {handler}(); return {ret};\n")
+    print(f"[INFO] Wrote opcode switch dispatch to {path}")
 
 
 def write_cpu_decls(opcodes, path, description="CPU Function Declarations"):
@@ -147,6 +314,9 @@ def write_cpu_decls(opcodes, path, description="CPU Function Declarations"):
     with open(path, "w") as f:
         write_file_header(f, description, JSON_FILE.name)
         for code, info in sorted(opcodes.items(), key=lambda x: int(x[0], 16)):
+            # Register-specialized opcodes use the generic handler templates instead
+            if get_template_args(info["mnemonic"], info.get("operands", [])) is not None:
+                continue
             func_name = get_func_name(info["mnemonic"], info.get("operands", []))
             f.write(f"    void {func_name}();\n")
     print(f"[INFO] Wrote CPU function declarations to {path}")
@@ -154,8 +324,13 @@ def write_cpu_decls(opcodes, path, description="CPU Function Declarations"):
 
 def write_cpu_impls(opcodes, path, description="CPU Function Implementations"):
     """
-    Generate CPU stub implementations with per-function guards and runtime error.
-    Each stub is wrapped in:
+    Generate CPU handler instantiations and stub implementations.
+
+    Register-specialized opcodes get an explicit instantiation of their generic handler template,
+    so that tables and dispatch can point at them from other translation units:
+    template void Cpu::GENERIC<ARGS>(); // 0xNN MNEMONIC
+
+    Every other opcode gets a stub wrapped in a per-function guard that throws at runtime:
     #ifndef CPU_FUNC_NAME
     void Cpu::FUNC_NAME() {
         throw UnimplementedOpcode(opcode, "MNEMONIC");
@@ -164,21 +339,34 @@ def write_cpu_impls(opcodes, path, description="CPU Function Implementations"):
     """
     with open(path, "w") as f:
         write_file_header(f, description, JSON_FILE.name)
-        f.write('#include "boyboy/common/errors.h"\n\n')
 
-        for code, info in sorted(opcodes.items(), key=lambda x: int(x[0], 16)):
+        sorted_opcodes = sorted(opcodes.items(), key=lambda x: int(x[0], 16))
+
+        f.write("// Register-specialized handler instantiations\n")
+        for code, info in sorted_opcodes:
+            if get_template_args(info["mnemonic"], info.get("operands", [])) is None:
+                continue
+            handler = get_handler(info["mnemonic"], info.get("operands", []))
+            mnemonic = get_mnemonic(info["mnemonic"], info.get("operands", []))
+            f.write(f"template void Cpu::{handler}(); // 0x{int(code, 16):02X} {mnemonic}\n")
+
+        f.write("\n#ifdef CPU_STUBS\n\n")
+        for code, info in sorted_opcodes:
+            if get_template_args(info["mnemonic"], info.get("operands", [])) is not None:
+                continue
             func_name = get_func_name(info["mnemonic"], info.get("operands", []))
             macro_name = f"CPU_{func_name.upper()}"
             mnemonic = get_mnemonic(info["mnemonic"], info.get("operands", []))
             opcode_int = int(code, 16)
 
             f.write(f"#ifndef {macro_name}\n")
-            f.write(f"void boyboy::cpu::Cpu::{func_name}() {{\n")
+            f.write(f"void Cpu::{func_name}() {{\n")
             f.write(
-                f'    throw boyboy::common::errors::UnimplementedOpcode(0x{opcode_int:02X}, "{mnemonic}");\n'
+                f'    throw common::errors::UnimplementedOpcode(0x{opcode_int:02X}, "{mnemonic}");\n'
             )
             f.write("}\n")
             f.write(f"#endif // {macro_name}\n\n")
+        f.write("#endif // CPU_STUBS\n")
     print(f"[INFO] Wrote CPU function implementations to {path}")
 
 
@@ -205,6 +393,244 @@ def check_duplicates(opcodes, prefix):
         print(f"[INFO] No duplicates found in {prefix} opcodes")
 
 
+# Instructions that can't be part of a superinstruction: stack and control flow changes other than
+# a final jump, and interrupt or CPU state changes
+FUSION_EXCLUDED = {"CALL", "RET", "RETI", "RST", "PUSH", "POP", "HALT", "STOP", "EI", "DI", "PREFIX"}
+FUSION_BRANCHES = {"JR", "JP"}
+# Register pairs a superinstruction may address memory through (MicroOp::fused_access)
+FUSION_MAX_PAIRS = 2
+PAIRS = {"B": "BC", "C": "BC", "D": "DE", "E": "DE", "H": "HL", "L": "HL"}
+
+
+def parse_sequence(sequence):
+    """Parse a profile sequence like "05 20" or "CB7C 20" into (prefixed, opcode) tuples."""
+    ops = []
+    for op in sequence.split():
+        prefixed = op.upper().startswith("CB") and len(op) == 4
+        ops.append((prefixed, int(op[2:] if prefixed else op, 16)))
+    return ops
+
+
+def read_fusion_profiles(paths):
+    """Sum the execution counts of the sequences of one or more profiles."""
+    counts = {}
+    for path in paths:
+        with open(path, newline="") as f:
+            for row in csv.DictReader(f):
+                ops = tuple(parse_sequence(row["sequence"]))
+                counts[ops] = counts.get(ops, 0) + int(row["count"])
+    return counts
+
+
+def _written_pairs(info):
+    """Register pairs written by an instruction, as far as memory addressing is concerned."""
+    ops = info.get("operands", [])
+    written = set()
+    for op in ops:
+        if op.get("increment", False) or op.get("decrement", False):
+            written.add("HL")
+    # The destination is the first operand, or the register of RES and SET
+    dst = ops[1] if info["mnemonic"] in ("RES", "SET") and len(ops) == 2 else (ops or [None])[0]
+    if dst is not None and info["mnemonic"] not in ("BIT", "CP") and dst.get("immediate", False):
+        name = dst["name"]
+        if name in ("BC", "DE", "HL"):
+            written.add(name)
+        elif name in PAIRS:
+            written.add(PAIRS[name])
+    return written
+
+
+def _memory_pair(info):
+    """Register pair used to address memory by an instruction, or None."""
+    for op in info.get("operands", []):
+        if not op.get("immediate", False) and op["name"] in ("BC", "DE", "HL"):
+            return op["name"]
+    return None
+
+
+def is_fusable(sequence, data):
+    """
+    Whether a sequence of opcodes can run as a single superinstruction.
+
+    Mirrors the checks done by BlockCache when decoding: only the last instruction may jump, the
+    whole sequence can address memory through up to two register pairs which must not be changed
+    before they are used, and the operands of the sequence must fit a micro-op (2 bytes).
+    """
+    pairs = set()
+    written = set()
+    operand_bytes = 0
+    for i, (prefixed, opcode) in enumerate(sequence):
+        info = data["cbprefixed" if prefixed else "unprefixed"][f"0x{opcode:02X}"]
+        mnemonic = info["mnemonic"]
+        if mnemonic in FUSION_EXCLUDED or mnemonic.startswith("ILLEGAL"):
+            return False
+        if mnemonic in FUSION_BRANCHES and i != len(sequence) - 1:
+            return False
+
+        mem_pair = _memory_pair(info)
+        if mem_pair is not None:
+            pairs.add(mem_pair)
+            if len(pairs) > FUSION_MAX_PAIRS or mem_pair in written:
+                return False
+        written |= _written_pairs(info)
+
+        if not prefixed:
+            operand_bytes += info["bytes"] - 1
+    return operand_bytes <= 2
+
+
+def write_fusion(data, profile_paths, top, path, description="Superinstructions"):
+    """
+    Write the superinstructions for the most executed fusable sequences of the profiles.
+
+    Each entry fuses the handlers of a sequence into a Cpu::fused instantiation:
+    {.ops = {0x005, 0x020, NoFusedOpcode}, .length = 2, .handler = &Cpu::fused<...>}, // DEC B; JR NZ, e8
+    """
+    counts = read_fusion_profiles(profile_paths)
+    sequences = [
+        (count, ops)
+        for ops, count in counts.items()
+        if 2 <= len(ops) <= 3 and is_fusable(ops, data)
+    ]
+    # Longer sequences first, a pair always run within the same triple is redundant
+    sequences.sort(key=lambda x: (-x[0], -len(x[1]), x[1]))
+    triples = {ops[:2]: count for count, ops in sequences if len(ops) == 3}
+    sequences = [
+        (count, ops)
+        for count, ops in sequences
+        if len(ops) == 3 or triples.get(ops, 0) < count
+    ]
+
+    with open(path, "w") as f:
+        write_file_header(f, description, ", ".join(Path(p).name for p in profile_paths))
+        for count, ops in sequences[:top]:
+            codes = []
+            steps = []
+            mnemonics = []
+            for prefixed, opcode in ops:
+                info = data["cbprefixed" if prefixed else "unprefixed"][f"0x{opcode:02X}"]
+                handler = get_handler(info["mnemonic"], info.get("operands", []))
+                codes.append(f"0x{(0x100 if prefixed else 0) | opcode:03X}")
+                steps.append(f"FusedStep{{&Cpu::{handler}, {'true' if prefixed else 'false'}}}")
+                mnemonics.append(get_mnemonic(info["mnemonic"], info.get("operands", [])))
+            codes += ["NoFusedOpcode"] * (3 - len(codes))
+
+            f.write(f"// {'; '.join(mnemonics)} ({count} executions)\n")
+            f.write(
+                f"{{.ops = {{{', '.join(codes)}}}, .length = {len(ops)}, "
+                f".handler = &Cpu::fused<{', '.join(steps)}>}},\n"
+            )
+    print(f"[INFO] Wrote {min(top, len(sequences))} superinstructions to {path}")
+
+
+# Memory operands addressing modes, as MicroAddr values
+MICRO_ADDRS = {"BC": "BC", "DE": "DE", "HL": "HL", "a16": "A16", "a8": "A8", "C": "C"}
+# Read-modify-write instructions on their memory operand
+MICRO_RMW = {"INC", "DEC", "RES", "SET"} | CB_SHIFT_OPS
+
+
+def _micro(action, addr=None):
+    return (action, addr)
+
+
+def get_microprogram(info, prefixed):
+    """
+    Split an instruction into one step per M-cycle after its opcode fetch(es).
+
+    Steps are Fetch (operand byte at PC), Read, Write and Internal, plus Execute which runs the
+    instruction handler within the M-cycle of the step before it (or after it if first) without
+    taking one. Steps of a taken branch follow the non-branch ones.
+
+    Returns (steps, mcycles) with mcycles the M-cycles of the non-branch steps, or ([], 0) for
+    instructions executed at once when their last M-cycle ends (single M-cycle ones and the
+    ones whose timing doesn't match the model, e.g. STOP).
+    """
+    mnemonic = info["mnemonic"]
+    ops = info.get("operands", [])
+    (cycles, cycles_no_branch) = get_cycles(info.get("cycles", []))
+    mcycles = (cycles_no_branch or cycles) // 4 - (2 if prefixed else 1)
+    taken_mcycles = (cycles - cycles_no_branch) // 4 if cycles_no_branch else 0
+    conditional = cycles_no_branch != 0
+
+    fetches = [_micro("Fetch")] * (0 if prefixed else info["bytes"] - 1)
+    steps = []
+    taken = []
+
+    if mnemonic in ("PUSH", "RST"):
+        steps = [_micro("Internal"), _micro("Execute"), _micro("Write", "SP"), _micro("Write", "SP")]
+    elif mnemonic == "CALL":
+        stack = [_micro("Internal"), _micro("Write", "SP"), _micro("Write", "SP")]
+        steps = fetches + [_micro("Execute")] + ([] if conditional else stack)
+        taken = stack if conditional else []
+    elif mnemonic == "POP":
+        steps = [_micro("Read", "SP"), _micro("Read", "SP"), _micro("Execute")]
+    elif mnemonic in ("RET", "RETI") and not conditional:
+        steps = [_micro("Read", "SP"), _micro("Read", "SP"), _micro("Execute"), _micro("Internal")]
+    elif mnemonic == "RET":
+        # The condition is checked before popping, the handler pops when executed
+        steps = [_micro("Internal"), _micro("Execute")]
+        taken = [_micro("Internal")] * taken_mcycles
+    elif mnemonic == "LD" and len(ops) == 2 and ops[0]["name"] == "a16" and ops[1]["name"] == "SP":
+        steps = fetches + [_micro("Execute"), _micro("Write", "A16"), _micro("Write", "A16")]
+    else:
+        reads = []
+        writes = []
+        for i, op in enumerate(ops):
+            addr = MICRO_ADDRS.get(op["name"])
+            if op.get("immediate", False) or addr is None:
+                continue
+            # The destination is the first operand, the bit number comes first for CB bit ops
+            is_dst = i == 0 and mnemonic not in CB_BIT_OPS
+            if mnemonic in MICRO_RMW:
+                reads.append(_micro("Read", addr))
+                writes.append(_micro("Write", addr))
+            elif is_dst:
+                writes.append(_micro("Write", addr))
+            else:
+                reads.append(_micro("Read", addr))
+        steps = fetches + reads + [_micro("Execute")] + writes
+        internal = mcycles - len(fetches) - len(reads) - len(writes)
+        steps += [_micro("Internal")] * max(internal, 0)
+        taken = [_micro("Internal")] * taken_mcycles
+
+    # Validate the model against the instruction cycles
+    count = sum(1 for (action, _) in steps if action != "Execute")
+    if count != mcycles or len(taken) != taken_mcycles or mcycles <= 0:
+        return ([], 0)
+    return (steps + taken, mcycles)
+
+
+def write_microcode(opcodes, path, prefixed, description="Microprograms"):
+    """
+    Write the microprogram table to a file.
+
+    table[0x34] = {.steps = {{{MicroAction::Read, MicroAddr::HL}, {MicroAction::Execute},
+                   {MicroAction::Write, MicroAddr::HL}}}, .length = 3, .mcycles = 2,
+                   .operands = 0}; // INC [HL]
+    """
+    with open(path, "w") as f:
+        write_file_header(f, description, JSON_FILE.name)
+        for code_str, info in sorted(opcodes.items(), key=lambda x: int(x[0], 16)):
+            code = int(code_str, 16)
+            (steps, mcycles) = get_microprogram(info, prefixed)
+            if not steps:
+                continue
+            entries = []
+            for action, addr in steps:
+                if addr is None:
+                    entries.append(f"{{MicroAction::{action}}}")
+                else:
+                    entries.append(f"{{MicroAction::{action}, MicroAddr::{addr}}}")
+            mnemonic = get_mnemonic(info["mnemonic"], info.get("operands", []))
+            operands = 0 if prefixed else info["bytes"] - 1
+            f.write(
+                f"table[0x{code:02X}] = {{.steps = {{{{{', '.join(entries)}}}}}, "
+                f".length = {len(steps)}, .mcycles = {mcycles}, "
+                f".operands = {operands}}}; // {mnemonic}\n"
+            )
+    print(f"[INFO] Wrote microprograms to {path}")
+
+
 # generate enum class Opcode and enum class CBOpcode
 def write_opcode_enums(opcodes, path, cbprefix=False, description="Opcode Enums"):
     """Generate enum class for opcodes."""
@@ -232,16 +658,35 @@ def main():
     parser = argparse.ArgumentParser(
         description="Generate opcode tables and CPU instruction declarations/implementations from a JSON file."
     )
-    parser.add_argument("--table", action="store_true", help="Generate opcode tables")
+    parser.add_argument("--table", action="store_true", help="Generate instruction metadata tables")
+    parser.add_argument(
+        "--dispatch", action="store_true", help="Generate opcode switch dispatch"
+    )
     parser.add_argument(
         "--decls", action="store_true", help="Generate CPU instruction declarations"
     )
     parser.add_argument(
         "--impls",
         action="store_true",
-        help="Generate CPU instruction implementations stubs",
+        help="Generate CPU instruction instantiations and implementations stubs",
     )
     parser.add_argument("--enums", action="store_true", help="Generate opcode enums")
+    parser.add_argument(
+        "--microcode", action="store_true", help="Generate M-cycle microprograms"
+    )
+    parser.add_argument(
+        "--fusion",
+        nargs="+",
+        metavar="PROFILE",
+        help="Generate superinstructions from sequence profiles (CSV)",
+    )
+    parser.add_argument(
+        "--fusion-top",
+        type=int,
+        default=64,
+        metavar="N",
+        help="Number of superinstructions to generate (default: 64)",
+    )
     parser.add_argument("--all", action="store_true", help="Generate all files")
     args = parser.parse_args()
 
@@ -252,15 +697,22 @@ def main():
     check_duplicates(data["cbprefixed"], "CB-prefixed")
 
     if args.table or args.all:
-        write_table(
+        write_tables(
+            data,
+            PUBLIC_OUTPUT_DIR / "instruction_tables.inc",
+            PUBLIC_OUTPUT_DIR / "instruction_metadata.inc",
+        )
+
+    if args.dispatch or args.all:
+        write_dispatch(
             data["unprefixed"],
-            PRIVATE_OUTPUT_DIR / "opcodes.inc",
-            "Opcode table for InstructionsTable (unprefixed)",
+            PRIVATE_OUTPUT_DIR / "dispatch.inc",
+            "Opcode switch dispatch for Cpu::dispatch (unprefixed)",
         )
-        write_table(
+        write_dispatch(
             data["cbprefixed"],
-            PRIVATE_OUTPUT_DIR / "cbopcodes.inc",
-            "Opcode table for InstructionsTable (CB-prefixed)",
+            PRIVATE_OUTPUT_DIR / "cbdispatch.inc",
+            "Opcode switch dispatch for Cpu::dispatch_cb (CB-prefixed)",
         )
 
     if args.decls or args.all:
@@ -279,12 +731,12 @@ def main():
         write_cpu_impls(
             data["unprefixed"],
             PRIVATE_OUTPUT_DIR / "cpu_opcodes_impl.inc",
-            "CPU stub implementations (unprefixed)",
+            "CPU handler instantiations and stub implementations (unprefixed)",
         )
         write_cpu_impls(
             data["cbprefixed"],
             PRIVATE_OUTPUT_DIR / "cpu_cbopcodes_impl.inc",
-            "CPU stub implementations (CB-prefixed)",
+            "CPU handler instantiations and stub implementations (CB-prefixed)",
         )
 
     if args.enums or args.all:
@@ -302,6 +754,32 @@ def main():
             description="Opcode Enums (CB-prefixed)",
         )
 
+    if args.microcode or args.all:
+        write_microcode(
+            data["unprefixed"],
+            PRIVATE_OUTPUT_DIR / "microcode.inc",
+            prefixed=False,
+            description="Microprograms for MicrocodeTable (unprefixed)",
+        )
+        write_microcode(
+            data["cbprefixed"],
+            PRIVATE_OUTPUT_DIR / "cbmicrocode.inc",
+            prefixed=True,
+            description="Microprograms for MicrocodeTable (CB-prefixed)",
+        )
+
+    fusion_profiles = args.fusion
+    if fusion_profiles is None and args.all and FUSION_PROFILE.exists():
+        fusion_profiles = [FUSION_PROFILE]
+    if fusion_profiles:
+        write_fusion(
+            data,
+            fusion_profiles,
+            args.fusion_top,
+            PRIVATE_OUTPUT_DIR / "fused.inc",
+            "Superinstructions for FusionTable",
+        )
+
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,54 @@
+/**
+ * @file trace_command.cpp
+ * @brief Trace command for the BoyBoy emulator.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include "boyboy/app/commands/trace_command.h"
+
+#include <iostream>
+#include <string>
+
+#include "boyboy/app/app.h"
+#include "boyboy/app/commands/command_registry.h"
+#include "boyboy/core/cpu/instructions.h"
+#include "boyboy/core/cpu/instructions_table.h"
+#include "boyboy/core/cpu/trace_buffer.h"
+
+namespace boyboy::app::commands {
+
+using boyboy::core::cpu::InstructionTable;
+using boyboy::core::cpu::InstructionType;
+using boyboy::core::cpu::TraceBuffer;
+
+namespace {
+REGISTER_COMMAND(TraceCommand);
+}
+
+int TraceCommand::execute([[maybe_unused]] App& app, [[maybe_unused]] const CommandContext& context)
+{
+    auto records = TraceBuffer::load(trace_path_);
+    if (!records) {
+        std::cerr << "Failed to load trace: " << records.error().error_message() << "\n";
+        return 1;
+    }
+
+    std::string line;
+    for (const auto& record : *records) {
+        line = TraceBuffer::to_doctor(record);
+        if (disassemble_) {
+            auto mnemonic =
+                (record.mem[0] == 0xCB)
+                    ? InstructionTable::mnemonic(InstructionType::CBPrefixed, record.mem[1])
+                    : InstructionTable::mnemonic(InstructionType::Unprefixed, record.mem[0]);
+            line += " ; ";
+            line += mnemonic;
+        }
+        std::cout << line << "\n";
+    }
+
+    return 0;
+}
+
+} // namespace boyboy::app::commands
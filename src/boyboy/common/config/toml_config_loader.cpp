@@ -30,10 +30,11 @@ inline static constexpr std::string_view ConfigHeader = R"(# BoyBoy Emulator Con
 #       0 = uncapped
 #       1..10 = speed multiplier
 #       default: 1
-#   tick_mode: fast | normal | precision
+#   tick_mode: fast | normal | precision | catchup
 #       fast = tick per instruction
 #       normal = tick every M-cycle
 #       precision = tick every T-cycle
+#       catchup = tick per instruction, peripherals caught up on timed memory accesses
 #       default: fast
 #   cpu_overlap: true/false
 #       default: false
@@ -56,6 +57,12 @@ inline static constexpr std::string_view ConfigHeader = R"(# BoyBoy Emulator Con
 # [debug] - logging and debug options
 #   log_level: trace | debug | info | warn | error | critical | off
 #       default: info
+#   instrumentation: true/false (per-frame counters and profiling hooks)
+#       default: false
+#   trace: true/false (binary CPU trace of the last executed instructions, see `boyboy trace`)
+#       default: false
+#   coverage: true/false (executed code bitmap per ROM bank, written with a summary on exit)
+#       default: false
 #
 # For more information and bug reports: https://github.com/sebdevnull/boyboy
 # License: GNU GPLv3 - https://www.gnu.org/licenses/gpl-3.0.html
@@ -121,6 +128,36 @@ const toml::table& get_section(const toml::table& tbl, std::string_view section)
         ConfigKeys::Emulator::FetchExecOverlap,
         ConfigKeys::Emulator::Section
     );
+    load_field(
+        config.emulator.block_cache,
+        emulator_tbl,
+        ConfigKeys::Emulator::BlockCache,
+        ConfigKeys::Emulator::Section
+    );
+    load_field(
+        config.emulator.block_batching,
+        emulator_tbl,
+        ConfigKeys::Emulator::BlockBatching,
+        ConfigKeys::Emulator::Section
+    );
+    load_field(
+        config.emulator.idle_loop_skip,
+        emulator_tbl,
+        ConfigKeys::Emulator::IdleLoopSkip,
+        ConfigKeys::Emulator::Section
+    );
+    load_field(
+        config.emulator.superinstructions,
+        emulator_tbl,
+        ConfigKeys::Emulator::Superinstructions,
+        ConfigKeys::Emulator::Section
+    );
+    load_field(
+        config.emulator.microcode,
+        emulator_tbl,
+        ConfigKeys::Emulator::Microcode,
+        ConfigKeys::Emulator::Section
+    );
 
     auto video_tbl = get_section(tbl, ConfigKeys::Video::Section);
     load_field(config.video.scale, video_tbl, ConfigKeys::Video::Scale, ConfigKeys::Video::Section);
@@ -141,6 +178,16 @@ const toml::table& get_section(const toml::table& tbl, std::string_view section)
     load_field(
         config.debug.log_level, debug_tbl, ConfigKeys::Debug::LogLevel, ConfigKeys::Debug::Section
     );
+    load_field(
+        config.debug.instrumentation,
+        debug_tbl,
+        ConfigKeys::Debug::Instrumentation,
+        ConfigKeys::Debug::Section
+    );
+    load_field(config.debug.trace, debug_tbl, ConfigKeys::Debug::Trace, ConfigKeys::Debug::Section);
+    load_field(
+        config.debug.coverage, debug_tbl, ConfigKeys::Debug::Coverage, ConfigKeys::Debug::Section
+    );
 
     // Validate and normalize config
     auto result = ConfigValidator::validate(config, normalize);
@@ -156,6 +203,11 @@ void TomlConfigLoader::save(const Config& config, std::ostream& output) const
         {ConfigKeys::Emulator::Speed, config.emulator.speed},
         {ConfigKeys::Emulator::TickMode, config.emulator.tick_mode},
         {ConfigKeys::Emulator::FetchExecOverlap, config.emulator.fe_overlap},
+        {ConfigKeys::Emulator::BlockCache, config.emulator.block_cache},
+        {ConfigKeys::Emulator::BlockBatching, config.emulator.block_batching},
+        {ConfigKeys::Emulator::IdleLoopSkip, config.emulator.idle_loop_skip},
+        {ConfigKeys::Emulator::Superinstructions, config.emulator.superinstructions},
+        {ConfigKeys::Emulator::Microcode, config.emulator.microcode},
     };
     auto video_tbl = toml::table{
         {ConfigKeys::Video::Scale, config.video.scale},
@@ -167,6 +219,9 @@ void TomlConfigLoader::save(const Config& config, std::ostream& output) const
     };
     auto debug_tbl = toml::table{
         {ConfigKeys::Debug::LogLevel, std::string(config.debug.log_level)},
+        {ConfigKeys::Debug::Instrumentation, config.debug.instrumentation},
+        {ConfigKeys::Debug::Trace, config.debug.trace},
+        {ConfigKeys::Debug::Coverage, config.debug.coverage},
     };
 
     auto config_tbl = toml::table{
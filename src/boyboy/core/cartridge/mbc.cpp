@@ -107,6 +107,30 @@ void Mbc::unload_banks()
     return 0xFF;
 }
 
+[[nodiscard]] const uint8_t* Mbc::rom_page(uint16_t addr) const
+{
+    // Offset of the page within its 16KB bank
+    auto offset = static_cast<uint16_t>(addr & (RomBankSize - 1) & 0xFF00);
+
+    if (!rom_banks_.empty() && addr >= mmu::ROMBank0Start && addr <= mmu::ROMBank0End) {
+        return rom_banks_.front().data() + offset;
+    }
+    if (rom_bank_cnt_ > 1 && addr >= mmu::ROMBank1Start && addr <= mmu::ROMBank1End) {
+        return selected_rom_bank().data() + offset;
+    }
+
+    return nullptr;
+}
+
+[[nodiscard]] const uint8_t* Mbc::ram_page(uint16_t addr) const
+{
+    if (ram_enable_ && ram_bank_cnt_ > 0 && addr >= mmu::SRAMStart && addr <= mmu::SRAMEnd) {
+        return selected_ram_bank().data() + ((addr - mmu::SRAMStart) & 0xFF00);
+    }
+
+    return nullptr;
+}
+
 void Mbc::write(uint16_t addr, uint8_t value)
 {
     if (type_ != MbcType::MBC1) {
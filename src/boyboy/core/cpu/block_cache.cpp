@@ -0,0 +1,457 @@
+/**
+ * @file block_cache.cpp
+ * @brief Predecoded basic-block cache for the BoyBoy CPU interpreter.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include "boyboy/core/cpu/block_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "boyboy/common/log/logging.h"
+#include "boyboy/core/cpu/cpu_constants.h"
+#include "boyboy/core/cpu/fusion.h"
+#include "boyboy/core/cpu/instructions.h"
+#include "boyboy/core/cpu/instructions_table.h"
+#include "boyboy/core/mmu/constants.h"
+#include "boyboy/core/mmu/mmu.h"
+
+namespace boyboy::core::cpu {
+
+using namespace boyboy::common;
+
+namespace {
+
+// Cacheable memory region containing an address
+struct CodeRegion {
+    uint16_t bank;
+    uint16_t end;
+    bool ram;
+};
+
+[[nodiscard]] std::optional<CodeRegion> code_region(uint16_t pc, const mmu::Mmu& mmu)
+{
+    if (pc <= mmu::ROMBank0End) {
+        return CodeRegion{.bank = 0, .end = mmu::ROMBank0End, .ram = false};
+    }
+    if (pc <= mmu::ROMBank1End) {
+        return CodeRegion{.bank = mmu.rom_bank(), .end = mmu::ROMBank1End, .ram = false};
+    }
+    if (pc >= mmu::WRAMStart && pc <= mmu::WRAMEnd) {
+        return CodeRegion{.bank = 0, .end = mmu::WRAMEnd, .ram = true};
+    }
+    if (pc >= mmu::HRAMStart && pc <= mmu::HRAMEnd) {
+        return CodeRegion{.bank = 0, .end = mmu::HRAMEnd, .ram = true};
+    }
+    return std::nullopt;
+}
+
+[[nodiscard]] constexpr uint32_t block_key(uint16_t bank, uint16_t pc)
+{
+    return (static_cast<uint32_t>(bank) << 16) | pc;
+}
+
+// Whether an instruction writes memory, e.g. LD [HL], A or RES 0, [HL] but not LD A, [HL]
+[[nodiscard]] bool writes_memory(const Instruction& instr, InstructionType type)
+{
+    std::string_view mnemonic = instr.mnemonic;
+    if (type == InstructionType::CBPrefixed) {
+        return mnemonic.contains('[') && !mnemonic.starts_with("BIT");
+    }
+    auto space = mnemonic.find(' ');
+    return space != std::string_view::npos && mnemonic.substr(space + 1).starts_with('[');
+}
+
+// Memory accessed by an instruction, static addresses are resolved from its operands
+[[nodiscard]] MemAccess mem_access(const Instruction& instr, const MicroOp& op)
+{
+    constexpr std::array<std::string_view, 6> UnsafePrefixes = {
+        "EI", "DI", "RETI", "HALT", "STOP", "ILLEGAL"
+    };
+    constexpr std::array<std::string_view, 5> StackPrefixes = {"PUSH", "POP", "CALL", "RET", "RST"};
+
+    std::string_view mnemonic = instr.mnemonic;
+    auto starts_with_any = [mnemonic](const auto& prefixes) {
+        return std::ranges::any_of(prefixes, [mnemonic](std::string_view prefix) {
+            return mnemonic.starts_with(prefix);
+        });
+    };
+
+    if (starts_with_any(UnsafePrefixes)) {
+        return MemAccess::Unsafe;
+    }
+    if (starts_with_any(StackPrefixes)) {
+        return MemAccess::SP;
+    }
+    if (mnemonic.contains("[HL")) {
+        return MemAccess::HL;
+    }
+    if (mnemonic.contains("[BC]")) {
+        return MemAccess::BC;
+    }
+    if (mnemonic.contains("[DE]")) {
+        return MemAccess::DE;
+    }
+
+    // IO writes may raise interrupts, IO reads can't
+    auto io_access = writes_memory(instr, op.type) ? MemAccess::Unsafe : MemAccess::IoRead;
+    if (mnemonic.contains("[a8]")) {
+        uint16_t addr = 0xFF00 | op.operands[0];
+        return is_plain_memory(addr) ? MemAccess::None : io_access;
+    }
+    if (mnemonic.contains("[a16]")) {
+        uint16_t addr = (static_cast<uint16_t>(op.operands[1]) << 8) | op.operands[0];
+        return (is_plain_memory(addr) && is_plain_memory(addr + 1)) ? MemAccess::None : io_access;
+    }
+    if (mnemonic.contains('[')) {
+        return io_access; // [C]
+    }
+    return MemAccess::None;
+}
+
+// Instructions that may not fall through to the next address end the block
+[[nodiscard]] bool ends_block(const Instruction& instr)
+{
+    constexpr std::array<std::string_view, 8> Terminators = {
+        "JP", "JR", "CALL", "RET", "RST", "HALT", "STOP", "ILLEGAL"
+    };
+    return std::ranges::any_of(Terminators, [&instr](std::string_view prefix) {
+        return instr.mnemonic.starts_with(prefix);
+    });
+}
+
+// Register pairs accessed by a superinstruction, or Unsafe if its micro-ops can't be fused
+[[nodiscard]] std::array<MemAccess, 2> fused_access(std::span<const MicroOp> ops)
+{
+    constexpr std::array<MemAccess, 2> Unsafe = {MemAccess::Unsafe, MemAccess::Unsafe};
+
+    std::array<MemAccess, 2> access{};
+    size_t count = 0;
+    for (size_t i = 0; i < ops.size(); ++i) {
+        auto op_access = ops[i].access;
+        if (op_access == MemAccess::None) {
+            continue;
+        }
+
+        // Only the first micro-op may read IO, the others run after it with no peripheral sync
+        bool io_read = op_access == MemAccess::IoRead && i == 0;
+        bool pair = op_access == MemAccess::HL || op_access == MemAccess::BC ||
+                    op_access == MemAccess::DE;
+        if (!io_read && !pair) {
+            return Unsafe;
+        }
+        if (std::ranges::find(access, op_access) != access.end()) {
+            continue;
+        }
+        if (count == access.size()) {
+            return Unsafe;
+        }
+        access.at(count++) = op_access;
+    }
+    return access;
+}
+
+[[nodiscard]] std::vector<FusedOpcode> block_opcodes(const Block& block)
+{
+    std::vector<FusedOpcode> opcodes;
+    opcodes.reserve(block.ops.size());
+    for (const auto& op : block.ops) {
+        opcodes.push_back(fused_opcode(op.type, op.opcode));
+    }
+    return opcodes;
+}
+
+} // namespace
+
+BlockCache::~BlockCache()
+{
+    if (enabled_) {
+        enable(false);
+    }
+}
+
+void BlockCache::enable(bool enable)
+{
+    if (enable == enabled_) {
+        return;
+    }
+
+    if (enable) {
+        mmu_.set_code_write_callback([this](uint16_t addr) { invalidate(addr); });
+        watch_rom(true);
+    }
+    else {
+        clear();
+        watch_rom(false);
+        mmu_.set_code_write_callback(nullptr);
+    }
+    enabled_ = enable;
+
+    log::debug("CPU block cache {}", enable ? "enabled" : "disabled");
+}
+
+void BlockCache::enable_fusion(bool enable)
+{
+    if (enable == fusion_) {
+        return;
+    }
+    clear();
+    fusion_ = enable;
+
+    log::debug("CPU superinstructions {}", enable ? "enabled" : "disabled");
+}
+
+const MicroOp* BlockCache::next(uint16_t pc)
+{
+    if (current_ != nullptr) {
+        // Fall through to the next micro-op of the current block
+        if (index_ < current_->ops.size() && current_->ops[index_].pc == pc) {
+            return &current_->ops[index_++];
+        }
+        // Tight loops jumping back to the start of the current block
+        if (current_->start == pc) {
+            index_ = 1;
+            stats_.hits++;
+            current_->executions++;
+            return current_->ops.data();
+        }
+    }
+
+    current_ = lookup(pc);
+    if (current_ == nullptr) {
+        return nullptr;
+    }
+
+    index_ = 1;
+    current_->executions++;
+    return current_->ops.data();
+}
+
+const MicroOp* BlockCache::peek(uint16_t pc) const
+{
+    if (current_ == nullptr) {
+        return nullptr;
+    }
+    if (index_ < current_->ops.size() && current_->ops[index_].pc == pc) {
+        return &current_->ops[index_];
+    }
+    if (current_->start == pc) {
+        return current_->ops.data();
+    }
+    return nullptr;
+}
+
+void BlockCache::invalidate(uint16_t addr)
+{
+    current_ = nullptr;
+
+    // ROM writes only switch banks, blocks are keyed on the bank so they stay valid
+    if (addr <= mmu::ROMEnd) {
+        return;
+    }
+
+    auto page = static_cast<uint8_t>(addr >> 8);
+    for (auto key : page_blocks_.at(page)) {
+        if (auto it = blocks_.find(key); it != blocks_.end()) {
+            retire(it->second);
+            blocks_.erase(it);
+            stats_.invalidations++;
+        }
+    }
+    page_blocks_.at(page).clear();
+    mmu_.watch_code_page(page, false);
+}
+
+void BlockCache::clear()
+{
+    for (const auto& [key, block] : blocks_) {
+        retire(block);
+    }
+    blocks_.clear();
+    for (size_t page = 0; page < PageCount; ++page) {
+        if (!page_blocks_.at(page).empty()) {
+            page_blocks_.at(page).clear();
+            mmu_.watch_code_page(static_cast<uint8_t>(page), false);
+        }
+    }
+    current_ = nullptr;
+    index_ = 0;
+}
+
+const Block* BlockCache::lookup(uint16_t pc)
+{
+    // Trapped pages are left to the interpreter, which checks their fetches
+    auto region = code_region(pc, mmu_);
+    if (!region || mmu_.is_fetch_trapped(pc)) {
+        return nullptr;
+    }
+
+    auto key = block_key(region->bank, pc);
+    if (auto it = blocks_.find(key); it != blocks_.end()) {
+        stats_.hits++;
+        return &it->second;
+    }
+
+    Block block;
+    if (!decode(pc, region->end, region->ram, block)) {
+        return nullptr;
+    }
+    stats_.misses++;
+
+    // Code in RAM can be overwritten, track the pages it spans
+    if (region->ram) {
+        for (uint16_t page = block.start >> 8; page <= (block.end >> 8); ++page) {
+            page_blocks_.at(page).push_back(key);
+            mmu_.watch_code_page(static_cast<uint8_t>(page), true);
+        }
+    }
+
+    auto [it, inserted] = blocks_.emplace(key, std::move(block));
+    return &it->second;
+}
+
+bool BlockCache::decode(uint16_t pc, uint16_t region_end, bool ram, Block& block) const
+{
+    uint32_t addr = pc;
+
+    while (block.ops.size() < MaxBlockOps && addr <= region_end && !mmu_.is_fetch_trapped(addr)) {
+        MicroOp op{.pc = static_cast<uint16_t>(addr)};
+        op.opcode = mmu_.read_byte(addr);
+
+        if (op.opcode == CBInstructionPrefix) {
+            if (addr + 1 > region_end || mmu_.is_fetch_trapped(addr + 1)) {
+                break;
+            }
+            op.opcode = mmu_.read_byte(addr + 1);
+            op.type = InstructionType::CBPrefixed;
+        }
+
+        const auto& instr = InstructionTable::get_instruction(op.type, op.opcode);
+
+        // Never decode instructions straddling the end of the region or a trapped page
+        if (addr + instr.length - 1 > region_end ||
+            mmu_.is_fetch_trapped(addr + instr.length - 1)) {
+            break;
+        }
+
+        op.handler = instr.execute;
+        op.cycles = instr.cycles;
+        op.cycles_no_branch = instr.cycles_no_branch;
+        if (op.type == InstructionType::Unprefixed) {
+            for (uint8_t i = 1; i < instr.length; ++i) {
+                op.operands.at(i - 1) = mmu_.read_byte(addr + i);
+            }
+        }
+
+        op.access = mem_access(instr, op);
+
+        block.ops.push_back(op);
+        addr += instr.length;
+
+        if (ends_block(instr)) {
+            break;
+        }
+    }
+
+    block.start = pc;
+    block.end = static_cast<uint16_t>(addr - 1);
+
+    if (fusion_) {
+        fuse(block, ram);
+    }
+
+    return !block.ops.empty();
+}
+
+void BlockCache::fuse(Block& block, bool ram) const
+{
+    std::array<FusedOpcode, Superinstruction::MaxOps> opcodes{};
+
+    for (size_t i = 0; i + 1 < block.ops.size(); ++i) {
+        size_t count = std::min(opcodes.size(), block.ops.size() - i);
+        for (size_t j = 0; j < count; ++j) {
+            opcodes.at(j) = fused_opcode(block.ops[i + j].type, block.ops[i + j].opcode);
+        }
+
+        const auto* super = FusionTable::find(std::span(opcodes).first(count));
+        if (super == nullptr) {
+            continue;
+        }
+
+        std::span<const MicroOp> seq = std::span(block.ops).subspan(i, super->length);
+        auto access = fused_access(seq);
+        if (access[0] == MemAccess::Unsafe) {
+            continue;
+        }
+
+        MicroOp& first = block.ops[i];
+        const MicroOp& last = seq.back();
+        std::array<uint8_t, 2> operands{};
+        size_t operand_count = 0;
+        uint8_t cycles = 0;
+        bool fusable = true;
+
+        for (const auto& op : seq) {
+            const auto& instr = InstructionTable::get_instruction(op.type, op.opcode);
+            size_t op_operands = (op.type == InstructionType::Unprefixed) ? instr.length - 1 : 0;
+
+            // RAM code could be overwritten by the sequence itself
+            if ((ram && &op != &last && writes_memory(instr, op.type)) ||
+                operand_count + op_operands > operands.size()) {
+                fusable = false;
+                break;
+            }
+            for (size_t j = 0; j < op_operands; ++j) {
+                operands.at(operand_count++) = op.operands.at(j);
+            }
+            if (&op != &last) {
+                cycles = static_cast<uint8_t>(cycles + op.cycles);
+            }
+        }
+        if (!fusable) {
+            continue;
+        }
+
+        first.operands = operands;
+        first.fused = super->handler;
+        first.fused_count = super->length;
+        first.fused_cycles = static_cast<uint8_t>(cycles + last.cycles);
+        first.fused_cycles_no_branch =
+            (last.cycles_no_branch != 0) ? static_cast<uint8_t>(cycles + last.cycles_no_branch) : 0;
+        first.fused_tail = static_cast<uint8_t>(last.pc - first.pc);
+        first.fused_access = access;
+    }
+}
+
+SequenceProfile BlockCache::profile() const
+{
+    SequenceProfile profile = retired_;
+    for (const auto& [key, block] : blocks_) {
+        profile.add(block_opcodes(block), block.executions);
+    }
+    return profile;
+}
+
+void BlockCache::retire(const Block& block)
+{
+    if (block.executions != 0) {
+        retired_.add(block_opcodes(block), block.executions);
+    }
+}
+
+void BlockCache::watch_rom(bool watch)
+{
+    // Writes to ROM are MBC register writes that might switch the bank mapped at 0x4000-0x7FFF
+    for (uint16_t page = mmu::ROMStart >> 8; page <= (mmu::ROMEnd >> 8); ++page) {
+        mmu_.watch_code_page(static_cast<uint8_t>(page), watch);
+    }
+}
+
+} // namespace boyboy::core::cpu
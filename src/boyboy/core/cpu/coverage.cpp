@@ -0,0 +1,143 @@
+/**
+ * @file coverage.cpp
+ * @brief Executed code coverage bitmaps for the BoyBoy CPU.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include "boyboy/core/cpu/coverage.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <numeric>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "boyboy/common/files/errors.h"
+#include "boyboy/common/files/io.h"
+#include "boyboy/common/log/logging.h"
+#include "boyboy/core/mmu/constants.h"
+
+namespace boyboy::core::cpu {
+
+using namespace boyboy::common;
+
+namespace {
+
+[[nodiscard]] size_t count_bits(std::span<const CoverageMap::Word> bitmap)
+{
+    return std::accumulate(bitmap.begin(), bitmap.end(), size_t{0}, [](size_t sum, auto word) {
+        return sum + static_cast<size_t>(std::popcount(word));
+    });
+}
+
+[[nodiscard]] std::string summary_line(std::string_view name, size_t covered, size_t size)
+{
+    double percent = (size > 0) ? (100.0 * static_cast<double>(covered)) / static_cast<double>(size)
+                                : 0.0;
+    return std::format("{}: {:6}/{:5} bytes ({:6.2f}%)\n", name, covered, size, percent);
+}
+
+} // namespace
+
+void CoverageMap::enable(bool enable)
+{
+    enabled_ = enable;
+
+    log::debug("CPU coverage {}", enable ? "enabled" : "disabled");
+}
+
+void CoverageMap::set_rom_banks(size_t banks)
+{
+    rom_.resize(banks * RomBankWords);
+}
+
+void CoverageMap::clear()
+{
+    std::ranges::fill(rom_, 0);
+    wram_.fill(0);
+    hram_.fill(0);
+}
+
+void CoverageMap::grow(size_t offset)
+{
+    set_rom_banks((offset / RomBankSize) + 1);
+}
+
+bool CoverageMap::is_covered(uint16_t addr, uint16_t bank) const
+{
+    auto test = [](std::span<const Word> bitmap, size_t offset) {
+        return offset / WordBits < bitmap.size() &&
+               (bitmap[offset / WordBits] & (Word{1} << (offset % WordBits))) != 0;
+    };
+
+    if (addr <= mmu::ROMEnd) {
+        size_t offset = (addr <= mmu::ROMBank0End)
+                            ? addr
+                            : (bank * RomBankSize) + (addr - mmu::ROMBank1Start);
+        return test(rom_, offset);
+    }
+    if (addr >= mmu::WRAMStart && addr <= mmu::WRAMEnd) {
+        return test(wram_, addr - mmu::WRAMStart);
+    }
+    if (addr >= mmu::HRAMStart && addr <= mmu::HRAMEnd) {
+        return test(hram_, addr - mmu::HRAMStart);
+    }
+    return false;
+}
+
+size_t CoverageMap::covered_bytes(size_t bank) const
+{
+    if (bank >= rom_banks()) {
+        return 0;
+    }
+    return count_bits(std::span(rom_).subspan(bank * RomBankWords, RomBankWords));
+}
+
+std::string CoverageMap::summary() const
+{
+    std::string text;
+    size_t total = 0;
+    for (size_t bank = 0; bank < rom_banks(); ++bank) {
+        auto covered = covered_bytes(bank);
+        total += covered;
+        text += summary_line(std::format("ROM bank {:03}", bank), covered, RomBankSize);
+    }
+    text += summary_line("ROM total   ", total, rom_banks() * RomBankSize);
+    text += summary_line("WRAM        ", count_bits(wram_), mmu::WRAMSize);
+    text += summary_line("HRAM        ", count_bits(hram_), mmu::HRAMSize);
+    return text;
+}
+
+std::expected<void, files::FileError> CoverageMap::flush(const std::filesystem::path& path) const
+{
+    CoverageFileHeader header{
+        .magic = CoverageFileHeader::Magic,
+        .version = CoverageFileHeader::CurrentVersion,
+        .rom_banks = static_cast<uint16_t>(rom_banks()),
+        .reserved = 0,
+    };
+
+    std::vector<std::byte> data(sizeof(header));
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    auto append = [&data](std::span<const Word> bitmap) {
+        auto bytes = std::as_bytes(bitmap);
+        data.insert(data.end(), bytes.begin(), bytes.end());
+    };
+    append(rom_);
+    append(wram_);
+    append(hram_);
+
+    return files::write_binary(path, data);
+}
+
+} // namespace boyboy::core::cpu
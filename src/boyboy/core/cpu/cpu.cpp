@@ -7,7 +7,10 @@
 
 #include "boyboy/core/cpu/cpu.h"
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <utility>
 
 #include "boyboy/common/log/logging.h"
 #include "boyboy/common/utils.h"
@@ -15,7 +18,11 @@
 #include "boyboy/core/cpu/cycles.h"
 #include "boyboy/core/cpu/instructions.h"
 #include "boyboy/core/cpu/instructions_table.h"
+#include "boyboy/core/cpu/microcode.h"
 #include "boyboy/core/cpu/state.h"
+#include "boyboy/core/cpu/trace_buffer.h"
+#include "boyboy/core/io/io.h"
+#include "boyboy/core/mmu/constants.h"
 #include "boyboy/core/profiling/profiler_utils.h"
 
 namespace boyboy::core::cpu {
@@ -25,20 +32,27 @@ using namespace boyboy::common;
 void Cpu::init()
 {
     // Registers (init by default in DMG0 mode)
-    registers_.af = RegInitValues::Dmg0::AF;
-    registers_.bc = RegInitValues::Dmg0::BC;
-    registers_.de = RegInitValues::Dmg0::DE;
-    registers_.hl = RegInitValues::Dmg0::HL;
-    registers_.sp = RegInitValues::Dmg0::SP;
-    registers_.pc = RegInitValues::Dmg0::PC;
+    registers_.af(RegInitValues::Dmg0::AF);
+    registers_.bc(RegInitValues::Dmg0::BC);
+    registers_.de(RegInitValues::Dmg0::DE);
+    registers_.hl(RegInitValues::Dmg0::HL);
+    registers_.sp(RegInitValues::Dmg0::SP);
+    registers_.pc(RegInitValues::Dmg0::PC);
 
     // Reset flags and state
     ime_ = false;
     ime_scheduled_ = 0;
     halted_ = false;
+    halt_bug_ = false;
     cycles_ = 0;
     branch_taken_ = false;
     exec_state_.init();
+    block_cache_.clear();
+    operands_ = nullptr;
+    invalidate_fetch_page();
+    idle_loop_.reset();
+    trace_.clear();
+    coverage_.clear();
 }
 void Cpu::reset()
 {
@@ -47,104 +61,55 @@ void Cpu::reset()
 
 uint8_t Cpu::get_register(Reg8Name reg) const
 {
-    switch (reg) {
-        case Reg8Name::A:
-            return registers_.a();
-        case Reg8Name::F:
-            return registers_.f();
-        case Reg8Name::B:
-            return registers_.b();
-        case Reg8Name::C:
-            return registers_.c();
-        case Reg8Name::D:
-            return registers_.d();
-        case Reg8Name::E:
-            return registers_.e();
-        case Reg8Name::H:
-            return registers_.h();
-        case Reg8Name::L:
-            return registers_.l();
-        default:
-            return 0;
-    }
+    return registers_.get(reg);
 }
 
 uint16_t Cpu::get_register(Reg16Name reg) const
 {
-    switch (reg) {
-        case Reg16Name::AF:
-            return registers_.af;
-        case Reg16Name::BC:
-            return registers_.bc;
-        case Reg16Name::DE:
-            return registers_.de;
-        case Reg16Name::HL:
-            return registers_.hl;
-        case Reg16Name::SP:
-            return registers_.sp;
-        case Reg16Name::PC:
-            return registers_.pc;
-        default:
-            return 0;
-    }
+    return registers_.get(reg);
 }
 
 void Cpu::set_register(Reg8Name reg, uint8_t value)
 {
-    switch (reg) {
-        case Reg8Name::A:
-            registers_.a(value);
-            break;
-        case Reg8Name::F:
-            registers_.f(value);
-            break;
-        case Reg8Name::B:
-            registers_.b(value);
-            break;
-        case Reg8Name::C:
-            registers_.c(value);
-            break;
-        case Reg8Name::D:
-            registers_.d(value);
-            break;
-        case Reg8Name::E:
-            registers_.e(value);
-            break;
-        case Reg8Name::H:
-            registers_.h(value);
-            break;
-        case Reg8Name::L:
-            registers_.l(value);
-            break;
-        default:
-            break;
-    }
+    registers_.set(reg, value);
 }
 
 void Cpu::set_register(Reg16Name reg, uint16_t value)
 {
-    switch (reg) {
-        case Reg16Name::AF:
-            registers_.af = value;
-            break;
-        case Reg16Name::BC:
-            registers_.bc = value;
-            break;
-        case Reg16Name::DE:
-            registers_.de = value;
-            break;
-        case Reg16Name::HL:
-            registers_.hl = value;
-            break;
-        case Reg16Name::SP:
-            registers_.sp = value;
-            break;
-        case Reg16Name::PC:
-            registers_.pc = value;
-            break;
-        default:
-            break;
-    }
+    registers_.set(reg, value);
+}
+
+CpuState Cpu::snapshot() const
+{
+    CpuState state{
+        .registers = registers_,
+        .exec = exec_state_,
+        .cycles = cycles_,
+        .ime_scheduled = ime_scheduled_,
+        .ime = ime_,
+        .halted = halted_,
+        .halt_bug = halt_bug_,
+        .branch_taken = branch_taken_,
+    };
+    return state;
+}
+
+void Cpu::restore(const CpuState& state)
+{
+    registers_ = state.registers;
+    exec_state_ = state.exec;
+    cycles_ = state.cycles;
+    ime_scheduled_ = state.ime_scheduled;
+    ime_ = state.ime;
+    halted_ = state.halted;
+    halt_bug_ = state.halt_bug;
+    branch_taken_ = state.branch_taken;
+
+    // Drop anything derived from the previous state
+    operands_ = nullptr;
+    micro_ = {};
+    invalidate_fetch_page();
+    idle_loop_.reset();
 }
 
 void Cpu::set_halted(bool halted)
@@ -155,28 +120,164 @@ void Cpu::set_halted(bool halted)
     halted_ = halted;
 }
 
+void Cpu::enable_block_batching(bool enable)
+{
+    if (enable) {
+        block_cache_.enable(true);
+    }
+    block_batching_ = enable;
+    select_tick();
+}
+
+void Cpu::enable_fusion(bool enable)
+{
+    if (enable) {
+        block_cache_.enable(true);
+    }
+    block_cache_.enable_fusion(enable);
+}
+
 void Cpu::set_tick_mode(TickMode mode)
 {
     if (mode != tick_mode_) {
         log::debug("CPU ticking mode changed: {} -> {}", to_string(tick_mode_), to_string(mode));
     }
     tick_mode_ = mode;
+    select_tick();
+}
+
+void Cpu::enable_fe_overlap(bool enable)
+{
+    fe_overlap_ = enable;
+    select_tick();
+}
+
+void Cpu::enable_microcode(bool enable)
+{
+    if (enable != microcode_) {
+        log::debug("CPU microcode {}", enable ? "enabled" : "disabled");
+    }
+    microcode_ = enable;
+}
+
+StepKind Cpu::get_step_kind() const
+{
+    if (trace_.is_enabled() || coverage_.is_enabled()) {
+        return StepKind::Recorded;
+    }
+    if (block_batching_ && tick_mode_ == TickMode::Instruction) {
+        return StepKind::Batched;
+    }
+    return StepKind::Plain;
+}
+
+void Cpu::select_tick()
+{
+    bus_mode_ = (tick_mode_ == TickMode::CatchUp) ? BusMode::CatchUp : BusMode::Direct;
+    bool recorded = (get_step_kind() == StepKind::Recorded);
+    switch (tick_mode_) {
+        case TickMode::Instruction:
+            if (recorded) {
+                tick_fn_ = &Cpu::tick<TickMode::Instruction, false, StepKind::Recorded>;
+            }
+            else {
+                tick_fn_ = block_batching_
+                               ? &Cpu::tick<TickMode::Instruction, false, StepKind::Batched>
+                               : &Cpu::tick<TickMode::Instruction, false, StepKind::Plain>;
+            }
+            break;
+        case TickMode::CatchUp:
+            tick_fn_ = recorded ? &Cpu::tick<TickMode::CatchUp, false, StepKind::Recorded>
+                                : &Cpu::tick<TickMode::CatchUp, false, StepKind::Plain>;
+            break;
+        case TickMode::MCycle:
+            tick_fn_ = select_cycle_tick<TickMode::MCycle>(fe_overlap_, recorded);
+            break;
+        case TickMode::TCycle:
+            tick_fn_ = select_cycle_tick<TickMode::TCycle>(fe_overlap_, recorded);
+            break;
+    }
+}
+
+template <TickMode Mode>
+Cpu::TickFn Cpu::select_cycle_tick(bool fe_overlap, bool recorded)
+{
+    if (fe_overlap) {
+        return recorded ? &Cpu::tick<Mode, true, StepKind::Recorded>
+                        : &Cpu::tick<Mode, true, StepKind::Plain>;
+    }
+    return recorded ? &Cpu::tick<Mode, false, StepKind::Recorded>
+                    : &Cpu::tick<Mode, false, StepKind::Plain>;
 }
 
 TCycle Cpu::tick()
 {
     BB_PROFILE_SCOPE(profiling::FrameTimer::Cpu);
+    return (this->*tick_fn_)();
+}
+
+template <TickMode Mode, bool FeOverlap, StepKind Step>
+TCycle Cpu::tick()
+{
+    static_assert(
+        (Mode != TickMode::Instruction && Mode != TickMode::CatchUp) || !FeOverlap,
+        "No overlap in instruction modes"
+    );
+    static_assert(
+        Mode == TickMode::Instruction || Step != StepKind::Batched,
+        "Batches only run in instruction mode"
+    );
 
-    if (tick_mode_ == TickMode::Instruction) {
-        return step();
+    if constexpr (Step == StepKind::Batched) {
+        return step_batch();
+    }
+    else if constexpr (Mode == TickMode::Instruction) {
+        return step<Mode, Step>();
+    }
+    else if constexpr (Mode == TickMode::CatchUp) {
+        // Peripherals were already ticked up to the last timed access of the instruction
+        synced_cycles_ = 0;
+        time_instruction(0);
+        TCycle cycles = step<Mode, Step>();
+        return cycles - synced_cycles_;
+    }
+    else {
+        constexpr auto TickCycles = tickmode_to_cycles(Mode);
+        tick_cycles<FeOverlap, Step>(TickCycles);
+        return to_tcycles(TickCycles);
+    }
+}
+
+TCycle Cpu::fast_forward(TCycle cycles)
+{
+    if (!halted_ || is_ime_scheduled() || interrupt_handler_.should_wake_up() ||
+        exec_state_.has_stage(Stage::InterruptService)) {
+        return 0;
     }
 
-    auto cycles = tickmode_to_cycles(tick_mode_);
-    tick_cycles(cycles);
+    // A halted CPU idles 4 cycles per step in instruction modes
+    TCycle granularity = is_instruction_stepped(tick_mode_)
+                             ? FetchCycles
+                             : to_tcycles(tickmode_to_cycles(tick_mode_));
+    cycles = ((cycles + granularity - 1) / granularity) * granularity;
 
-    return to_tcycles(cycles);
+    cycles_ += cycles;
+    return cycles;
 }
 
+TCycle Cpu::skip_idle_loop(TCycle cycles_to_event, TCycle max_cycles)
+{
+    if (!idle_loop_.is_at_head(registers_.pc(), cycles_) || halt_bug_ || is_ime_scheduled() ||
+        interrupt_handler_.should_service()) {
+        return 0;
+    }
+
+    auto skipped = idle_loop_.skip(cycles_to_event, max_cycles);
+    cycles_ += skipped;
+    return skipped;
+}
+
+template <TickMode Mode, StepKind Step>
 inline uint8_t Cpu::step()
 {
     uint8_t cycles = interrupt_handler_.service();
@@ -191,16 +292,44 @@ inline uint8_t Cpu::step()
 #ifdef DISASSEMBLY_LOG
     trace();
 #endif
+    if constexpr (Step == StepKind::Recorded) {
+        if (trace_.is_enabled()) {
+            record_trace();
+        }
+        if (coverage_.is_enabled()) {
+            record_coverage();
+        }
+    }
+    if constexpr (Mode == TickMode::CatchUp) {
+        time_instruction(cycles);
+    }
 
-    uint8_t opcode = fetch();
+    uint8_t opcode{};
     InstructionType instr_type = InstructionType::Unprefixed;
-
-    if (opcode == CBInstructionPrefix) {
+    uint16_t pc = registers_.pc();
+
+    // The HALT bug repeats the next opcode fetch, leave it to the interpreter
+    const MicroOp* op = (block_cache_.is_enabled() && !halt_bug_)
+                            ? block_cache_.next(registers_.pc())
+                            : nullptr;
+
+    if (op != nullptr) {
+        opcode = op->opcode;
+        instr_type = op->type;
+        // Traces and coverage need every instruction, catch-up timing the accesses of every
+        // instruction
+        constexpr bool Fuse = (Mode == TickMode::Instruction && Step != StepKind::Recorded);
+        cycles += execute<Fuse>(*op, pc);
+    }
+    else {
         opcode = fetch();
-        instr_type = InstructionType::CBPrefixed;
+        if (opcode == CBInstructionPrefix) {
+            opcode = fetch();
+            instr_type = InstructionType::CBPrefixed;
+        }
+        cycles += execute(opcode, instr_type);
     }
-
-    cycles += execute(opcode, instr_type);
+    observe_branch(pc);
 
     // IME is enabled after the instruction following EI
     if (is_ime_scheduled() &&
@@ -212,6 +341,252 @@ inline uint8_t Cpu::step()
     return cycles;
 }
 
+inline TCycle Cpu::step_batch()
+{
+    // The first instruction takes care of interrupts, HALT and IME like a regular step
+    TCycle cycles = step<TickMode::Instruction, StepKind::Batched>();
+
+    // Batched micro-ops can't change the interrupt state (see MemAccess::Unsafe)
+    if (halted_ || halt_bug_ || is_ime_scheduled() || interrupt_handler_.should_service() ||
+        mmu_->watch_hit()) {
+        return cycles;
+    }
+
+    // Keep running the current block while peripherals can't observe the CPU running ahead. They
+    // only catch up after the batch: it ends on the instruction reaching their next event, so
+    // interrupts are raised and serviced on the same instruction as without batching.
+    auto limit = std::min<TCycle>(std::as_const(*mmu_).io()->cycles_to_event(), MaxBatchCycles);
+    while (cycles < limit) {
+        const MicroOp* op = block_cache_.peek(registers_.pc());
+        if (op == nullptr || !is_batchable(op->access)) {
+            break;
+        }
+        uint16_t pc = registers_.pc();
+        cycles += execute<true>(*block_cache_.next(pc), pc);
+        block_cache_.count_batched();
+
+        // Leave confirmed idle loops to the emulator, and watchpoint breaks to the caller
+        if (observe_branch(pc) || mmu_->watch_hit()) {
+            break;
+        }
+    }
+
+    return cycles;
+}
+
+inline bool Cpu::is_batchable(MemAccess access) const
+{
+    switch (access) {
+        case MemAccess::None:
+            return true;
+        case MemAccess::HL:
+            return is_plain_memory(registers_.hl());
+        case MemAccess::BC:
+            return is_plain_memory(registers_.bc());
+        case MemAccess::DE:
+            return is_plain_memory(registers_.de());
+        case MemAccess::SP:
+            return is_plain_memory(registers_.sp() - 2) && is_plain_memory(registers_.sp());
+        default:
+            return false;
+    }
+}
+
+inline bool Cpu::is_fusable(const MicroOp& op) const
+{
+    // IME must be enabled right after the instruction following EI
+    const auto& [first, second] = op.fused_access;
+    return op.fused != nullptr && !is_ime_scheduled() &&
+           (first == MemAccess::IoRead || is_batchable(first)) && is_batchable(second);
+}
+
+inline bool Cpu::observe_branch(uint16_t pc)
+{
+    if (idle_loop_.is_enabled() && registers_.pc() <= pc) {
+        return idle_loop_.observe(
+            pc,
+            registers_.pc(),
+            {get_register<Reg16Name::AF>(),
+             registers_.bc(),
+             registers_.de(),
+             registers_.hl(),
+             registers_.sp()},
+            cycles_
+        );
+    }
+    return false;
+}
+
+void Cpu::time_instruction(TCycle base)
+{
+    access_pc_ = registers_.pc();
+    access_base_ = base;
+    data_accesses_ = 0;
+}
+
+void Cpu::time_access(uint16_t addr)
+{
+    // Every M-cycle of the instruction so far fetched a byte at PC or accessed memory, the
+    // peripherals are ticked through the end of the access M-cycle (internal delays are ignored)
+    auto mcycles = static_cast<uint16_t>(registers_.pc() - access_pc_) + data_accesses_ + 1;
+    TCycle at = access_base_ + to_tcycles(static_cast<MCycle>(mcycles));
+    data_accesses_++;
+
+    // Plain memory has no peripheral to catch up
+    if (is_plain_memory(addr) || at <= synced_cycles_ || !sync_cb_) {
+        return;
+    }
+    sync_cb_(at - synced_cycles_);
+    synced_cycles_ = at;
+}
+
+uint8_t Cpu::bus_read_slow(uint16_t addr)
+{
+    if (bus_mode_ == BusMode::Latched) {
+        // Reads latched by the microprogram, in order, anything else goes to the bus now
+        if (micro_.next_read < micro_.reads && micro_.read_addrs[micro_.next_read] == addr) {
+            return micro_.read_values[micro_.next_read++];
+        }
+        return mmu_->read_byte(addr);
+    }
+    time_access(addr);
+    return mmu_->read_byte(addr);
+}
+
+void Cpu::bus_write_slow(uint16_t addr, uint8_t value)
+{
+    if (bus_mode_ == BusMode::Latched) {
+        // Writes wait for their step, unless there are more than the microprogram handles
+        if (micro_.writes < MicroLatches::MaxAccesses) {
+            micro_.write_addrs[micro_.writes] = addr;
+            micro_.write_values[micro_.writes++] = value;
+            return;
+        }
+        mmu_->write_byte(addr, value);
+        return;
+    }
+    time_access(addr);
+    mmu_->write_byte(addr, value);
+}
+
+void Cpu::begin_microprogram(InstructionType type, uint8_t opcode)
+{
+    micro_ = {};
+    micro_.program = &MicrocodeTable::get(type, opcode);
+
+    // With fetch/execute overlap the execute stage also counts the opcode fetch M-cycles, the
+    // steps are aligned to its end
+    auto mcycles = exec_state_.cycles_left / FetchCycles;
+    if (mcycles > micro_.program->mcycles) {
+        micro_.skip = static_cast<uint8_t>(mcycles - micro_.program->mcycles);
+    }
+}
+
+void Cpu::micro_tick()
+{
+    if (micro_.skip > 0) {
+        micro_.skip--;
+        return;
+    }
+
+    // One step taking the M-cycle, along with the Execute steps around it
+    const auto& program = *micro_.program;
+    bool consumed = false;
+    while (micro_.step < program.length) {
+        const auto& step = program.steps[micro_.step];
+        if (consumed && step.action != MicroAction::Execute) {
+            break;
+        }
+        micro_.step++;
+
+        switch (step.action) {
+            case MicroAction::Fetch:
+                // PC moves when the handler consumes the operand
+                micro_.operands[micro_.fetched] = mmu_->read_byte(
+                    registers_.pc() + micro_.fetched
+                );
+                micro_.fetched++;
+                break;
+            case MicroAction::Read: {
+                auto addr = micro_address(step.addr);
+                micro_.read_addrs[micro_.reads] = addr;
+                micro_.read_values[micro_.reads++] = mmu_->read_byte(addr);
+                break;
+            }
+            case MicroAction::Write:
+                if (micro_.next_write < micro_.writes) {
+                    mmu_->write_byte(
+                        micro_.write_addrs[micro_.next_write],
+                        micro_.write_values[micro_.next_write]
+                    );
+                    micro_.next_write++;
+                }
+                break;
+            case MicroAction::Internal:
+                break;
+            case MicroAction::Execute:
+                micro_execute();
+                continue;
+        }
+        consumed = true;
+    }
+}
+
+void Cpu::micro_execute()
+{
+    // Operands without a Fetch step are latched now
+    for (auto i = micro_.fetched; i < micro_.program->operands; ++i) {
+        micro_.operands[i] = mmu_->read_byte(registers_.pc() + i);
+    }
+
+    operands_ = micro_.operands.data();
+    bus_mode_ = BusMode::Latched;
+#ifdef SWITCH_DISPATCH
+    (void)((exec_state_.instr_type == InstructionType::Unprefixed)
+               ? dispatch(exec_state_.fetched)
+               : dispatch_cb(exec_state_.fetched));
+#else
+    (this->*InstructionTable::handler(exec_state_.instr_type, exec_state_.fetched))();
+#endif
+    bus_mode_ = BusMode::Direct;
+    operands_ = nullptr;
+    micro_.executed = true;
+}
+
+void Cpu::flush_micro_writes()
+{
+    // Writes left by a taken branch that didn't happen or a step mismatch
+    while (micro_.next_write < micro_.writes) {
+        mmu_->write_byte(
+            micro_.write_addrs[micro_.next_write], micro_.write_values[micro_.next_write]
+        );
+        micro_.next_write++;
+    }
+}
+
+uint16_t Cpu::micro_address(MicroAddr addr) const
+{
+    switch (addr) {
+        case MicroAddr::BC:
+            return registers_.bc();
+        case MicroAddr::DE:
+            return registers_.de();
+        case MicroAddr::HL:
+            return registers_.hl();
+        case MicroAddr::SP:
+            return registers_.sp() + micro_.reads;
+        case MicroAddr::A16:
+            return common::utils::to_u16(micro_.operands[1], micro_.operands[0]);
+        case MicroAddr::A8:
+            return 0xFF00 | micro_.operands[0];
+        case MicroAddr::C:
+            return 0xFF00 | registers_.c();
+        default:
+            return 0;
+    }
+}
+
+template <bool FeOverlap, StepKind Step>
 inline void Cpu::tick_cycles(Cycles cycles)
 {
     // Number of T-cycles to tick
@@ -234,17 +609,26 @@ inline void Cpu::tick_cycles(Cycles cycles)
 
     exec_state_.cycles_left -= tcycles;
 
+    // Microprograms step at the end of every M-cycle of the execute stage
+    if (microcode_ && exec_state_.has_stage(Stage::Execute) &&
+        exec_state_.cycles_left % FetchCycles == 0 && micro_.program != nullptr) {
+        micro_tick();
+    }
+
     // Fetch/execute overlap: the fetch stage always overlaps with the last machine cycle of the
     // execute stage of the previous instruction
-    if (fe_overlap_ && exec_state_.stage == Stage::Execute &&
-        exec_state_.cycles_left <= FetchCycles) {
-        exec_state_.stage |= Stage::Fetch;
+    if constexpr (FeOverlap) {
+        if (exec_state_.stage == Stage::Execute && exec_state_.cycles_left <= FetchCycles) {
+            exec_state_.stage |= Stage::Fetch;
+        }
     }
 
     // Take actions on stage end
     if (exec_state_.cycles_left == 0) {
-        if (!fe_overlap_ && exec_state_.has_stage(Stage::Fetch)) {
-            fetch_stage();
+        if constexpr (!FeOverlap) {
+            if (exec_state_.has_stage(Stage::Fetch)) {
+                fetch_stage<FeOverlap, Step>();
+            }
         }
         if (exec_state_.has_stage(Stage::Execute) && exec_state_.cycles_left == 0) {
             execute_stage();
@@ -258,21 +642,35 @@ inline void Cpu::tick_cycles(Cycles cycles)
                 return;
             }
 
-            if (!fe_overlap_) {
+            if constexpr (!FeOverlap) {
                 exec_state_.stage = Stage::Fetch;
                 exec_state_.cycles_left = FetchCycles;
                 return;
             }
         }
         // We cascade from Execute to Fetch on purpose to allow fetch/execute overlap
-        if (fe_overlap_ && exec_state_.has_stage(Stage::Fetch)) {
-            fetch_stage();
+        if constexpr (FeOverlap) {
+            if (exec_state_.has_stage(Stage::Fetch)) {
+                fetch_stage<FeOverlap, Step>();
+            }
         }
     }
 }
 
+template <bool FeOverlap, StepKind Step>
 inline void Cpu::fetch_stage()
 {
+    if constexpr (Step == StepKind::Recorded) {
+        if (!exec_state_.has_stage(Stage::CBInstruction)) {
+            if (trace_.is_enabled()) {
+                record_trace();
+            }
+            if (coverage_.is_enabled()) {
+                record_coverage();
+            }
+        }
+    }
+
     // Fetch next byte
     exec_state_.fetched = fetch();
 
@@ -285,40 +683,62 @@ inline void Cpu::fetch_stage()
         InstructionType instr_type = exec_state_.has_stage(Stage::CBInstruction)
                                          ? InstructionType::CBPrefixed
                                          : InstructionType::Unprefixed;
-        const auto* instr = &InstructionTable::get_instruction(instr_type, exec_state_.fetched);
-        exec_state_.instr = instr;
+        exec_state_.instr_type = instr_type;
         exec_state_.stage = Stage::Execute;
 
         // If it's a branching instruction, execute non-branch cycles
-        auto cycles = (instr->cycles_no_branch != 0) ? instr->cycles_no_branch : instr->cycles;
+        auto cycles = InstructionTable::cycles_no_branch(instr_type, exec_state_.fetched);
+        if (cycles == 0) {
+            cycles = InstructionTable::cycles(instr_type, exec_state_.fetched);
+        }
 
-        if (!fe_overlap_) {
+        if constexpr (!FeOverlap) {
             // Don't count fetch cycles in non-overlapping mode (already consumed)
             cycles -= FetchCycles * ((instr_type == InstructionType::CBPrefixed) ? 2 : 1);
         }
 
         exec_state_.cycles_left = cycles;
+
+        if (microcode_) {
+            begin_microprogram(instr_type, exec_state_.fetched);
+        }
     }
 }
 
 inline void Cpu::execute_stage()
 {
-    // Only execute if not branching from a conditional instruction
+    // Only execute if not branching from a conditional instruction, nor already executed by its
+    // microprogram
     if (!exec_state_.branching) {
-        // Execute instruction handler
-        (this->*(exec_state_.instr->execute))();
+        if (micro_.executed) {
+            micro_.executed = false;
+        }
+        else {
+#ifdef SWITCH_DISPATCH
+            (void)((exec_state_.instr_type == InstructionType::Unprefixed)
+                       ? dispatch(exec_state_.fetched)
+                       : dispatch_cb(exec_state_.fetched));
+#else
+            (this->*InstructionTable::handler(exec_state_.instr_type, exec_state_.fetched))();
+#endif
+        }
 
         // If a conditional branch has been taken flag it and add remaining execution cycles
         if (branch_taken_) {
             exec_state_.branching = true;
             branch_taken_ = false;
-            exec_state_.cycles_left = exec_state_.instr->cycles -
-                                      exec_state_.instr->cycles_no_branch;
+            exec_state_.cycles_left =
+                InstructionTable::cycles(exec_state_.instr_type, exec_state_.fetched) -
+                InstructionTable::cycles_no_branch(exec_state_.instr_type, exec_state_.fetched);
             return;
         }
     }
 
     exec_state_.branching = false;
+    if (microcode_) {
+        flush_micro_writes();
+        micro_.program = nullptr;
+    }
 
     clear_flag(exec_state_.stage, Stage::Execute);
 
@@ -365,68 +785,170 @@ inline void Cpu::handle_ime(TCycle tcycles)
     }
 }
 
-uint8_t Cpu::fetch()
+uint8_t Cpu::fetch_slow()
 {
+    uint16_t pc = registers_.pc();
+
     BB_PROFILE_START(profiling::HotSection::CpuFetch);
-    uint8_t result = read_byte(registers_.pc++);
+    uint8_t result = read_byte(pc);
     BB_PROFILE_STOP(profiling::HotSection::CpuFetch);
 
-    if (halt_bug_) {
-        // when halt bug occurs we don't increment PC
-        registers_.pc--;
+    // Pages with watchpoints are never fetched directly
+    if (mmu_->is_fetch_trapped(pc)) [[unlikely]] {
+        mmu_->check_fetch(pc, result);
+    }
+
+    if (halt_bug_) [[unlikely]] {
+        // When the HALT bug occurs we don't increment PC, the page is still invalid so the next
+        // fetch comes back here
         halt_bug_ = false;
         log::debug(
             "CPU HALT bug handled, not advancing PC={}", utils::PrettyHex{get_pc()}.to_string()
         );
+        return result;
     }
 
+    registers_.advance_pc();
+
+    // Pages that can't be read directly (IO, HRAM, VRAM, trapped...) keep taking this path
+    fetch_page_ = mmu_->fetch_page(pc);
+    fetch_page_tag_ = (fetch_page_ != nullptr) ? (pc >> 8) : NoFetchPage;
+    fetch_map_generation_ = mmu_->map_generation();
+
     return result;
 }
 
 [[nodiscard]] uint8_t Cpu::peek() const
 {
-    return read_byte(registers_.pc);
+    return read_byte(registers_.pc());
 }
 
 uint8_t Cpu::execute(uint8_t opcode, InstructionType instr_type)
 {
     BB_PROFILE_START(profiling::HotSection::CpuExecute);
-    const auto& instr = InstructionTable::get_instruction(instr_type, opcode);
-    (this->*instr.execute)();
-    auto cycles = instr.cycles;
+    BB_PROFILE_OPCODE_START();
+#ifdef SWITCH_DISPATCH
+    // The generated switch already returns the right cycles for branching instructions
+    auto cycles =
+        (instr_type == InstructionType::Unprefixed) ? dispatch(opcode) : dispatch_cb(opcode);
+#else
+    (this->*InstructionTable::handler(instr_type, opcode))();
+    auto cycles = InstructionTable::cycles(instr_type, opcode);
     // Set the right cycles for branching instructions
-    if (instr.cycles_no_branch != 0 && !branch_taken_) {
-        cycles = instr.cycles_no_branch;
+    auto cycles_no_branch = InstructionTable::cycles_no_branch(instr_type, opcode);
+    if (cycles_no_branch != 0 && !branch_taken_) {
+        cycles = cycles_no_branch;
     }
+#endif
     cycles_ += cycles;
     branch_taken_ = false;
+    BB_PROFILE_OPCODE_STOP(instr_type == InstructionType::CBPrefixed, opcode, cycles);
     BB_PROFILE_STOP(profiling::HotSection::CpuExecute);
     return cycles;
 }
 
+template <bool Fuse>
+uint8_t Cpu::execute(const MicroOp& op, uint16_t& branch_pc)
+{
+    BB_PROFILE_START(profiling::HotSection::CpuExecute);
+    BB_PROFILE_OPCODE_START();
+
+    // Copy the micro-op, the handler might invalidate its block by writing to it
+    const MicroOp uop = op;
+    bool fused = Fuse && is_fusable(uop);
+
+#ifdef ENABLE_PROFILING
+    // Superinstructions are profiled as the instructions they cover
+    std::array<MicroOp, Superinstruction::MaxOps> covered{};
+    std::copy_n(&op, fused ? uop.fused_count : 1, covered.begin());
+#endif
+
+    // Skip the opcode (and prefix), operands are consumed by the handler fetches
+    registers_.advance_pc((uop.type == InstructionType::CBPrefixed) ? 2 : 1);
+    operands_ = uop.operands.data();
+    (this->*(fused ? uop.fused : uop.handler))();
+    operands_ = nullptr;
+
+    uint8_t cycles = 0;
+    if (fused) {
+        // The rest of the sequence was executed too, skip its micro-ops
+        cycles = (uop.fused_cycles_no_branch != 0 && !branch_taken_) ? uop.fused_cycles_no_branch
+                                                                     : uop.fused_cycles;
+        branch_pc = branch_pc + uop.fused_tail;
+        block_cache_.advance(uop.fused_count - 1);
+        block_cache_.count_fused(uop.fused_count - 1);
+    }
+    else {
+        cycles = (uop.cycles_no_branch != 0 && !branch_taken_) ? uop.cycles_no_branch
+                                                               : uop.cycles;
+    }
+    cycles_ += cycles;
+    branch_taken_ = false;
+
+#ifdef ENABLE_PROFILING
+    if (fused) {
+        // Untimed, only the last instruction might have branched
+        uint8_t remaining = cycles;
+        for (size_t i = 0; i < uop.fused_count; ++i) {
+            const auto& covered_op = covered.at(i);
+            uint8_t op_cycles = (i + 1 < uop.fused_count) ? covered_op.cycles : remaining;
+            remaining -= op_cycles;
+            BB_PROFILE_OPCODE(
+                covered_op.type == InstructionType::CBPrefixed, covered_op.opcode, op_cycles
+            );
+        }
+    }
+    else {
+        BB_PROFILE_OPCODE_STOP(uop.type == InstructionType::CBPrefixed, uop.opcode, cycles);
+    }
+#endif
+    BB_PROFILE_STOP(profiling::HotSection::CpuExecute);
+    return cycles;
+}
+
+void Cpu::record_trace()
+{
+    uint16_t pc = registers_.pc();
+    bool banked = pc >= mmu::ROMBank1Start && pc <= mmu::ROMBank1End;
+
+    trace_.push(TraceRecord{
+        .cycles = cycles_,
+        .pc = pc,
+        .sp = registers_.sp(),
+        .af = get_register<Reg16Name::AF>(),
+        .bc = registers_.bc(),
+        .de = registers_.de(),
+        .hl = registers_.hl(),
+        .bank = banked ? mmu_->rom_bank() : uint16_t{0},
+        .mem = {read_byte(pc), read_byte(pc + 1), read_byte(pc + 2), read_byte(pc + 3)},
+        .state = ime_ ? TraceRecord::ImeFlag : uint8_t{0},
+        .pad = {},
+    });
+}
+
 void Cpu::trace() const
 {
     log::cpu_trace("--- CPU TRACE ---");
     log::cpu_trace(
         "Instruction: {} ({})",
-        disassemble(registers_.pc),
+        disassemble(registers_.pc()),
         common::utils::PrettyHex(peek()).to_string()
     );
     log::cpu_trace(
         "Next bytes: {} {} {}",
-        common::utils::PrettyHex(read_byte(registers_.pc + 1)).to_string(),
-        common::utils::PrettyHex(read_byte(registers_.pc + 2)).to_string(),
-        common::utils::PrettyHex(read_byte(registers_.pc + 3)).to_string()
+        common::utils::PrettyHex(read_byte(registers_.pc() + 1)).to_string(),
+        common::utils::PrettyHex(read_byte(registers_.pc() + 2)).to_string(),
+        common::utils::PrettyHex(read_byte(registers_.pc() + 3)).to_string()
     );
     log::cpu_trace(
         "CPU State: PC={}, SP={}, AF={}, BC={}, DE={}, HL={}, Flags=[Z={}, N={}, H={}, C={}], "
         "IME={}, HALT={}, Cycles={}",
-        common::utils::PrettyHex(registers_.pc).to_string(),
-        common::utils::PrettyHex(registers_.sp).to_string(),
-        common::utils::PrettyHex(registers_.af).to_string(),
-        common::utils::PrettyHex(registers_.bc).to_string(),
-        common::utils::PrettyHex(registers_.de).to_string(),
-        common::utils::PrettyHex(registers_.hl).to_string(),
+        common::utils::PrettyHex(registers_.pc()).to_string(),
+        common::utils::PrettyHex(registers_.sp()).to_string(),
+        common::utils::PrettyHex(get_register<Reg16Name::AF>()).to_string(),
+        common::utils::PrettyHex(registers_.bc()).to_string(),
+        common::utils::PrettyHex(registers_.de()).to_string(),
+        common::utils::PrettyHex(registers_.hl()).to_string(),
         get_flag(Flag::Zero) ? 1 : 0,
         get_flag(Flag::Substract) ? 1 : 0,
         get_flag(Flag::HalfCarry) ? 1 : 0,
@@ -448,10 +970,8 @@ void Cpu::trace() const
         instr_type = InstructionType::CBPrefixed;
     }
 
-    const auto& instr = InstructionTable::get_instruction(instr_type, opcode);
-
     // Simple implementation: just return the mnemonic for now
-    return instr.mnemonic;
+    return InstructionTable::mnemonic(instr_type, opcode);
 }
 
 // Private methods
@@ -460,65 +980,46 @@ void Cpu::add(uint8_t val, bool use_carry)
 {
     uint8_t a = registers_.a();
     uint8_t carry_in = (use_carry && get_flag(Flag::Carry)) ? 1 : 0;
-
-    uint16_t sum = uint16_t(a) + uint16_t(val) + carry_in;
-    uint8_t result = sum & 0xFF;
+    uint8_t result = a + val + carry_in;
 
     registers_.a(result);
 
-    set_flag(Flag::Zero, result == 0);
-    set_flag(Flag::Substract, false);
-    set_flag(Flag::HalfCarry, ((a & 0xF) + (val & 0xF) + carry_in) > 0xF);
-    set_flag(Flag::Carry, sum > 0xFF);
+    set_flags({.op = FlagOp::Add, .result = result, .lhs = a, .rhs = val, .carry = carry_in});
 }
 
 void Cpu::sub(uint8_t val, bool use_carry)
 {
     uint8_t a = registers_.a();
     uint8_t carry_in = (use_carry && get_flag(Flag::Carry)) ? 1 : 0;
-
-    uint16_t sub = uint16_t(val) + carry_in;
-    uint8_t result = a - sub;
+    uint8_t result = a - val - carry_in;
 
     registers_.a(result);
 
-    set_flag(Flag::Zero, result == 0);
-    set_flag(Flag::Substract, true);
-    set_flag(Flag::HalfCarry, (a & 0xF) < ((val & 0xF) + carry_in));
-    set_flag(Flag::Carry, a < sub);
+    set_flags({.op = FlagOp::Sub, .result = result, .lhs = a, .rhs = val, .carry = carry_in});
 }
 
 void Cpu::aand(uint8_t val)
 {
-    auto result = registers_.a() & val;
+    uint8_t result = registers_.a() & val;
     registers_.a(result);
 
-    set_flag(Flag::Zero, result == 0);
-    set_flag(Flag::Substract, false);
-    set_flag(Flag::HalfCarry, true);
-    set_flag(Flag::Carry, false);
+    set_flags({.op = FlagOp::And, .result = result});
 }
 
 void Cpu::xxor(uint8_t val)
 {
-    auto result = registers_.a() ^ val;
+    uint8_t result = registers_.a() ^ val;
     registers_.a(result);
 
-    set_flag(Flag::Zero, result == 0);
-    set_flag(Flag::Substract, false);
-    set_flag(Flag::HalfCarry, false);
-    set_flag(Flag::Carry, false);
+    set_flags({.op = FlagOp::Logic, .result = result});
 }
 
 void Cpu::oor(uint8_t val)
 {
-    auto result = registers_.a() | val;
+    uint8_t result = registers_.a() | val;
     registers_.a(result);
 
-    set_flag(Flag::Zero, result == 0);
-    set_flag(Flag::Substract, false);
-    set_flag(Flag::HalfCarry, false);
-    set_flag(Flag::Carry, false);
+    set_flags({.op = FlagOp::Logic, .result = result});
 }
 
 void Cpu::cp(uint8_t val)
@@ -527,10 +1028,22 @@ void Cpu::cp(uint8_t val)
     uint8_t a = registers_.a();
     uint8_t result = a - val;
 
-    set_flag(Flag::Zero, result == 0);
-    set_flag(Flag::Substract, true);
-    set_flag(Flag::HalfCarry, (result & 0x0F) > (a & 0x0F));
-    set_flag(Flag::Carry, result > a);
+    set_flags({.op = FlagOp::Sub, .result = result, .lhs = a, .rhs = val});
 }
 
+// tick() instantiations selected by select_tick() and Emulator::apply_config()
+template TCycle Cpu::tick<TickMode::Instruction, false, StepKind::Plain>();
+template TCycle Cpu::tick<TickMode::Instruction, false, StepKind::Batched>();
+template TCycle Cpu::tick<TickMode::Instruction, false, StepKind::Recorded>();
+template TCycle Cpu::tick<TickMode::CatchUp, false, StepKind::Plain>();
+template TCycle Cpu::tick<TickMode::CatchUp, false, StepKind::Recorded>();
+template TCycle Cpu::tick<TickMode::MCycle, false, StepKind::Plain>();
+template TCycle Cpu::tick<TickMode::MCycle, false, StepKind::Recorded>();
+template TCycle Cpu::tick<TickMode::MCycle, true, StepKind::Plain>();
+template TCycle Cpu::tick<TickMode::MCycle, true, StepKind::Recorded>();
+template TCycle Cpu::tick<TickMode::TCycle, false, StepKind::Plain>();
+template TCycle Cpu::tick<TickMode::TCycle, false, StepKind::Recorded>();
+template TCycle Cpu::tick<TickMode::TCycle, true, StepKind::Plain>();
+template TCycle Cpu::tick<TickMode::TCycle, true, StepKind::Recorded>();
+
 } // namespace boyboy::core::cpu
\ No newline at end of file
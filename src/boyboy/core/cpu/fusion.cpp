@@ -0,0 +1,148 @@
+/**
+ * @file fusion.cpp
+ * @brief Superinstructions for hot opcode sequences of the BoyBoy CPU interpreter.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include "boyboy/core/cpu/fusion.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/instructions_table.h"
+#include "boyboy/core/cpu/registers.h"
+
+namespace boyboy::core::cpu {
+
+namespace {
+
+[[nodiscard]] std::string_view fused_mnemonic(FusedOpcode op)
+{
+    auto type = ((op & CBFusedFlag) != 0) ? InstructionType::CBPrefixed
+                                          : InstructionType::Unprefixed;
+    return InstructionTable::mnemonic(type, static_cast<uint8_t>(op));
+}
+
+} // namespace
+
+template <FusedStep First, FusedStep... Rest>
+void Cpu::fused()
+{
+    // The caller skips the first opcode like for any micro-op, operands follow one another
+    (this->*First.handler)();
+    ((registers_.advance_pc(Rest.prefixed ? 2 : 1), (this->*Rest.handler)()), ...);
+}
+
+const std::vector<Superinstruction> FusionTable::Superinstructions = {
+// Autogenerated superinstructions from a sequence profile
+#include "generated/fused.inc"
+};
+
+const Superinstruction* FusionTable::find(std::span<const FusedOpcode> ops)
+{
+    // Superinstructions by first opcode, longest first: most opcodes start none of them and
+    // blocks are decoded again whenever their RAM code is written
+    static const auto ByFirstOp = [] {
+        std::array<std::vector<const Superinstruction*>, 2 * CBFusedFlag> index{};
+        for (const auto& super : Superinstructions) {
+            index.at(super.ops[0]).push_back(&super);
+        }
+        for (auto& entries : index) {
+            std::ranges::stable_sort(entries, std::ranges::greater{}, &Superinstruction::length);
+        }
+        return index;
+    }();
+
+    if (ops.empty()) {
+        return nullptr;
+    }
+    for (const auto* super : ByFirstOp.at(ops[0])) {
+        auto length = super->length;
+        if (length <= ops.size() &&
+            std::ranges::equal(ops.first(length), std::span(super->ops).first(length))) {
+            return super;
+        }
+    }
+    return nullptr;
+}
+
+void SequenceProfile::add(std::span<const FusedOpcode> ops, uint64_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i + 1 < ops.size(); ++i) {
+        Sequence pair{ops[i], ops[i + 1], NoFusedOpcode};
+        counts_[pair] += count;
+
+        if (i + 2 < ops.size()) {
+            Sequence triple{ops[i], ops[i + 1], ops[i + 2]};
+            counts_[triple] += count;
+        }
+    }
+}
+
+void SequenceProfile::merge(const SequenceProfile& other)
+{
+    for (const auto& [ops, count] : other.counts_) {
+        counts_[ops] += count;
+    }
+}
+
+uint64_t SequenceProfile::count(const Sequence& ops) const
+{
+    auto it = counts_.find(ops);
+    return (it != counts_.end()) ? it->second : 0;
+}
+
+std::vector<SequenceProfile::Entry> SequenceProfile::top(size_t max_entries) const
+{
+    std::vector<Entry> entries;
+    entries.reserve(counts_.size());
+    for (const auto& [ops, count] : counts_) {
+        entries.push_back({.ops = ops, .count = count});
+    }
+
+    auto by_count = [](const Entry& a, const Entry& b) { return a.count > b.count; };
+    std::ranges::stable_sort(entries, by_count);
+    if (entries.size() > max_entries) {
+        entries.resize(max_entries);
+    }
+    return entries;
+}
+
+std::string SequenceProfile::to_csv(size_t max_entries) const
+{
+    std::string csv = "count,sequence,mnemonics\n";
+
+    for (const auto& entry : top(max_entries)) {
+        std::string sequence;
+        std::string mnemonics;
+        for (auto op : entry.ops) {
+            if (op == NoFusedOpcode) {
+                break;
+            }
+            if (!sequence.empty()) {
+                sequence += ' ';
+                mnemonics += "; ";
+            }
+            sequence += ((op & CBFusedFlag) != 0) ? std::format("CB{:02X}", op & 0xFF)
+                                                  : std::format("{:02X}", op);
+            mnemonics += fused_mnemonic(op);
+        }
+        csv += std::format("{},{},\"{}\"\n", entry.count, sequence, mnemonics);
+    }
+
+    return csv;
+}
+
+} // namespace boyboy::core::cpu
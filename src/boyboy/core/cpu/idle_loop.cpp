@@ -0,0 +1,297 @@
+/**
+ * @file idle_loop.cpp
+ * @brief Idle (busy-wait) loop detection for the BoyBoy CPU.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include "boyboy/core/cpu/idle_loop.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include "boyboy/common/log/logging.h"
+#include "boyboy/common/utils.h"
+#include "boyboy/core/cpu/block_cache.h"
+#include "boyboy/core/cpu/cpu_constants.h"
+#include "boyboy/core/cpu/instructions.h"
+#include "boyboy/core/cpu/instructions_table.h"
+#include "boyboy/core/io/registers.h"
+#include "boyboy/core/mmu/constants.h"
+#include "boyboy/core/mmu/mmu.h"
+
+namespace boyboy::core::cpu {
+
+using namespace boyboy::common;
+
+namespace {
+
+// RegisterSnapshot layout
+enum SnapshotIndex : uint8_t { AF, BC, DE, HL, SP };
+
+// Slot of the registers polled through [C], after the BC, DE and HL pairs
+constexpr size_t PolledC = 3;
+
+// Mnemonic split into its name and operands, e.g. "LD A, [HL]" -> "LD", {"A", "[HL]"}
+struct Mnemonic {
+    std::string_view name;
+    std::array<std::string_view, 2> operands{};
+    size_t count{};
+
+    explicit Mnemonic(std::string_view mnemonic)
+    {
+        auto space = mnemonic.find(' ');
+        name = mnemonic.substr(0, space);
+        while (space != std::string_view::npos && count < operands.size()) {
+            mnemonic.remove_prefix(space + 1);
+            auto comma = mnemonic.find(", ");
+            operands.at(count++) = mnemonic.substr(0, comma);
+            space = (comma == std::string_view::npos) ? comma : comma + 1;
+        }
+    }
+
+    [[nodiscard]] bool is(std::string_view other) const { return name == other; }
+    [[nodiscard]] bool mentions(std::string_view reg) const
+    {
+        return std::ranges::any_of(operands, [reg](std::string_view op) { return op == reg; });
+    }
+};
+
+[[nodiscard]] InstructionType instruction_type(const mmu::Mmu& mmu, uint16_t addr)
+{
+    return (mmu.read_byte(addr) == CBInstructionPrefix) ? InstructionType::CBPrefixed
+                                                        : InstructionType::Unprefixed;
+}
+
+[[nodiscard]] Instruction instruction_at(const mmu::Mmu& mmu, uint16_t addr, InstructionType type)
+{
+    auto opcode = mmu.read_byte(
+        (type == InstructionType::CBPrefixed) ? static_cast<uint16_t>(addr + 1) : addr
+    );
+    return InstructionTable::get_instruction(type, opcode);
+}
+
+// Memory that can't change between peripheral events, except by the CPU itself
+[[nodiscard]] constexpr bool is_pollable(uint16_t addr)
+{
+    // DIV and TIMA count between events, the joypad changes between frames
+    if (addr == io::IoReg::Timer::DIV || addr == io::IoReg::Timer::TIMA ||
+        addr == io::IoReg::Joypad::P1) {
+        return false;
+    }
+    // External RAM might be a real time clock, OAM is written by DMA
+    return (addr < mmu::SRAMStart || addr > mmu::SRAMEnd) &&
+           (addr < mmu::OAMStart || addr > mmu::OAMEnd);
+}
+
+} // namespace
+
+void IdleLoopDetector::enable(bool enable)
+{
+    if (enable == enabled_) {
+        return;
+    }
+    reset();
+    enabled_ = enable;
+
+    log::debug("CPU idle loop detection {}", enable ? "enabled" : "disabled");
+}
+
+bool IdleLoopDetector::observe(
+    uint16_t branch_pc, uint16_t target, const RegisterSnapshot& regs, uint64_t cycles
+)
+{
+    // Remaps (bank switches, watchpoint traps) might change what the loop reads
+    bool same_loop = analyzed_ && loop_.start == target && loop_.branch == branch_pc &&
+                     loop_.bank == bank_at(target) &&
+                     map_generation_ == current_map_generation();
+
+    // Loops polling through a register pair are checked against the registers they start with
+    if (!same_loop || (loop_.indirect && regs != regs_)) {
+        loop_ = analyze(target, branch_pc, regs);
+        map_generation_ = current_map_generation();
+        analyzed_ = true;
+        confirmed_ = false;
+    }
+    else {
+        // A whole iteration ran with no interrupt in between and ended in the same state
+        bool confirmed = loop_.is_idle_candidate() && regs == regs_ &&
+                         (cycles - last_cycles_) == loop_.period;
+        if (confirmed && !confirmed_) {
+            stats_.detected++;
+        }
+        confirmed_ = confirmed;
+    }
+
+    regs_ = regs;
+    last_cycles_ = cycles;
+    return confirmed_;
+}
+
+TCycle IdleLoopDetector::skip(TCycle cycles_to_event, TCycle max_cycles)
+{
+    uint64_t next_event = (cycles_to_event == NoEvent)
+                              ? std::numeric_limits<uint64_t>::max()
+                              : last_cycles_ + cycles_to_event;
+    bool same_window = (next_event == next_event_);
+    next_event_ = next_event;
+
+    if (!confirmed_ || !same_window) {
+        return 0;
+    }
+
+    // Only skip iterations reading memory before the next event
+    TCycle cycles = std::min(cycles_to_event, max_cycles);
+    TCycle skipped = (cycles / loop_.period) * loop_.period;
+    last_cycles_ += skipped;
+    stats_.skipped_cycles += skipped;
+    return skipped;
+}
+
+void IdleLoopDetector::reset()
+{
+    loop_ = {};
+    analyzed_ = false;
+    confirmed_ = false;
+    regs_ = {};
+    map_generation_ = 0;
+    last_cycles_ = 0;
+    next_event_ = 0;
+}
+
+IdleLoop IdleLoopDetector::analyze(
+    uint16_t start, uint16_t branch, const RegisterSnapshot& regs
+) const
+{
+    IdleLoop loop{.start = start, .branch = branch, .bank = bank_at(start)};
+
+    // Short loops in memory that can't be changed by anything else than the loop itself
+    if (branch < start || branch - start > MaxLoopBytes || !is_plain_memory(start) ||
+        !is_plain_memory(static_cast<uint16_t>(branch + 2))) {
+        return loop;
+    }
+
+    // Watched code has its fetches checked one by one
+    if (mmu_.is_fetch_trapped(start) ||
+        mmu_.is_fetch_trapped(static_cast<uint16_t>(branch + 1))) {
+        return loop;
+    }
+
+    TCycle period = 0;
+    std::array<std::string_view, 4> polled_regs{}; // registers polling memory indirectly
+    uint16_t addr = start;
+
+    while (true) {
+        auto type = instruction_type(mmu_, addr);
+        const auto& instr = instruction_at(mmu_, addr, type);
+        const Mnemonic mnemonic{instr.mnemonic};
+        uint8_t n8 = mmu_.read_byte(addr + 1);
+        uint16_t n16 = utils::to_u16(mmu_.read_byte(addr + 2), n8);
+
+        bool jump = mnemonic.is("JR") || mnemonic.is("JP");
+        uint16_t jump_target = mnemonic.is("JR")
+                                   ? static_cast<uint16_t>(addr + 2 + static_cast<int8_t>(n8))
+                                   : n16;
+
+        // The backward branch closing the loop
+        if (addr == branch) {
+            if (!jump || mnemonic.mentions("HL") || jump_target != start) {
+                return loop;
+            }
+            period += instr.cycles;
+            break;
+        }
+        if (addr > branch) {
+            return loop;
+        }
+
+        if (jump) {
+            // Only conditional exits out of the loop, the iteration path must be fixed
+            if (mnemonic.count != 2 || (jump_target >= start && jump_target <= branch)) {
+                return loop;
+            }
+        }
+        else if (mnemonic.is("PUSH") || mnemonic.is("POP") || mnemonic.is("CALL") ||
+                 mnemonic.name.starts_with("RET") || mnemonic.is("RST") || mnemonic.is("EI") ||
+                 mnemonic.is("DI") || mnemonic.is("HALT") || mnemonic.is("STOP") ||
+                 mnemonic.is("PREFIX") || mnemonic.name.starts_with("ILLEGAL")) {
+            return loop;
+        }
+        else if (instr.mnemonic.contains('[')) {
+            // Memory reads only: no writes nor read-modify-writes
+            bool read = (type == InstructionType::Unprefixed)
+                            ? !mnemonic.operands.at(0).starts_with('[')
+                            : mnemonic.is("BIT");
+            if (!read) {
+                return loop;
+            }
+
+            const auto& src = mnemonic.operands.at(mnemonic.count - 1);
+            uint16_t polled = 0;
+            if (src == "[a8]") {
+                polled = 0xFF00 | n8;
+            }
+            else if (src == "[a16]") {
+                polled = n16;
+            }
+            else if (src == "[C]") {
+                polled = 0xFF00 | utils::lsb(regs.at(BC));
+                polled_regs.at(PolledC) = "C";
+            }
+            else if (src == "[BC]" || src == "[DE]" || src == "[HL]") {
+                auto pair = src.substr(1, 2);
+                auto index = (pair == "BC") ? BC : (pair == "DE") ? DE : HL;
+                polled = regs.at(index);
+                polled_regs.at(index - 1) = pair;
+            }
+            else {
+                return loop; // [HL+] and [HL-]
+            }
+
+            // Watched reads can't be skipped, the watchpoints would miss them
+            if (!is_pollable(polled) || mmu_.is_read_trapped(polled)) {
+                return loop;
+            }
+        }
+
+        period += (instr.cycles_no_branch != 0) ? instr.cycles_no_branch : instr.cycles;
+        addr += instr.length;
+    }
+
+    // Register pairs used to poll memory must hold the same address during the whole loop
+    for (addr = start; addr < branch;) {
+        auto type = instruction_type(mmu_, addr);
+        const auto& instr = instruction_at(mmu_, addr, type);
+        const Mnemonic mnemonic{instr.mnemonic};
+
+        if (!mnemonic.is("JR") && !mnemonic.is("JP")) {
+            for (auto pair : polled_regs) {
+                if (!pair.empty() && (mnemonic.mentions(pair) ||
+                                      mnemonic.mentions(pair.substr(0, 1)) ||
+                                      mnemonic.mentions(pair.substr(pair.size() - 1)))) {
+                    return loop;
+                }
+            }
+        }
+        addr += instr.length;
+    }
+
+    loop.indirect = std::ranges::any_of(polled_regs, [](auto pair) { return !pair.empty(); });
+    loop.period = period;
+    return loop;
+}
+
+uint16_t IdleLoopDetector::bank_at(uint16_t addr) const
+{
+    return (addr >= mmu::ROMBank1Start && addr <= mmu::ROMBank1End) ? mmu_.rom_bank() : 0;
+}
+
+uint32_t IdleLoopDetector::current_map_generation() const
+{
+    return mmu_.map_generation();
+}
+
+} // namespace boyboy::core::cpu
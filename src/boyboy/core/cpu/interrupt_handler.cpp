@@ -14,12 +14,16 @@
 #include "boyboy/core/cpu/cpu.h"
 #include "boyboy/core/cpu/cycles.h"
 #include "boyboy/core/cpu/interrupts.h"
-#include "boyboy/core/io/registers.h"
+#include "boyboy/core/io/io.h"
+#include "boyboy/core/mmu/mmu.h"
+#include "boyboy/core/profiling/profiler_utils.h"
 
 namespace boyboy::core::cpu {
 
-constexpr auto IF = boyboy::core::io::IoReg::Interrupts::IF;
-constexpr auto IE = boyboy::core::io::IoReg::Interrupts::IE;
+InterruptHandler::InterruptHandler(Cpu& cpu, mmu::Mmu& mmu)
+    : cpu_(cpu), regs_(mmu.io()->interrupts())
+{
+}
 
 void InterruptHandler::tick(Cycles cycles)
 {
@@ -46,35 +50,24 @@ void InterruptHandler::tick(Cycles cycles)
             return;
         }
 
-        for (size_t i = 0; i < InterruptVectors::Vectors.size(); ++i) {
-            auto interrupt = 1 << i;
-            if ((pend & interrupt) == 0) {
-                continue;
-            }
+        cycles_left_ = service_cycles() - to_tcycles(cycles);
+        current_interrupt_ = InterruptRegisters::highest_priority(pend);
 
-            cycles_left_ = service_cycles() - to_tcycles(cycles);
-            current_interrupt_ = static_cast<Interrupt>(interrupt);
+        common::log::trace(
+            "[InterruptHandler] Servicing interrupt: {}", to_string(current_interrupt_)
+        );
 
-            common::log::trace(
-                "[InterruptHandler] Servicing interrupt: {}", to_string(current_interrupt_)
-            );
-
-            // Disable interrupts, clear IF and wake CPU if halted
-            cpu_.set_ime(false);
-            clear_interrupt(current_interrupt_);
-            cpu_.set_halted(false);
-            break;
-        }
+        // Disable interrupts, clear IF and wake CPU if halted
+        cpu_.set_ime(false);
+        clear_interrupt(current_interrupt_);
+        cpu_.set_halted(false);
     }
 }
 
 TCycle InterruptHandler::service()
 {
-    uint8_t ier = get_ie();
-    uint8_t ifr = get_if();
-    uint8_t pending = ier & ifr;
-
-    if (pending == 0) {
+    uint8_t pend = pending();
+    if (pend == 0) {
         return 0;
     }
 
@@ -90,108 +83,54 @@ TCycle InterruptHandler::service()
     }
 
     const auto ServiceCycles = service_cycles();
+    auto interrupt = InterruptRegisters::highest_priority(pend);
 
-    uint8_t cycles = 0;
-    for (size_t i = 0; i < InterruptVectors::Vectors.size(); ++i) {
-        uint8_t mask = (1 << i);
-        if ((pending & mask) != 0) {
-            // Clear IF flag
-            ifr &= ~mask;
+    common::log::trace("[InterruptHandler] Servicing interrupt: {}", to_string(interrupt));
 
-            common::log::trace(
-                "[InterruptHandler] Servicing interrupt: {}", to_string(Interrupt(mask))
-            );
-
-            // Disable interrupts and wake CPU if halted
-            cpu_.set_ime(false);
-            set_if(ifr);
-            cpu_.set_halted(false);
+    // Disable interrupts, clear IF and wake CPU if halted
+    cpu_.set_ime(false);
+    clear_interrupt(interrupt);
+    cpu_.set_halted(false);
 
-            service_interrupt(static_cast<Interrupt>(mask));
-            cycles = ServiceCycles;
-            break;
-        }
-    }
-
-    return cycles;
+    service_interrupt(interrupt);
+    return ServiceCycles;
 }
 
 inline void InterruptHandler::service_interrupt(Interrupt interrupt)
 {
+    auto vector = std::to_underlying(InterruptVectors::get_vector(interrupt));
     cpu_.push_pc();
-    cpu_.set_pc(std::to_underlying(InterruptVectors::get_vector(interrupt)));
+    cpu_.set_pc(vector);
+    BB_PROFILE_GUEST_CALL(0, vector, cpu_.get_sp());
 }
 
 void InterruptHandler::request(Interrupt interrupt)
 {
-    uint8_t ifr = get_if();
-    ifr |= std::to_underlying(interrupt);
-    set_if(ifr);
+    regs_.request(interrupt);
     common::log::trace("[InterruptHandler] Interrupt requested: {}", to_string(interrupt));
 }
 
 void InterruptHandler::enable(Interrupt interrupt)
 {
-    uint8_t ie = get_ie();
+    uint8_t ie = regs_.ie();
     ie |= std::to_underlying(interrupt);
-    set_ie(ie);
+    regs_.set_ie(ie);
     common::log::trace("[InterruptHandler] Interrupt enabled: {}", to_string(interrupt));
 }
 
 bool InterruptHandler::is_requested(Interrupt interrupt) const
 {
-    uint8_t ifr = get_if();
-    return (ifr & std::to_underlying(interrupt)) != 0;
+    return (regs_.iflag() & std::to_underlying(interrupt)) != 0;
 }
 
 bool InterruptHandler::is_enabled(Interrupt interrupt) const
 {
-    uint8_t ie = get_ie();
-    return (ie & std::to_underlying(interrupt)) != 0;
-}
-
-uint8_t InterruptHandler::pending() const
-{
-    uint8_t ie = get_ie();
-    uint8_t ifr = get_if();
-    return ie & ifr;
-}
-
-bool InterruptHandler::should_service() const
-{
-    return cpu_.get_ime() && (pending() != 0);
-}
-
-bool InterruptHandler::should_wake_up() const
-{
-    return pending() != 0;
+    return (regs_.ie() & std::to_underlying(interrupt)) != 0;
 }
 
 inline void InterruptHandler::clear_interrupt(Interrupt interrupt)
 {
-    uint8_t ifr = get_if();
-    ifr &= ~std::to_underlying(interrupt);
-    set_if(ifr);
-}
-
-uint8_t InterruptHandler::get_ie() const
-{
-    return cpu_.read_byte(IE);
-}
-
-uint8_t InterruptHandler::get_if() const
-{
-    return cpu_.read_byte(IF);
-}
-
-inline void InterruptHandler::set_ie(uint8_t value)
-{
-    cpu_.write_byte(IE, value);
-}
-
-inline void InterruptHandler::set_if(uint8_t value)
-{
-    cpu_.write_byte(IF, value);
+    regs_.clear(interrupt);
 }
 
 /**
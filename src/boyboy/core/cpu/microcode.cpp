@@ -0,0 +1,30 @@
+/**
+ * @file microcode.cpp
+ * @brief M-cycle microprograms for the BoyBoy CPU.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include "boyboy/core/cpu/microcode.h"
+
+namespace boyboy::core::cpu {
+
+const std::array<Microprogram, 256> MicrocodeTable::Opcodes = []() {
+    std::array<Microprogram, 256> table{};
+
+    // Autogenerated unprefixed microprograms from Opcodes.json
+#include "generated/microcode.inc"
+
+    return table;
+}();
+
+const std::array<Microprogram, 256> MicrocodeTable::CBOpcodes = []() {
+    std::array<Microprogram, 256> table{};
+
+    // Autogenerated CB-prefixed microprograms from Opcodes.json
+#include "generated/cbmicrocode.inc"
+
+    return table;
+}();
+
+} // namespace boyboy::core::cpu
@@ -0,0 +1,242 @@
+/**
+ * @file trace_buffer.cpp
+ * @brief Binary execution trace ring buffer for the BoyBoy CPU.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include "boyboy/core/cpu/trace_buffer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "boyboy/common/files/errors.h"
+#include "boyboy/common/files/io.h"
+#include "boyboy/common/log/logging.h"
+
+namespace boyboy::core::cpu {
+
+using namespace boyboy::common;
+
+namespace {
+
+constexpr std::array CrashSignals = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+constexpr int FlushSignal = SIGUSR1;
+
+// Buffer flushed by the signal handlers, the path is copied so the handlers don't allocate
+std::atomic<const TraceBuffer*> signal_buffer{nullptr};
+std::array<char, 4096> signal_path{};
+
+[[nodiscard]] TraceFileHeader make_header(size_t count)
+{
+    return TraceFileHeader{
+        .magic = TraceFileHeader::Magic,
+        .version = TraceFileHeader::CurrentVersion,
+        .record_size = sizeof(TraceRecord),
+        .count = static_cast<uint32_t>(count),
+    };
+}
+
+// ::write until done, async-signal-safe
+bool write_all(int fd, const void* data, size_t size)
+{
+    const auto* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        auto written = ::write(fd, bytes, size);
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+TraceBuffer::TraceBuffer(size_t capacity) : mask_(std::bit_ceil(std::max<size_t>(capacity, 1)) - 1)
+{
+}
+
+TraceBuffer::~TraceBuffer()
+{
+    if (signal_buffer.load() == this) {
+        remove_signal_handlers();
+    }
+}
+
+void TraceBuffer::enable(bool enable)
+{
+    if (enable && records_.empty()) {
+        records_.resize(capacity());
+    }
+    enabled_ = enable;
+
+    log::debug("CPU trace buffer {}", enable ? "enabled" : "disabled");
+}
+
+size_t TraceBuffer::size() const
+{
+    return held(head_.load(std::memory_order_acquire));
+}
+
+std::vector<TraceRecord> TraceBuffer::snapshot() const
+{
+    auto head = head_.load(std::memory_order_acquire);
+    auto count = held(head);
+
+    std::vector<TraceRecord> records;
+    records.reserve(count);
+    for (auto i = head - count; i < head; ++i) {
+        records.push_back(records_[i & mask_]);
+    }
+    return records;
+}
+
+std::expected<void, files::FileError> TraceBuffer::flush(const std::filesystem::path& path) const
+{
+    auto records = snapshot();
+    auto header = make_header(records.size());
+
+    auto records_size = records.size() * sizeof(TraceRecord);
+
+    std::vector<std::byte> data(sizeof(header) + records_size);
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + sizeof(header), records.data(), records_size);
+
+    return files::write_binary(path, data);
+}
+
+bool TraceBuffer::write_to(int fd) const
+{
+    auto head = head_.load(std::memory_order_acquire);
+    auto count = held(head);
+    auto header = make_header(count);
+    if (!write_all(fd, &header, sizeof(header))) {
+        return false;
+    }
+
+    // Oldest records up to the end of the ring, then the wrapped ones
+    auto first = (head - count) & mask_;
+    auto first_count = std::min<uint64_t>(count, capacity() - first);
+    return write_all(fd, records_.data() + first, first_count * sizeof(TraceRecord)) &&
+           write_all(fd, records_.data(), (count - first_count) * sizeof(TraceRecord));
+}
+
+void TraceBuffer::on_signal(int signal)
+{
+    const auto* buffer = signal_buffer.load();
+    if (buffer != nullptr) {
+        int fd = ::open(signal_path.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644); // NOLINT
+        if (fd >= 0) {
+            (void)buffer->write_to(fd);
+            ::close(fd);
+        }
+    }
+
+    // Crashes go on with their default action once flushed
+    if (signal != FlushSignal) {
+        std::signal(signal, SIG_DFL);
+        std::raise(signal);
+    }
+}
+
+void TraceBuffer::install_signal_handlers(const std::filesystem::path& path) const
+{
+    const auto& native = path.native();
+    if (native.size() >= signal_path.size()) {
+        log::warn("Trace file path too long, trace won't be flushed on crash: {}", path.string());
+        return;
+    }
+    signal_buffer.store(nullptr);
+    std::ranges::copy(native, signal_path.begin());
+    signal_path.at(native.size()) = '\0';
+    signal_buffer.store(this);
+
+    for (auto signal : CrashSignals) {
+        std::signal(signal, &TraceBuffer::on_signal);
+    }
+    std::signal(FlushSignal, &TraceBuffer::on_signal);
+}
+
+void TraceBuffer::remove_signal_handlers()
+{
+    for (auto signal : CrashSignals) {
+        std::signal(signal, SIG_DFL);
+    }
+    std::signal(FlushSignal, SIG_DFL);
+    signal_buffer.store(nullptr);
+}
+
+std::expected<std::vector<TraceRecord>, files::FileError> TraceBuffer::load(
+    const std::filesystem::path& path
+)
+{
+    auto data = files::read_binary(path);
+    if (!data) {
+        return std::unexpected(data.error());
+    }
+
+    auto invalid = [&path](const char* reason) {
+        return std::unexpected(files::FileError{files::FileError::Type::ReadError, path, reason});
+    };
+
+    TraceFileHeader header{};
+    if (data->size() < sizeof(header)) {
+        return invalid("not a trace file");
+    }
+    std::memcpy(&header, data->data(), sizeof(header));
+    if (header.magic != TraceFileHeader::Magic) {
+        return invalid("not a trace file");
+    }
+    if (header.version != TraceFileHeader::CurrentVersion ||
+        header.record_size != sizeof(TraceRecord)) {
+        return invalid("unsupported trace file version");
+    }
+    if (data->size() != sizeof(header) + (size_t{header.count} * sizeof(TraceRecord))) {
+        return invalid("truncated trace file");
+    }
+
+    std::vector<TraceRecord> records(header.count);
+    std::memcpy(records.data(), data->data() + sizeof(header), header.count * sizeof(TraceRecord));
+    return records;
+}
+
+std::string TraceBuffer::to_doctor(const TraceRecord& record)
+{
+    return std::format(
+        "A:{:02X} F:{:02X} B:{:02X} C:{:02X} D:{:02X} E:{:02X} H:{:02X} L:{:02X} SP:{:04X} "
+        "PC:{:04X} PCMEM:{:02X},{:02X},{:02X},{:02X}",
+        record.af >> 8,
+        record.af & 0xFF,
+        record.bc >> 8,
+        record.bc & 0xFF,
+        record.de >> 8,
+        record.de & 0xFF,
+        record.hl >> 8,
+        record.hl & 0xFF,
+        record.sp,
+        record.pc,
+        record.mem[0],
+        record.mem[1],
+        record.mem[2],
+        record.mem[3]
+    );
+}
+
+} // namespace boyboy::core::cpu
@@ -121,6 +121,7 @@ void Display::poll_events(bool& running)
                 break;
             case SDL_KEYDOWN:
                 handle_key_event(event, true);
+                handle_hotkey_event(event);
                 if (event.key.keysym.sym == SDLK_ESCAPE) {
                     SDL_Event quit_event;
                     quit_event.type = SDL_QUIT;
@@ -173,6 +174,25 @@ void Display::handle_key_event(const SDL_Event& event, bool pressed)
     }
 }
 
+void Display::handle_hotkey_event(const SDL_Event& event)
+{
+    // Held keys repeat, hotkeys act once per press
+    if (!hotkey_cb_ || event.key.repeat != 0) {
+        return;
+    }
+
+    switch (event.key.keysym.sym) {
+        case SDLK_p:
+            hotkey_cb_(Hotkey::Pause);
+            break;
+        case SDLK_n:
+            hotkey_cb_(Hotkey::Step);
+            break;
+        default:
+            break;
+    }
+}
+
 void Display::render_frame(const ppu::FrameBuffer& framebuffer)
 {
     BB_PROFILE_SCOPE(profiling::FrameTimer::Render);
@@ -7,18 +7,30 @@
 
 #include "boyboy/core/emulator/emulator.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <filesystem>
 #include <memory>
+#include <optional>
+#include <string_view>
 #include <thread>
+#include <utility>
 
 #include "boyboy/common/config/config.h"
 #include "boyboy/common/config/config_limits.h"
+#include "boyboy/common/files/io.h"
+#include "boyboy/common/files/paths.h"
 #include "boyboy/common/log/logging.h"
 #include "boyboy/common/save/save_manager.h"
+#include "boyboy/common/utils.h"
 #include "boyboy/core/cartridge/cartridge.h"
 #include "boyboy/core/cartridge/cartridge_loader.h"
 #include "boyboy/core/cpu/cpu.h"
 #include "boyboy/core/cpu/cycles.h"
+#include "boyboy/core/cpu/instructions.h"
+#include "boyboy/core/cpu/instructions_table.h"
+#include "boyboy/core/cpu/trace_buffer.h"
 #include "boyboy/core/display/display.h"
 #include "boyboy/core/io/apu.h"
 #include "boyboy/core/io/buttons.h"
@@ -27,6 +39,7 @@
 #include "boyboy/core/io/serial.h"
 #include "boyboy/core/io/timer.h"
 #include "boyboy/core/mmu/mmu.h"
+#include "boyboy/core/mmu/watchpoints.h"
 #include "boyboy/core/ppu/ppu.h"
 #include "boyboy/core/profiling/profiler_utils.h"
 
@@ -34,6 +47,31 @@ namespace boyboy::core::emulator {
 
 using namespace boyboy::common;
 
+namespace {
+
+// Max T-cycles to skip at once (one scanline), keeps tick lengths bounded
+constexpr uint32_t MaxSkipCycles = ppu::Cycles::VBlank;
+
+// Opcode sequence profile exported on stop with instrumentation, next to the ROM saves
+constexpr std::string_view SequenceProfileFile = "fusion_profile.csv";
+constexpr size_t SequenceProfileEntries = 256;
+
+// Per-opcode profile exported on stop with ENABLE_PROFILING, next to the ROM saves
+constexpr std::string_view OpcodeProfileCsvFile = "opcode_profile.csv";
+constexpr std::string_view OpcodeProfileJsonFile = "opcode_profile.json";
+
+// Guest call stacks exported on stop with ENABLE_PROFILING, in flamegraph folded format
+constexpr std::string_view CallProfileFile = "call_stacks.folded";
+
+// CPU trace flushed on stop, crash or SIGUSR1 with debug.trace, next to the ROM saves
+constexpr std::string_view TraceFile = "trace.bbt";
+
+// Executed code bitmaps and per bank summary written on stop with debug.coverage
+constexpr std::string_view CoverageFile = "coverage.bbc";
+constexpr std::string_view CoverageSummaryFile = "coverage.txt";
+
+} // namespace
+
 Emulator::Emulator()
     : io_(std::make_shared<io::Io>()),
       mmu_(std::make_shared<mmu::Mmu>(io_)),
@@ -44,7 +82,8 @@ Emulator::Emulator()
       serial_(std::make_shared<io::Serial>()),
       apu_(std::make_shared<io::Apu>()),
       display_(std::make_shared<display::Display>()),
-      cartridge_(std::make_unique<cartridge::Cartridge>())
+      cartridge_(std::make_unique<cartridge::Cartridge>()),
+      emulate_frame_fn_(&Emulator::emulate_frame<cpu::TickMode::MCycle, false, cpu::StepKind::Plain, false, false>)
 {
 }
 
@@ -62,6 +101,9 @@ void Emulator::init()
     mmu_->init();
     io_->init();
     cpu_->init();
+
+    // Catch-up mode ticks the peripherals from within instructions
+    cpu_->set_sync_callback([this](cpu::TCycle cycles) { tick_peripherals(cycles); });
 }
 
 void Emulator::reset()
@@ -91,6 +133,7 @@ void Emulator::start()
 
     // Hook system callbacks
     display_->set_button_cb([this](io::Button b, bool p) { on_button_event(b, p); });
+    display_->set_hotkey_cb([this](display::Hotkey hotkey) { on_hotkey(hotkey); });
     cartridge_->set_ram_load_cb([this]() {
         auto res = save::SaveManager::instance().load_sram(cartridge_->get_header().title);
         return (res.has_value()) ? res.value() : std::vector<uint8_t>{};
@@ -103,6 +146,15 @@ void Emulator::start()
     cartridge_->load_ram();
     display_->init();
 
+    if (cpu_->is_trace_enabled()) {
+        cpu_->get_trace_buffer().install_signal_handlers(trace_path());
+    }
+    if (cpu_->is_coverage_enabled()) {
+        cpu_->get_coverage().set_rom_banks(
+            cartridge::num_rom_banks(cartridge_->get_header().rom_size)
+        );
+    }
+
     started_ = true;
 }
 
@@ -117,6 +169,23 @@ void Emulator::stop()
 
     log::info("Stopping emulator...");
 
+    if (instrumented_ && cpu_->is_block_cache_enabled()) {
+        export_sequence_profile();
+    }
+
+#ifdef ENABLE_PROFILING
+    export_opcode_profile();
+    export_call_profile();
+#endif
+
+    if (cpu_->is_trace_enabled()) {
+        dump_trace();
+        cpu::TraceBuffer::remove_signal_handlers();
+    }
+    if (cpu_->is_coverage_enabled()) {
+        dump_coverage();
+    }
+
     BB_PROFILE_REPORT();
     BB_HOT_PROFILE_REPORT();
     BB_FRAME_PROFILE_REPORT();
@@ -138,8 +207,15 @@ void Emulator::run()
     running_ = true;
     while (running_) {
         display_->poll_events(running_);
-        emulate_frame();
-        render_frame();
+
+        // A watchpoint break leaves the frame unfinished until resumed (or stepped through)
+        if (!paused_) {
+            emulate_frame();
+            check_watch_break();
+        }
+        if (ppu_->frame_ready()) {
+            render_frame();
+        }
 
         // Frame limiting (if needed) at 59.73Hz * speed_
         if (frame_rate_limited_) {
@@ -175,6 +251,9 @@ void Emulator::apply_config(const common::config::Config& config)
     else if (config.emulator.tick_mode == config::ConfigLimits::Emulator::PrecisionMode) {
         tick_mode = cpu::TickMode::TCycle;
     }
+    else if (config.emulator.tick_mode == config::ConfigLimits::Emulator::CatchUpMode) {
+        tick_mode = cpu::TickMode::CatchUp;
+    }
     else {
         log::warn("Unknown emulator config tick mode: {}", config.emulator.tick_mode);
     }
@@ -182,6 +261,17 @@ void Emulator::apply_config(const common::config::Config& config)
     // Set CPU settings
     cpu_->set_tick_mode(tick_mode);
     cpu_->enable_fe_overlap(config.emulator.fe_overlap);
+    cpu_->enable_block_cache(config.emulator.block_cache);
+    cpu_->enable_block_batching(config.emulator.block_batching);
+    cpu_->enable_idle_loop_skip(config.emulator.idle_loop_skip);
+    cpu_->enable_fusion(config.emulator.superinstructions);
+    cpu_->enable_microcode(config.emulator.microcode);
+    cpu_->enable_trace(config.debug.trace);
+    cpu_->enable_coverage(config.debug.coverage);
+
+    // Select the emulation loop once, the loop itself doesn't check the configuration
+    instrumented_ = config.debug.instrumentation;
+    select_emulate_frame_fn();
 
     // Video settings
     display_->set_scale(config.video.scale);
@@ -196,9 +286,95 @@ void Emulator::apply_config(const common::config::Config& config)
 
     log::info("Running CPU with tick mode: {}", to_string(tick_mode));
     log::info("CPU fetch/execute overlap: {}", config.emulator.fe_overlap ? "enabled" : "disabled");
+    log::info("CPU block cache: {}", config.emulator.block_cache ? "enabled" : "disabled");
+    log::info("CPU block batching: {}", config.emulator.block_batching ? "enabled" : "disabled");
+    log::info("Idle loop skipping: {}", config.emulator.idle_loop_skip ? "enabled" : "disabled");
+    log::info(
+        "CPU superinstructions: {}", config.emulator.superinstructions ? "enabled" : "disabled"
+    );
+    log::info("CPU microcode: {}", config.emulator.microcode ? "enabled" : "disabled");
+    log::info("Instrumentation: {}", instrumented_ ? "enabled" : "disabled");
+    log::info("CPU trace: {}", config.debug.trace ? "enabled" : "disabled");
+    log::info("CPU coverage: {}", config.debug.coverage ? "enabled" : "disabled");
     log::info("Configuration applied");
 }
 
+size_t Emulator::add_watchpoint(uint16_t start, uint16_t end, mmu::WatchKind kinds)
+{
+    auto id = mmu_->add_watchpoint(start, end, kinds);
+
+    // Predecoded blocks would run the trapped code without fetching it
+    cpu_->get_block_cache().clear();
+    select_emulate_frame_fn();
+    return id;
+}
+
+bool Emulator::remove_watchpoint(size_t id)
+{
+    bool removed = mmu_->remove_watchpoint(id);
+    select_emulate_frame_fn();
+    return removed;
+}
+
+void Emulator::set_watch_callback(mmu::Watchpoints::Callback callback)
+{
+    mmu_->set_watch_callback(std::move(callback));
+}
+
+const std::optional<mmu::WatchHit>& Emulator::watch_hit() const
+{
+    return mmu_->watch_hit();
+}
+
+void Emulator::resume()
+{
+    mmu_->clear_watch_hit();
+    paused_ = false;
+}
+
+void Emulator::step()
+{
+    paused_ = true;
+    mmu_->clear_watch_hit();
+
+    auto cycles = cpu_->tick();
+    instruction_count_++;
+    tick_peripherals(cycles);
+    check_watch_break();
+}
+
+std::optional<mmu::WatchHit> Emulator::run_until_watch(size_t max_frames)
+{
+    resume();
+    for (size_t frame = 0; frame < max_frames; ++frame) {
+        emulate_frame();
+        if (check_watch_break()) {
+            return mmu_->watch_hit();
+        }
+        end_frame();
+    }
+    return std::nullopt;
+}
+
+bool Emulator::check_watch_break()
+{
+    const auto& hit = mmu_->watch_hit();
+    if (!hit) [[likely]] {
+        return false;
+    }
+
+    log::info(
+        "Watchpoint {} hit: {} at {} ({}), PC={}",
+        hit->id,
+        mmu::to_string(hit->kind),
+        utils::PrettyHex(hit->addr).to_string(),
+        utils::PrettyHex(hit->value).to_string(),
+        utils::PrettyHex(cpu_->get_pc()).to_string()
+    );
+    paused_ = true;
+    return true;
+}
+
 void Emulator::on_button_event(io::Button button, bool pressed)
 {
     if (pressed) {
@@ -209,19 +385,148 @@ void Emulator::on_button_event(io::Button button, bool pressed)
     }
 }
 
+void Emulator::on_hotkey(display::Hotkey hotkey)
+{
+    switch (hotkey) {
+        case display::Hotkey::Pause:
+            if (paused_) {
+                log::info("Emulator resumed");
+                resume();
+            }
+            else {
+                log::info("Emulator paused");
+                pause();
+            }
+            break;
+        case display::Hotkey::Step:
+            step();
+            log::info("Stepped to PC={}", utils::PrettyHex(cpu_->get_pc()).to_string());
+            break;
+    }
+}
+
+void Emulator::select_emulate_frame_fn()
+{
+    bool watched = !mmu_->watchpoints().empty();
+    bool fe_overlap = cpu_->is_fe_overlap_enabled();
+    auto step = cpu_->get_step_kind();
+    switch (cpu_->get_tick_mode()) {
+        case cpu::TickMode::Instruction:
+            emulate_frame_fn_ = select_emulate_frame<cpu::TickMode::Instruction>(
+                fe_overlap, step, instrumented_, watched
+            );
+            break;
+        case cpu::TickMode::MCycle:
+            emulate_frame_fn_ = select_emulate_frame<cpu::TickMode::MCycle>(
+                fe_overlap, step, instrumented_, watched
+            );
+            break;
+        case cpu::TickMode::TCycle:
+            emulate_frame_fn_ = select_emulate_frame<cpu::TickMode::TCycle>(
+                fe_overlap, step, instrumented_, watched
+            );
+            break;
+        case cpu::TickMode::CatchUp:
+            emulate_frame_fn_ = select_emulate_frame<cpu::TickMode::CatchUp>(
+                fe_overlap, step, instrumented_, watched
+            );
+            break;
+    }
+}
+
+template <cpu::TickMode Mode>
+Emulator::EmulateFrameFn Emulator::select_emulate_frame(
+    bool fe_overlap, cpu::StepKind step, bool instrumented, bool watched
+)
+{
+    // Fetch/execute overlap only applies to the M-cycle and T-cycle modes
+    if constexpr (Mode != cpu::TickMode::Instruction && Mode != cpu::TickMode::CatchUp) {
+        if (fe_overlap) {
+            return select_emulate_frame<Mode, true>(step, instrumented, watched);
+        }
+    }
+    return select_emulate_frame<Mode, false>(step, instrumented, watched);
+}
+
+template <cpu::TickMode Mode, bool FeOverlap>
+Emulator::EmulateFrameFn Emulator::select_emulate_frame(
+    cpu::StepKind step, bool instrumented, bool watched
+)
+{
+    // Batches only run in instruction mode (see Cpu::get_step_kind())
+    if constexpr (Mode == cpu::TickMode::Instruction) {
+        if (step == cpu::StepKind::Batched) {
+            return select_emulate_frame<Mode, FeOverlap, cpu::StepKind::Batched>(
+                instrumented, watched
+            );
+        }
+    }
+    if (step == cpu::StepKind::Recorded) {
+        return select_emulate_frame<Mode, FeOverlap, cpu::StepKind::Recorded>(
+            instrumented, watched
+        );
+    }
+    return select_emulate_frame<Mode, FeOverlap, cpu::StepKind::Plain>(instrumented, watched);
+}
+
+template <cpu::TickMode Mode, bool FeOverlap, cpu::StepKind Step>
+Emulator::EmulateFrameFn Emulator::select_emulate_frame(bool instrumented, bool watched)
+{
+    if (instrumented) {
+        return watched ? &Emulator::emulate_frame<Mode, FeOverlap, Step, true, true>
+                       : &Emulator::emulate_frame<Mode, FeOverlap, Step, true, false>;
+    }
+    return watched ? &Emulator::emulate_frame<Mode, FeOverlap, Step, false, true>
+                   : &Emulator::emulate_frame<Mode, FeOverlap, Step, false, false>;
+}
+
+inline void Emulator::tick_peripherals(uint32_t cycles)
+{
+    cycle_count_ += cycles;
+    BB_PROFILE_GUEST_CYCLES(cycles);
+
+    mmu_->tick_dma(cycles);
+    io_->tick(cycles);
+    cartridge_->tick();
+}
+
+template <
+    cpu::TickMode Mode,
+    bool FeOverlap,
+    cpu::StepKind Step,
+    bool Instrumented,
+    bool Watched>
 void Emulator::emulate_frame()
 {
     while (!ppu_->frame_ready()) {
-        auto cycles = cpu_->tick();
+        // A halted or idle CPU jumps straight to the next event, otherwise tick as usual
+        auto cycles = fast_forward_halt<Instrumented>();
+        if constexpr (Mode == cpu::TickMode::Instruction) {
+            if (cycles == 0) {
+                cycles = skip_idle_loop<Instrumented>();
+            }
+        }
+        if (cycles == 0) {
+            if constexpr (Instrumented) {
+                BB_PROFILE_SCOPE(profiling::FrameTimer::Cpu);
+                cycles = cpu_->tick<Mode, FeOverlap, Step>();
+            }
+            else {
+                cycles = cpu_->tick<Mode, FeOverlap, Step>();
+            }
+        }
         instruction_count_++;
-        cycle_count_ += cycles;
+        tick_peripherals(cycles);
 
-        mmu_->tick_dma(cycles);
-        io_->tick(cycles);
-        cartridge_->tick();
+        // Break on watchpoint hits, leaving the frame unfinished
+        if constexpr (Watched) {
+            if (mmu_->watch_hit()) [[unlikely]] {
+                return;
+            }
+        }
     }
 
-    // Check if there is any drift in the cycle count
+    // Check if there is any drift in the cycle count (batches end at the frame end event too)
     constexpr int CycleDriftTolerance = 8;
     int64_t cycle_diff = static_cast<int64_t>(cycle_count_) -
                          static_cast<int64_t>(ppu::CyclesPerFrame);
@@ -230,15 +535,159 @@ void Emulator::emulate_frame()
     }
 }
 
+template <bool Instrumented>
+uint32_t Emulator::fast_forward_halt()
+{
+    if (!cpu_->is_halted() || mmu_->is_dma_active()) {
+        return 0;
+    }
+
+    auto cycles = cpu_->fast_forward(std::min(io_->cycles_to_event(), MaxSkipCycles));
+    if constexpr (Instrumented) {
+        BB_PROFILE_COUNTER(profiling::FrameCounter::HaltSkippedCycles, cycles);
+    }
+    return cycles;
+}
+
+template <bool Instrumented>
+uint32_t Emulator::skip_idle_loop()
+{
+    if (!cpu_->is_idle_loop_skip_enabled() || mmu_->is_dma_active()) {
+        return 0;
+    }
+
+    auto cycles = cpu_->skip_idle_loop(io_->cycles_to_event(), MaxSkipCycles);
+    if constexpr (Instrumented) {
+        BB_PROFILE_COUNTER(profiling::FrameCounter::IdleLoopSkippedCycles, cycles);
+    }
+    return cycles;
+}
+
 void Emulator::render_frame()
 {
     display_->render_frame(ppu_->framebuffer());
+    end_frame();
+}
+
+void Emulator::end_frame()
+{
     ppu_->consume_frame();
 
     // Update and log frame statistics
+    if (cpu_->is_block_cache_enabled()) {
+        auto& block_cache = cpu_->get_block_cache();
+        const auto& stats = block_cache.stats();
+        if (instrumented_) {
+            BB_PROFILE_COUNTER(profiling::FrameCounter::BlockCacheHits, stats.hits);
+            BB_PROFILE_COUNTER(profiling::FrameCounter::BlockCacheMisses, stats.misses);
+            BB_PROFILE_COUNTER(
+                profiling::FrameCounter::BlockCacheInvalidations, stats.invalidations
+            );
+            BB_PROFILE_COUNTER(profiling::FrameCounter::BatchedInstructions, stats.batched);
+            BB_PROFILE_COUNTER(profiling::FrameCounter::FusedInstructions, stats.fused);
+        }
+
+        // Batched and fused instructions run inside a single CPU tick
+        instruction_count_ += stats.batched + stats.fused;
+        block_cache.reset_stats();
+    }
     BB_PROFILE_FRAME(instruction_count_, cycle_count_);
     instruction_count_ = 0;
     cycle_count_ = 0;
 }
 
-} // namespace boyboy::core::emulator
\ No newline at end of file
+void Emulator::export_sequence_profile() const
+{
+    auto path = files::DataDir / utils::normalize_rom_title(cartridge_->get_header().title) /
+                SequenceProfileFile;
+    auto csv = cpu_->get_block_cache().profile().to_csv(SequenceProfileEntries);
+
+    auto res = files::write_text(path, csv);
+    if (!res) {
+        log::error("Error writing opcode sequence profile: {}", res.error().error_message());
+        return;
+    }
+    log::info("Opcode sequence profile written to: {}", path.string());
+}
+
+void Emulator::export_opcode_profile() const
+{
+    using profiling::OpcodeProfiler;
+
+    std::array<std::string_view, OpcodeProfiler::OpcodeCount> mnemonics{};
+    for (size_t opcode = 0; opcode < 256; ++opcode) {
+        auto op = static_cast<uint8_t>(opcode);
+        mnemonics.at(OpcodeProfiler::index(false, op)) =
+            cpu::InstructionTable::mnemonic(cpu::InstructionType::Unprefixed, op);
+        mnemonics.at(OpcodeProfiler::index(true, op)) =
+            cpu::InstructionTable::mnemonic(cpu::InstructionType::CBPrefixed, op);
+    }
+
+    const auto& profiler = profiling::get_opcode_profiler();
+    auto dir = files::DataDir / utils::normalize_rom_title(cartridge_->get_header().title);
+
+    for (auto [file, text] : {
+             std::pair{OpcodeProfileCsvFile, profiler.to_csv(mnemonics)},
+             std::pair{OpcodeProfileJsonFile, profiler.to_json(mnemonics)},
+         }) {
+        auto path = dir / file;
+        auto res = files::write_text(path, text);
+        if (!res) {
+            log::error("Error writing opcode profile: {}", res.error().error_message());
+            return;
+        }
+        log::info("Opcode profile written to: {}", path.string());
+    }
+}
+
+void Emulator::export_call_profile() const
+{
+    auto path = files::DataDir / utils::normalize_rom_title(cartridge_->get_header().title) /
+                CallProfileFile;
+    auto res = files::write_text(path, profiling::get_call_profiler().to_folded());
+    if (!res) {
+        log::error("Error writing call profile: {}", res.error().error_message());
+        return;
+    }
+    log::info("Call profile written to: {}", path.string());
+}
+
+std::filesystem::path Emulator::trace_path() const
+{
+    return files::DataDir / utils::normalize_rom_title(cartridge_->get_header().title) / TraceFile;
+}
+
+void Emulator::dump_trace() const
+{
+    auto path = trace_path();
+    auto res = cpu_->get_trace_buffer().flush(path);
+    if (!res) {
+        log::error("Error writing CPU trace: {}", res.error().error_message());
+        return;
+    }
+    log::info("CPU trace written to: {}", path.string());
+}
+
+void Emulator::dump_coverage() const
+{
+    const auto& coverage = cpu_->get_coverage();
+    auto dir = files::DataDir / utils::normalize_rom_title(cartridge_->get_header().title);
+
+    auto path = dir / CoverageFile;
+    auto res = coverage.flush(path);
+    if (!res) {
+        log::error("Error writing CPU coverage: {}", res.error().error_message());
+        return;
+    }
+    log::info("CPU coverage written to: {}", path.string());
+
+    auto summary_path = dir / CoverageSummaryFile;
+    res = files::write_text(summary_path, coverage.summary());
+    if (!res) {
+        log::error("Error writing CPU coverage summary: {}", res.error().error_message());
+        return;
+    }
+    log::info("CPU coverage summary written to: {}", summary_path.string());
+}
+
+} // namespace boyboy::core::emulator
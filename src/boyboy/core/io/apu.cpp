@@ -49,6 +49,11 @@ void Apu::reset()
 
 void Apu::tick(uint16_t /*cycles*/) {}
 
+[[nodiscard]] uint32_t Apu::cycles_to_event() const
+{
+    return NoEvent;
+}
+
 [[nodiscard]] uint8_t Apu::read(uint16_t addr) const
 {
     return registers_.at(IoReg::Apu::local_addr(addr));
@@ -7,6 +7,8 @@
 
 #include "boyboy/core/io/io.h"
 
+#include <algorithm>
+
 #include "boyboy/common/log/logging.h"
 #include "boyboy/common/utils.h"
 #include "boyboy/core/io/apu.h"
@@ -24,7 +26,8 @@ void Io::init()
 {
     // Initialize registers (assume DMG0)
     registers_.fill(0xFF);
-    registers_.at(io_addr(IoReg::Interrupts::IF)) = RegInitValues::Dmg0::Interrupts::IF;
+    interrupts_.set_if(RegInitValues::Dmg0::Interrupts::IF);
+    interrupts_.set_ie(RegInitValues::Dmg0::Interrupts::IE);
 
     // Initialize components
     for (auto& component : components_) {
@@ -36,7 +39,8 @@ void Io::reset()
 {
     // Reset registers (assume DMG0)
     registers_.fill(0xFF);
-    registers_.at(io_addr(IoReg::Interrupts::IF)) = RegInitValues::Dmg0::Interrupts::IF;
+    interrupts_.set_if(RegInitValues::Dmg0::Interrupts::IF);
+    interrupts_.set_ie(RegInitValues::Dmg0::Interrupts::IE);
 
     // Reset components
     for (auto& component : components_) {
@@ -51,6 +55,15 @@ void Io::tick(uint16_t cycles)
     }
 }
 
+[[nodiscard]] uint32_t Io::cycles_to_event() const
+{
+    uint32_t cycles = IoComponent::NoEvent;
+    for (const auto& component : components_) {
+        cycles = std::min(cycles, component->cycles_to_event());
+    }
+    return cycles;
+}
+
 [[nodiscard]] uint8_t Io::read(uint16_t addr) const
 {
     if (IoReg::Ppu::contains(addr)) {
@@ -68,6 +81,12 @@ void Io::tick(uint16_t cycles)
     if (IoReg::Apu::contains(addr)) {
         return component_read(apu_.get(), addr);
     }
+    if (addr == IoReg::Interrupts::IF) {
+        return interrupts_.iflag();
+    }
+    if (addr == IoReg::Interrupts::IE) {
+        return interrupts_.ie();
+    }
 
     // Default behavior: return the value in the register
     return registers_.at(io_addr(addr));
@@ -102,6 +121,14 @@ void Io::write(uint16_t addr, uint8_t value)
             (addr == IoReg::Interrupts::IE) ? "IE" : "IF",
             common::utils::PrettyHex(value).to_string()
         );
+
+        if (addr == IoReg::Interrupts::IE) {
+            interrupts_.set_ie(value);
+        }
+        else {
+            interrupts_.set_if(value);
+        }
+        return;
     }
 
     // Default behavior: write the value to the register
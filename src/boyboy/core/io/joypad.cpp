@@ -36,6 +36,12 @@ void Joypad::tick(uint16_t /*cycles*/)
     // Joypad does not need to do anything on tick
 }
 
+[[nodiscard]] uint32_t Joypad::cycles_to_event() const
+{
+    // Button presses are delivered between frames
+    return NoEvent;
+}
+
 [[nodiscard]] uint8_t Joypad::read(uint16_t addr) const
 {
     if (!IoReg::Joypad::contains(addr)) {
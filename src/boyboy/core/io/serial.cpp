@@ -32,6 +32,12 @@ void Serial::reset()
 
 void Serial::tick([[maybe_unused]] uint16_t cycles) {}
 
+[[nodiscard]] uint32_t Serial::cycles_to_event() const
+{
+    // Transfers complete immediately, no serial clock is emulated
+    return NoEvent;
+}
+
 [[nodiscard]] uint8_t Serial::read([[maybe_unused]] uint16_t addr) const
 {
     switch (addr) {
@@ -57,10 +57,14 @@ void Timer::tick(uint16_t cycles)
         auto cur_cycles = std::min(cycles, uint16_t{4});
 
         if (tima_overflow_scheduler_.scheduled) {
-            tima_overflow_scheduler_.update(cur_cycles);
+            if (tima_overflow_scheduler_.update(cur_cycles)) {
+                reload_tima();
+            }
         }
         else if (tima_reload_scheduler_.scheduled) {
-            tima_reload_scheduler_.update(cur_cycles);
+            if (tima_reload_scheduler_.update(cur_cycles)) {
+                tima_reload_ = false;
+            }
         }
 
         // Update DIV counter
@@ -75,6 +79,28 @@ void Timer::tick(uint16_t cycles)
     }
 }
 
+uint32_t Timer::cycles_to_event() const
+{
+    if (stopped_) {
+        return NoEvent;
+    }
+
+    // Overflow or reload in progress
+    if (tima_overflow_ || tima_overflow_scheduler_.scheduled || tima_reload_scheduler_.scheduled) {
+        return 0;
+    }
+
+    if (!is_enabled()) {
+        return NoEvent;
+    }
+
+    // TIMA increments on each falling edge of the tested system counter bit, the overflow happens
+    // on the increment that wraps TIMA to 0
+    uint32_t period = 1U << (get_test_bit() + 1);
+    uint32_t next_edge = period - (div_counter_ & (period - 1));
+    return next_edge + ((0xFFU - tima_) * period);
+}
+
 uint8_t Timer::read(uint16_t addr) const
 {
     switch (addr) {
@@ -5,9 +5,6 @@
  * @license GPLv3 (see LICENSE file)
  */
 
-// TODO: handle better mirrored memory sections
-//       We actually only have one (ECHO -> WRAM) and it behaves differently depending on the
-//       cartridge type and GB HW version (DMG/CGB). Check "The Cycle-Accurate Game Boy Docs"
 // TODO: read/write word and copy are only used in tests. Consider removing them.
 
 #include "boyboy/core/mmu/mmu.h"
@@ -15,6 +12,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <span>
 #include <stdexcept>
@@ -23,7 +21,6 @@
 #include "boyboy/common/log/logging.h"
 #include "boyboy/common/utils.h"
 #include "boyboy/core/cartridge/cartridge.h"
-#include "boyboy/core/io/constants.h"
 #include "boyboy/core/io/io.h"
 #include "boyboy/core/mmu/constants.h"
 #include "boyboy/core/profiling/profiler_utils.h"
@@ -36,26 +33,31 @@ Mmu::Mmu(std::shared_ptr<io::Io> io) : io_(std::move(io)) {}
 
 void Mmu::init()
 {
-    // IE register (assume DMG0)
-    // TODO: move to IO?
-    ier_ = io::RegInitValues::Dmg0::Interrupts::IE;
-
     // Init memory regions
     vram_.fill(0);
     wram_.fill(0);
     oam_.fill(0);
     hram_.fill(0);
-    ier_ = 0;
+    io_->interrupts().set_ie(0);
 
-    // Set memory unlocked
+    // Set memory unlocked, no DMA transfer
     lock_vram_ = false;
     lock_oam_ = false;
+    dma_.reset();
 
-    // Initialize memory map
+    // Initialize memory map, the ROM has to be mapped again
     init_memory_map();
-
-    // Init DMA
-    dma_.reset();
+    cart_ = nullptr;
+    rom_loaded_ = false;
+    map_generation_++;
+    map_pages(0x0000, MemoryMapSize - 1);
+
+    // Memory was cleared, drop any code cached from it
+    for (size_t page = 0; page < PageCount; ++page) {
+        if (code_pages_.at(page)) {
+            notify_code_write(static_cast<uint16_t>(page << 8));
+        }
+    }
 }
 
 void Mmu::reset()
@@ -65,35 +67,65 @@ void Mmu::reset()
 
 void Mmu::map_rom(cartridge::Cartridge& cart)
 {
-    auto& rom_bank0 = map(MemoryRegionID::ROMBank0);
-    auto& rom_bank1 = map(MemoryRegionID::ROMBank1);
-    auto& sram = map(MemoryRegionID::SRAM);
+    map(MemoryRegionID::ROMBank0).handler = RegionHandler::Rom;
+    map(MemoryRegionID::ROMBank1).handler = RegionHandler::Rom;
+    map(MemoryRegionID::SRAM).handler = RegionHandler::Sram;
 
-    auto cart_read = [&cart](uint16_t addr) -> uint8_t {
-        return cart.mbc_read(addr);
-    };
-    auto cart_write = [&cart](uint16_t addr, uint8_t value) {
-        cart.mbc_write(addr, value);
+    cart_ = &cart;
+    rom_loaded_ = true;
+    map_generation_++;
+    map_pages(0x0000, MemoryMapSize - 1);
+}
+
+void Mmu::map_flat_ram(std::span<uint8_t, MemoryMapSize> ram, BusCallback callback)
+{
+    // Accesses are only seen through the handler, the pages are direct otherwise
+    auto& flat = map(MemoryRegionID::Flat);
+    flat = {
+        .id = MemoryRegionID::Flat,
+        .start = 0x0000,
+        .end = MemoryMapSize - 1,
+        .data = ram,
+        .handler = callback ? RegionHandler::Flat : RegionHandler::None,
     };
+    flat_callback_ = std::move(callback);
+    region_lut_.fill(&flat);
+    high_pages_direct_ = false;
+
+    cart_ = nullptr;
+    rom_loaded_ = false;
+    map_generation_++;
+    map_pages(0x0000, MemoryMapSize - 1);
+}
 
-    // Map ROMBank0 (0x0000 - 0x3FFF)
-    rom_bank0.read_handler = cart_read;
-    rom_bank0.write_handler = cart_write;
+uint16_t Mmu::rom_bank() const
+{
+    // Without a cartridge (or with a ROM only one) bank 1 is always mapped
+    return (cart_ != nullptr) ? cart_->get_mbc().rom_bank() : 1;
+}
 
-    // Map ROMBank1 (0x4000 - 0x7FFF)
-    rom_bank1.read_handler = cart_read;
-    rom_bank1.write_handler = cart_write;
+const uint8_t* Mmu::fetch_page(uint16_t addr) const
+{
+    if (is_fetch_trapped(addr)) {
+        return nullptr;
+    }
 
-    // Map SRAM (0xA000 - 0xBFFF)
-    sram.read_handler = cart_read;
-    sram.write_handler = cart_write;
+    const auto& region = region_lookup(addr);
 
-    rom_loaded_ = true;
+    switch (region.id) {
+        case MemoryRegionID::ROMBank0:
+        case MemoryRegionID::ROMBank1:
+            return (cart_ != nullptr) ? cart_->get_mbc().rom_page(addr) : nullptr;
+        case MemoryRegionID::WRAM0:
+        case MemoryRegionID::WRAM1:
+            // WRAM regions are page aligned
+            return region.data.data() + ((addr - region.start) & 0xFF00);
+        default:
+            return nullptr;
+    }
 }
 
-// NOLINTBEGIN(misc-no-recursion)
-
-uint8_t Mmu::read_byte(uint16_t addr, bool unlocked) const
+inline uint8_t Mmu::read_mapped(uint16_t addr, bool unlocked) const
 {
     BB_PROFILE_START(profiling::HotSection::MmuRead);
 
@@ -104,30 +136,8 @@ uint8_t Mmu::read_byte(uint16_t addr, bool unlocked) const
         return OpenBusValue;
     }
 
-    if (region.mirrored) {
-        if (!region.mirror) {
-            BB_PROFILE_STOP(profiling::HotSection::MmuRead);
-
-            throw std::runtime_error("Mirrored region missing mirror target");
-        }
-        const auto& mirror = map(*region.mirror);
-        uint16_t mirror_addr = mirror.start + (addr - region.start);
-
-        log::debug(
-            "Read from mirrored region at {}: [{}] (mirrored to {})",
-            common::utils::PrettyHex(addr).to_string(),
-            common::utils::PrettyHex(mirror.data[addr - region.start]).to_string(),
-            common::utils::PrettyHex(mirror_addr).to_string()
-        );
-
-        uint8_t result = read_byte(mirror_addr);
-        BB_PROFILE_STOP(profiling::HotSection::MmuRead);
-
-        return result;
-    }
-
-    if (region.read_handler) {
-        uint8_t result = region.read_handler(addr);
+    if (region.handler != RegionHandler::None) {
+        uint8_t result = handler_read(region, addr);
         BB_PROFILE_STOP(profiling::HotSection::MmuRead);
 
         return result;
@@ -139,28 +149,44 @@ uint8_t Mmu::read_byte(uint16_t addr, bool unlocked) const
     return result;
 }
 
-uint16_t Mmu::read_word(uint16_t addr) const
+uint8_t Mmu::read_region(uint16_t addr, bool unlocked) const
 {
-    const auto& region = region_lookup(addr);
+    // DMA transfers and watchpoints are rare, a single branch keeps them off the region paths
+    if (dma_.active || !watchpoints_.empty()) [[unlikely]] {
+        return read_observed(addr, unlocked);
+    }
 
-    if (region.mirrored) {
-        if (!region.mirror) {
-            throw std::runtime_error("Mirrored region missing mirror target");
-        }
-        const auto& mirror = map(*region.mirror);
-        uint16_t mirror_addr = mirror.start + (addr - region.start);
+    // The top pages and the cartridge skip the region lookup
+    if (addr >= OAMStart && high_pages_direct_) {
+        return read_high_pages(addr, unlocked);
+    }
+    if (cart_ != nullptr && is_cartridge_address(addr)) {
+        return cart_->mbc_read(addr);
+    }
+    return read_mapped(addr, unlocked);
+}
 
-        log::debug(
-            "Read from mirrored region at {} (mirrored to {})",
-            common::utils::PrettyHex(addr).to_string(),
-            common::utils::PrettyHex(mirror_addr).to_string()
-        );
+uint8_t Mmu::read_observed(uint16_t addr, bool unlocked) const
+{
+    // OAM is on the DMA bus: the CPU sees OpenBus, the PPU the bytes copied so far
+    bool dma_bus = dma_.active && region_lookup(addr).id == MemoryRegionID::OAM;
+    if (dma_bus && unlocked) {
+        sync_dma();
+    }
 
-        return read_word(mirror_addr);
+    uint8_t value = (dma_bus && !unlocked) ? OpenBusValue : read_mapped(addr, unlocked);
+    if (!unlocked) {
+        watchpoints_.check(unmirror(addr), value, WatchKind::Read);
     }
+    return value;
+}
 
-    if (region.read_handler) {
-        return region.read_handler(addr);
+uint16_t Mmu::read_word(uint16_t addr) const
+{
+    const auto& region = region_lookup(addr);
+
+    if (region.handler != RegionHandler::None) {
+        return handler_read(region, addr);
     }
 
     uint16_t local_addr = addr - region.start;
@@ -168,21 +194,10 @@ uint16_t Mmu::read_word(uint16_t addr) const
     return common::utils::to_u16(region.data[local_addr + 1], region.data[local_addr]);
 }
 
-void Mmu::write_byte(uint16_t addr, uint8_t value, bool unlocked)
+inline void Mmu::write_mapped(uint16_t addr, uint8_t value, bool unlocked)
 {
     BB_PROFILE_START(profiling::HotSection::MmuWrite);
 
-    if (dma_.active && addr >= OAMStart && addr <= OAMEnd) {
-        // Ignore writes to OAM during DMA transfer
-        log::warn(
-            "Attempted write to OAM during DMA transfer at {}",
-            common::utils::PrettyHex(addr).to_string()
-        );
-        BB_PROFILE_STOP(profiling::HotSection::MmuWrite);
-
-        return;
-    }
-
     auto& region = region_lookup(addr);
 
     // Check if region is accessible
@@ -199,42 +214,74 @@ void Mmu::write_byte(uint16_t addr, uint8_t value, bool unlocked)
         return;
     }
 
-    if (region.mirrored) {
-        if (!region.mirror) {
-            BB_PROFILE_STOP(profiling::HotSection::MmuWrite);
+    if (region.handler != RegionHandler::None) {
+        handler_write(region, addr, value);
+        BB_PROFILE_STOP(profiling::HotSection::MmuWrite);
 
-            throw std::runtime_error("Mirrored region missing mirror target");
-        }
-        const auto& mirror = map(*region.mirror);
-        uint16_t mirror_addr = mirror.start + (addr - region.start);
+        return;
+    }
 
-        log::debug(
-            "Write to mirrored region at {}: [{}] (mirrored to {})",
-            common::utils::PrettyHex(addr).to_string(),
-            common::utils::PrettyHex(value).to_string(),
-            common::utils::PrettyHex(mirror_addr).to_string()
-        );
+    region.data[addr - region.start] = value;
 
-        BB_PROFILE_STOP(profiling::HotSection::MmuWrite);
-        write_byte(mirror_addr, value);
+    BB_PROFILE_STOP(profiling::HotSection::MmuWrite);
+}
 
+void Mmu::write_region(uint16_t addr, uint8_t value, bool unlocked)
+{
+    // DMA transfers and watchpoints are rare, a single branch keeps them off the region paths
+    if (dma_.active || !watchpoints_.empty()) [[unlikely]] {
+        notify_code_write(addr);
+        write_observed(addr, value, unlocked);
         return;
     }
 
-    if (region.write_handler) {
-        region.write_handler(addr, value);
-        BB_PROFILE_STOP(profiling::HotSection::MmuWrite);
+    // The top pages and the cartridge skip the region lookup
+    if (addr >= OAMStart && high_pages_direct_) {
+        write_high_pages(addr, value, unlocked);
+        return;
+    }
+    notify_code_write(addr);
+    if (cart_ != nullptr && is_cartridge_address(addr)) {
+        if (addr <= ROMBank1End) {
+            mbc_register_write(addr, value);
+        }
+        else {
+            cart_->mbc_write(addr, value);
+        }
+        return;
+    }
+    write_mapped(addr, value, unlocked);
+}
 
+void Mmu::write_observed(uint16_t addr, uint8_t value, bool unlocked)
+{
+    if (!unlocked) {
+        watchpoints_.check(unmirror(addr), value, WatchKind::Write);
+    }
+
+    if (dma_.active && addr >= OAMStart && addr <= OAMEnd) {
+        // Ignore writes to OAM during DMA transfer
+        log::warn(
+            "Attempted write to OAM during DMA transfer at {}",
+            common::utils::PrettyHex(addr).to_string()
+        );
         return;
     }
 
-    region.data[addr - region.start] = value;
+    // Bytes already transferred keep their value: copy them before the source page or the
+    // cartridge banking changes
+    if (dma_.active && (is_dma_source(addr) || addr <= ROMBank1End)) {
+        sync_dma();
+    }
 
-    BB_PROFILE_STOP(profiling::HotSection::MmuWrite);
+    write_mapped(addr, value, unlocked);
 }
 
 void Mmu::write_word(uint16_t addr, uint16_t value)
 {
+    notify_code_write(addr);
+    notify_code_write(addr + 1);
+
     auto& region = region_lookup(addr);
 
     if (region.read_only) {
@@ -244,25 +291,8 @@ void Mmu::write_word(uint16_t addr, uint16_t value)
         return;
     }
 
-    if (region.mirrored) {
-        if (!region.mirror) {
-            throw std::runtime_error("Mirrored region missing mirror target");
-        }
-        const auto& mirror = map(*region.mirror);
-        uint16_t mirror_addr = mirror.start + (addr - region.start);
-
-        log::debug(
-            "Write to mirrored region at {} (mirrored to {})",
-            common::utils::PrettyHex(addr).to_string(),
-            common::utils::PrettyHex(mirror_addr).to_string()
-        );
-
-        write_word(mirror_addr, value);
-        return;
-    }
-
-    if (region.write_handler) {
-        region.write_handler(addr, value);
+    if (region.handler != RegionHandler::None) {
+        handler_write(region, addr, value);
         return;
     }
 
@@ -283,103 +313,273 @@ void Mmu::copy(uint16_t dst_addr, std::span<uint8_t> src)
         return;
     }
 
-    if (region.mirrored) {
-        if (!region.mirror) {
-            throw std::runtime_error("Mirrored region missing mirror target");
-        }
-        const auto& mirror = map(*region.mirror);
-        uint16_t mirror_addr = mirror.start + (dst_addr - region.start);
+    for (size_t i = 0; i < src.size(); i++) {
+        write_byte(dst_addr + i, src[i]);
+    }
+}
 
-        log::debug(
-            "Copy to mirrored region at {} (mirrored to {})",
-            common::utils::PrettyHex(dst_addr).to_string(),
-            common::utils::PrettyHex(mirror_addr).to_string()
-        );
+inline uint8_t Mmu::read_high_pages(uint16_t addr, bool unlocked) const
+{
+    if (addr >= HRAMStart) {
+        return (addr == IEAddr) ? io_->interrupts().ie() : hram_[addr - HRAMStart];
+    }
+    if (addr >= IOStart) {
+        return io_read(addr);
+    }
+    if (!unlocked && lock_oam_) {
+        return OpenBusValue;
+    }
+    return (addr <= OAMEnd) ? oam_[addr - OAMStart] : 0x00;
+}
 
-        copy(mirror_addr, src);
+inline void Mmu::write_high_pages(uint16_t addr, uint8_t value, bool unlocked)
+{
+    if (addr >= HRAMStart) {
+        if (addr == IEAddr) {
+            io_->interrupts().set_ie(value);
+            return;
+        }
+        // No mirrors here, and HRAM is the only code these pages can hold
+        if (code_pages_[HRAMStart >> 8] && code_write_callback_) [[unlikely]] {
+            code_write_callback_(addr);
+        }
+        hram_[addr - HRAMStart] = value;
         return;
     }
+    if (addr >= IOStart) {
+        io_write(addr, value);
+        return;
+    }
+    if (!unlocked && lock_oam_) {
+        return;
+    }
+    if (addr > OAMEnd) {
+        log::warn(
+            "Attempted write to read-only memory at {}", common::utils::PrettyHex(addr).to_string()
+        );
+        return;
+    }
+    oam_[addr - OAMStart] = value;
+}
 
-    for (size_t i = 0; i < src.size(); i++) {
-        write_byte(dst_addr + i, src[i]);
+inline uint8_t Mmu::handler_read(const MemoryRegion& region, uint16_t addr) const
+{
+    // Cartridge and top page accesses are dispatched by read_region(), the handlers are only
+    // reached from the observed paths and read_word()
+    switch (region.handler) {
+        case RegionHandler::Rom:
+        case RegionHandler::Sram:
+            return cart_->mbc_read(addr);
+        case RegionHandler::Io:
+            return io_read(addr);
+        case RegionHandler::IEReg:
+            return io_->interrupts().ie();
+        case RegionHandler::NotUsable:
+            return 0x00;
+        case RegionHandler::Flat:
+            flat_callback_(addr, region.data[addr], false);
+            return region.data[addr];
+        case RegionHandler::Unloaded:
+        case RegionHandler::OpenBus:
+            return unmapped_read(region, addr);
+        default:
+            break;
     }
+
+    return region.data[addr - region.start];
 }
 
-void Mmu::start_dma(uint8_t value)
+inline void Mmu::handler_write(const MemoryRegion& region, uint16_t addr, uint8_t value)
 {
-    dma_.start(value);
+    switch (region.handler) {
+        case RegionHandler::Rom:
+            mbc_register_write(addr, value);
+            return;
+        case RegionHandler::Sram:
+            cart_->mbc_write(addr, value);
+            return;
+        case RegionHandler::Io:
+            io_write(addr, value);
+            return;
+        case RegionHandler::IEReg:
+            io_->interrupts().set_ie(value);
+            return;
+        case RegionHandler::NotUsable:
+            return;
+        case RegionHandler::Flat:
+            region.data[addr] = value;
+            flat_callback_(addr, value, true);
+            return;
+        case RegionHandler::Unloaded:
+        case RegionHandler::OpenBus:
+            unmapped_write(region, addr, value);
+            return;
+        case RegionHandler::None:
+            break;
+    }
+
+    region.data[addr - region.start] = value;
 }
 
-void Mmu::tick_dma(uint16_t cycles)
+void Mmu::mbc_register_write(uint16_t addr, uint8_t value)
 {
-    dma_.tick(cycles, *this);
+    // MBC register writes might switch the banks under fetch and table pages
+    cart_->mbc_write(addr, value);
+    map_generation_++;
+    map_pages(ROMBank0Start, ROMBank1End);
+    map_pages(SRAMStart, SRAMEnd);
 }
 
-void Mmu::Dma::start(uint8_t value)
+uint8_t Mmu::unmapped_read(const MemoryRegion& region, uint16_t addr)
 {
-    if (active) {
+    if (region.handler == RegionHandler::Unloaded) {
+        log::warn(
+            "Read from {} before ROM loaded at {}",
+            (region.id == MemoryRegionID::SRAM) ? "SRAM" : "ROM",
+            common::utils::PrettyHex(addr).to_string()
+        );
+        return OpenBusValue;
+    }
+
+#ifdef DEBUG
+    // In debug mode, throw for easier debugging
+    throw std::out_of_range(std::format(
+        "Read from unmapped memory at {}", common::utils::PrettyHex(addr).to_string()
+    ));
+#else
+    // In release mode, log a warning and return open bus value
+    log::warn("Read from unmapped memory at {}", common::utils::PrettyHex(addr).to_string());
+    return OpenBusValue;
+#endif
+}
+
+void Mmu::unmapped_write(const MemoryRegion& region, uint16_t addr, uint8_t value)
+{
+    if (region.handler == RegionHandler::Unloaded) {
+        log::warn(
+            "Write to {} before ROM loaded at {}: {}",
+            (region.id == MemoryRegionID::SRAM) ? "SRAM" : "ROM",
+            common::utils::PrettyHex(addr).to_string(),
+            common::utils::PrettyHex(value).to_string()
+        );
+        return;
+    }
+
+#ifdef DEBUG
+    // In debug mode, throw for easier debugging
+    throw std::out_of_range(std::format(
+        "Write to unmapped memory at {}: {}",
+        common::utils::PrettyHex(addr).to_string(),
+        common::utils::PrettyHex(value).to_string()
+    ));
+#else
+    // In release mode, log a warning
+    log::warn(
+        "Write to unmapped memory at {}: {}",
+        common::utils::PrettyHex(addr).to_string(),
+        common::utils::PrettyHex(value).to_string()
+    );
+#endif
+}
+
+void Mmu::start_dma(uint8_t value)
+{
+    if (dma_.active) {
         log::warn("DMA transfer already in progress, new request ignored");
         return;
     }
 
-    src = static_cast<uint16_t>(value) << 8; // value * 0x100
-    dst = OAMStart;
-    active = true;
-    bytes_remaining = DMATransferSize;
-    tick_counter = 0;
-    cks = 0;
+    dma_ = Dma{.active = true, .src = static_cast<uint16_t>(value << 8), .elapsed = 0, .copied = 0};
+    map_page_aliases(static_cast<uint8_t>(unmirror(dma_.src) >> 8)); // source writes sync first
 
-    log::trace("Starting DMA transfer from {}", common::utils::PrettyHex(src).to_string());
+    log::trace("Starting DMA transfer from {}", common::utils::PrettyHex(dma_.src).to_string());
 }
 
-void Mmu::Dma::tick(uint16_t cycles, Mmu& mmu)
+void Mmu::advance_dma(uint32_t cycles)
 {
-    if (!active) {
+    if (dma_.elapsed + cycles < DMATransferCycles) {
+        dma_.elapsed = static_cast<uint16_t>(dma_.elapsed + cycles);
         return;
     }
 
-    tick_counter += cycles;
+    copy_dma(DMATransferSize);
+    auto src_page = static_cast<uint8_t>(unmirror(dma_.src) >> 8);
+    dma_.reset();
+    map_page_aliases(src_page);
 
-    while (tick_counter >= 4 && bytes_remaining > 0) {
-        uint8_t data = mmu.read_byte(src);
+    log::trace("DMA transfer completed");
+}
 
-        // Use direct access to OAM to avoid blocking writes during DMA
-        mmu.oam_.at(dst - OAMStart) = data;
+void Mmu::copy_dma(uint16_t bytes) const
+{
+    uint16_t start = dma_.copied;
+    if (bytes <= start) {
+        return;
+    }
 
-        bytes_remaining--;
-        tick_counter -= 4;
-        src++;
-        dst++;
+    // Marked as copied first: a source page in OAM reads back through sync_dma()
+    dma_.copied = bytes;
 
-        cks = (cks + data) & 0xFFFF; // simple checksum
+    // The source page is aligned, plain memory is copied straight from its page
+    if (const auto* page = ppu_pages_.read[dma_.src >> 8]; page != nullptr) {
+        std::memcpy(oam_.data() + start, page + start, bytes - start);
+        return;
     }
 
-    if (bytes_remaining == 0) {
-        active = false;
-        log::trace(
-            "DMA transfer completed, checksum: {}", common::utils::PrettyHex(cks).to_string()
-        );
+    for (uint16_t i = start; i < bytes; ++i) {
+        oam_[i] = read_byte(dma_.src + i, true);
     }
 }
 
-void Mmu::Dma::reset()
+void Mmu::set_io_write_callback(IoWriteCallback callback, void* context)
+{
+    io_write_callback_ = callback;
+    io_write_context_ = context;
+}
+
+void Mmu::set_io_read_callback(IoReadCallback callback, void* context)
+{
+    io_read_callback_ = callback;
+    io_read_context_ = context;
+}
+
+void Mmu::set_code_write_callback(CodeWriteCallback callback)
+{
+    code_write_callback_ = std::move(callback);
+}
+
+void Mmu::watch_code_page(uint8_t page, bool watch)
+{
+    code_pages_.at(page) = watch;
+    map_page_aliases(page);
+}
+
+size_t Mmu::add_watchpoint(uint16_t start, uint16_t end, WatchKind kinds)
 {
-    active = false;
-    src = 0;
-    dst = OAMStart;
-    bytes_remaining = 0;
-    tick_counter = 0;
-    cks = 0;
+    auto id = watchpoints_.add(start, end, kinds);
+    update_watch_traps();
+    return id;
 }
 
-void Mmu::set_io_write_callback(IoWriteCallback callback)
+bool Mmu::remove_watchpoint(size_t id)
 {
-    io_write_callback_ = std::move(callback);
+    bool removed = watchpoints_.remove(id);
+    update_watch_traps();
+    return removed;
 }
 
-void Mmu::set_io_read_callback(IoReadCallback callback)
+void Mmu::clear_watchpoints()
 {
-    io_read_callback_ = std::move(callback);
+    watchpoints_.clear();
+    watchpoints_.clear_hit();
+    update_watch_traps();
+}
+
+void Mmu::update_watch_traps()
+{
+    // Fetch pages might be trapped or released too
+    map_generation_++;
+    map_pages(0x0000, MemoryMapSize - 1);
 }
 
 void Mmu::dump(uint16_t start_addr, uint16_t end_addr, const std::string& filename) const
@@ -398,52 +598,21 @@ void Mmu::dump(uint16_t start_addr, uint16_t end_addr, const std::string& filena
     }
 }
 
-// NOLINTEND(misc-no-recursion)
-
 void Mmu::init_memory_map()
 {
-    auto unloaded_rom_read = [](uint16_t addr) -> uint8_t {
-        log::warn(
-            "Read from ROM before ROM loaded at {}", common::utils::PrettyHex(addr).to_string()
-        );
-        return OpenBusValue;
-    };
-    auto unloaded_rom_write = [](uint16_t addr, uint8_t value) {
-        log::warn(
-            "Write to ROM before ROM loaded at {}: {}",
-            common::utils::PrettyHex(addr).to_string(),
-            common::utils::PrettyHex(value).to_string()
-        );
-    };
-    auto unloaded_sram_read = [](uint16_t addr) -> uint8_t {
-        log::warn(
-            "Read from SRAM before ROM loaded at {}", common::utils::PrettyHex(addr).to_string()
-        );
-        return OpenBusValue;
-    };
-    auto unloaded_sram_write = [](uint16_t addr, uint8_t value) {
-        log::warn(
-            "Write to SRAM before ROM loaded at {}: {}",
-            common::utils::PrettyHex(addr).to_string(),
-            common::utils::PrettyHex(value).to_string()
-        );
-    };
-
     map(MemoryRegionID::ROMBank0) = {
         .id = MemoryRegionID::ROMBank0,
         .start = ROMBank0Start,
         .end = ROMBank0End,
         .data = {},
-        .read_handler = unloaded_rom_read,
-        .write_handler = unloaded_rom_write,
+        .handler = RegionHandler::Unloaded,
     };
     map(MemoryRegionID::ROMBank1) = {
         .id = MemoryRegionID::ROMBank1,
         .start = ROMBank1Start,
         .end = ROMBank1End,
         .data = {},
-        .read_handler = unloaded_rom_read,
-        .write_handler = unloaded_rom_write,
+        .handler = RegionHandler::Unloaded,
     };
     map(MemoryRegionID::VRAM) = {
         .id = MemoryRegionID::VRAM,
@@ -456,8 +625,7 @@ void Mmu::init_memory_map()
         .start = SRAMStart,
         .end = SRAMEnd,
         .data = {},
-        .read_handler = unloaded_sram_read,
-        .write_handler = unloaded_sram_write,
+        .handler = RegionHandler::Unloaded,
     };
     map(MemoryRegionID::WRAM0) = {
         .id = MemoryRegionID::WRAM0,
@@ -475,8 +643,7 @@ void Mmu::init_memory_map()
         .id = MemoryRegionID::ECHO,
         .start = ECHOStart,
         .end = ECHOEnd,
-        .data = {},
-        .mirrored = true,
+        .data = std::span<uint8_t>(wram_).first(ECHOSize),
         .mirror = MemoryRegionID::WRAM0,
     };
     map(MemoryRegionID::OAM) = {
@@ -491,8 +658,7 @@ void Mmu::init_memory_map()
         .end = NotUsableEnd,
         .data = {},
         .read_only = true,
-        .read_handler = [](uint16_t) { return uint8_t{0x00}; },
-        .write_handler = [](uint16_t, uint8_t) {},
+        .handler = RegionHandler::NotUsable,
     };
     map(MemoryRegionID::IO) = {
         .id = MemoryRegionID::IO,
@@ -500,8 +666,7 @@ void Mmu::init_memory_map()
         .end = IOEnd,
         .data = {},
         .io_register = true,
-        .read_handler = [&](uint16_t addr) -> uint8_t { return io_read(addr); },
-        .write_handler = [&](uint16_t addr, uint8_t value) { io_write(addr, value); },
+        .handler = RegionHandler::Io,
     };
     map(MemoryRegionID::HRAM) = {
         .id = MemoryRegionID::HRAM,
@@ -513,9 +678,14 @@ void Mmu::init_memory_map()
         .id = MemoryRegionID::IEReg,
         .start = IEAddr,
         .end = IEAddr,
-        .data = {&ier_, 1},
+        .data = {},
+        .handler = RegionHandler::IEReg,
     };
 
+    map(MemoryRegionID::Flat) = {};
+    flat_callback_ = nullptr;
+    high_pages_direct_ = true;
+
     // Fallback for unmapped addresses (open bus)
     map(MemoryRegionID::OpenBus) = {
         .id = MemoryRegionID::OpenBus,
@@ -523,45 +693,79 @@ void Mmu::init_memory_map()
         .end = 0x0000,
         .data = {},
         .read_only = false,
-        .mirrored = false,
         .io_register = false,
-        .read_handler = [&](uint16_t addr) -> uint8_t {
-#ifdef DEBUG
-            // In debug mode, throw for easier debugging
-            throw std::out_of_range(std::format(
-                "Read from unmapped memory at {}", common::utils::PrettyHex(addr).to_string()
-            ));
-#else
-            // In release mode, log a warning and return open bus value
-            log::warn(
-                "Read from unmapped memory at {}", common::utils::PrettyHex(addr).to_string()
-            );
-            return OpenBusValue;
-#endif
-        },
-        .write_handler =
-            [&](uint16_t addr, uint8_t value) {
-#ifdef DEBUG
-                // In debug mode, throw for easier debugging
-                throw std::out_of_range(std::format(
-                    "Write to unmapped memory at {}: {}",
-                    common::utils::PrettyHex(addr).to_string(),
-                    common::utils::PrettyHex(value).to_string()
-                ));
-#else
-                // In release mode, log a warning
-                log::warn(
-                    "Write to unmapped memory at {}: {}",
-                    common::utils::PrettyHex(addr).to_string(),
-                    common::utils::PrettyHex(value).to_string()
-                );
-#endif
-            },
+        .handler = RegionHandler::OpenBus,
     };
 
     init_region_lut();
 }
 
+void Mmu::map_page(uint8_t page)
+{
+    auto addr = static_cast<uint16_t>(page << 8);
+    const auto& region = region_lookup(addr);
+    const uint8_t* read = nullptr;
+    uint8_t* write = nullptr;
+
+    // Pages shared by several regions (OAM/not usable, I/O/HRAM/IE) always use the regions
+    if (region.start <= addr && region.end >= addr + 0xFF) {
+        switch (region.id) {
+            case MemoryRegionID::ROMBank0:
+            case MemoryRegionID::ROMBank1:
+                // Writes are MBC register writes
+                read = (cart_ != nullptr) ? cart_->get_mbc().rom_page(addr) : nullptr;
+                break;
+            case MemoryRegionID::SRAM:
+                // Writes flag the battery-backed RAM for saving
+                read = (cart_ != nullptr) ? cart_->get_mbc().ram_page(addr) : nullptr;
+                break;
+            default:
+                if (region.handler == RegionHandler::None && !region.data.empty()) {
+                    read = region.data.data() + (addr - region.start);
+                }
+                if (read != nullptr && !region.read_only) {
+                    write = region.data.data() + (addr - region.start);
+                }
+                break;
+        }
+    }
+
+    bool locked = is_region_locked(region.id);
+    auto target_page = static_cast<uint8_t>(unmirror(addr) >> 8); // mirrors share the traps
+    bool watched = code_pages_[target_page];
+    bool read_trapped = has_flag(watchpoints_.page_kinds(target_page), WatchKind::Read);
+    bool write_trapped = has_flag(watchpoints_.page_kinds(target_page), WatchKind::Write);
+    bool dma_source = dma_.active && is_dma_source(addr);
+    ppu_pages_.read[page] = read;
+    ppu_pages_.write[page] = (watched || dma_source) ? nullptr : write;
+    cpu_pages_.read[page] = (locked || read_trapped) ? nullptr : read;
+    cpu_pages_.write[page] = (locked || watched || write_trapped || dma_source) ? nullptr : write;
+}
+
+void Mmu::map_page_aliases(uint8_t page)
+{
+    map_page(page);
+
+    // Mirrors of the page access it too
+    auto addr = static_cast<uint16_t>(page << 8);
+    for (const auto& region : memory_map_) {
+        if (!region.mirror || region_lookup(region.start).id != region.id) {
+            continue;
+        }
+        const auto& target = map(*region.mirror);
+        if (addr >= target.start && static_cast<size_t>(addr - target.start) < region.size()) {
+            map_page(static_cast<uint8_t>((region.start + (addr - target.start)) >> 8));
+        }
+    }
+}
+
+void Mmu::map_pages(uint16_t start_addr, uint16_t end_addr)
+{
+    for (unsigned page = start_addr >> 8; page <= (end_addr >> 8); ++page) {
+        map_page(static_cast<uint8_t>(page));
+    }
+}
+
 void Mmu::init_region_lut()
 {
     // Initialize all entries to point to OpenBus region
@@ -582,7 +786,7 @@ inline void Mmu::io_write(uint16_t addr, uint8_t value)
 {
     io_->write(addr, value);
     if (io_write_callback_) {
-        io_write_callback_(addr, value);
+        io_write_callback_(io_write_context_, addr, value);
     }
 }
 
@@ -590,7 +794,7 @@ inline void Mmu::io_write(uint16_t addr, uint8_t value)
 {
     uint8_t value = io_->read(addr);
     if (io_read_callback_) {
-        io_read_callback_(addr, value);
+        io_read_callback_(io_read_context_, addr, value);
     }
     return value;
 }
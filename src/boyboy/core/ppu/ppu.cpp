@@ -148,6 +148,31 @@ void Ppu::tick(uint16_t cycles)
     }
 }
 
+uint32_t Ppu::cycles_to_event() const
+{
+    if (!is_lcd_on()) {
+        return NoEvent;
+    }
+
+    // STAT, LYC and VBlank interrupts can only happen on mode transitions
+    int mode_cycles = 0;
+    switch (mode_) {
+        case Mode::OAMScan:
+            mode_cycles = Cycles::OAMScan;
+            break;
+        case Mode::Transfer:
+            mode_cycles = Cycles::Transfer;
+            break;
+        case Mode::HBlank:
+            mode_cycles = Cycles::HBlank;
+            break;
+        case Mode::VBlank:
+            mode_cycles = Cycles::VBlank;
+            break;
+    }
+    return static_cast<uint32_t>(std::max(mode_cycles - cycles_in_mode_, 0));
+}
+
 uint8_t Ppu::read(uint16_t addr) const
 {
     return registers_.at(IoReg::Ppu::local_addr(addr));
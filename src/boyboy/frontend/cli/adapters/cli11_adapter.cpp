@@ -16,6 +16,7 @@
 #include "boyboy/app/commands/config_command.h"
 #include "boyboy/app/commands/info_command.h"
 #include "boyboy/app/commands/run_command.h"
+#include "boyboy/app/commands/trace_command.h"
 #include "boyboy/common/config/config_limits.h"
 #include "boyboy/common/log/logging.h"
 #include "boyboy/version.h"
@@ -25,6 +26,7 @@ namespace boyboy::frontend::cli {
 inline static constexpr std::string_view RunCommandName = "run";
 inline static constexpr std::string_view InfoCommandName = "info";
 inline static constexpr std::string_view ConfigCommandName = "config";
+inline static constexpr std::string_view TraceCommandName = "trace";
 
 inline static const std::string GlobalFooter = std::format(
     "For more information and bug reports, visit <https://github.com/sebdevnull/boyboy>\n\n{}",
@@ -73,6 +75,9 @@ void CLI11Adapter::register_command(app::commands::ICommand& command)
     else if (command.name() == ConfigCommandName) {
         register_config(dynamic_cast<app::commands::ConfigCommand&>(command));
     }
+    else if (command.name() == TraceCommandName) {
+        register_trace(dynamic_cast<app::commands::TraceCommand&>(command));
+    }
     else {
         throw std::runtime_error(
             std::string("Unsupported command: ") + std::string(command.name())
@@ -272,4 +277,33 @@ void CLI11Adapter::register_config(app::commands::ConfigCommand& command)
     )"));
 }
 
-} // namespace boyboy::frontend::cli
\ No newline at end of file
+void CLI11Adapter::register_trace(app::commands::TraceCommand& command)
+{
+    auto* cmd = app_parser_.add_subcommand(
+        std::string(command.name()), std::string(command.description())
+    );
+    cmd->footer(make_footer(R"(
+        Examples:
+          boyboy trace path/to/trace.bbt
+          boyboy trace path/to/trace.bbt --disassemble > trace.log
+
+        Notes:
+          Trace files are written when running with debug.trace enabled, on exit, on crash or
+          when receiving SIGUSR1. Output lines follow the Gameboy Doctor log format.
+    )"));
+
+    cmd->add_option("<trace>", options_.trace_path, "Path to the trace file")
+        ->type_name("")
+        ->required();
+    cmd->add_flag(
+        "-d,--disassemble", options_.trace_disassemble, "Append the instruction mnemonic to lines"
+    );
+
+    cmd->callback([this, &command]() {
+        command.set_trace_path(options_.trace_path);
+        command.set_disassemble(options_.trace_disassemble);
+        command.execute(*app_, context_);
+    });
+}
+
+} // namespace boyboy::frontend::cli
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <array>
 #include <string>
 
 namespace boyboy::test::common {
@@ -36,4 +37,19 @@ const std::string CpuTest09Rom   = BlarggCpuRoms + "individual/09-op r,r.gb";
 const std::string CpuTest10Rom   = BlarggCpuRoms + "individual/10-bit ops.gb";
 const std::string CpuTest11Rom   = BlarggCpuRoms + "individual/11-op a,(hl).gb";
 
+// Individual CPU test ROMs, for parameterized suites
+const std::array<std::string, 11> CpuTestRoms = {
+    CpuTest01Rom,
+    CpuTest02Rom,
+    CpuTest03Rom,
+    CpuTest04Rom,
+    CpuTest05Rom,
+    CpuTest06Rom,
+    CpuTest07Rom,
+    CpuTest08Rom,
+    CpuTest09Rom,
+    CpuTest10Rom,
+    CpuTest11Rom,
+};
+
 } // namespace boyboy::test::common
\ No newline at end of file
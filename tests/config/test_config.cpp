@@ -93,11 +93,16 @@ TEST_F(ConfigTest, LoadAndSaveConfig)
 {
     namespace fs = std::filesystem;
 
-    auto& original_config           = config;
-    original_config.emulator.speed  = 2;
-    original_config.video.scale     = 3;
-    original_config.video.vsync     = false;
-    original_config.debug.log_level = "debug";
+    auto& original_config                      = config;
+    original_config.emulator.speed             = 2;
+    original_config.emulator.superinstructions = true;
+    original_config.emulator.microcode         = true;
+    original_config.video.scale                = 3;
+    original_config.video.vsync                = false;
+    original_config.debug.log_level            = "debug";
+    original_config.debug.instrumentation      = true;
+    original_config.debug.trace                = true;
+    original_config.debug.coverage             = true;
 
     // Save to a temporary file
     fs::path temp_path("temp_config.toml");
@@ -108,9 +113,14 @@ TEST_F(ConfigTest, LoadAndSaveConfig)
 
     // Verify loaded config matches original
     EXPECT_EQ(loaded_config.emulator.speed, original_config.emulator.speed);
+    EXPECT_EQ(loaded_config.emulator.superinstructions, original_config.emulator.superinstructions);
+    EXPECT_EQ(loaded_config.emulator.microcode, original_config.emulator.microcode);
     EXPECT_EQ(loaded_config.video.scale, original_config.video.scale);
     EXPECT_EQ(loaded_config.video.vsync, original_config.video.vsync);
     EXPECT_EQ(loaded_config.debug.log_level, original_config.debug.log_level);
+    EXPECT_EQ(loaded_config.debug.instrumentation, original_config.debug.instrumentation);
+    EXPECT_EQ(loaded_config.debug.trace, original_config.debug.trace);
+    EXPECT_EQ(loaded_config.debug.coverage, original_config.debug.coverage);
 
     // Clean up temporary file
     fs::remove(temp_path);
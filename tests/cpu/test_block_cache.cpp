@@ -0,0 +1,364 @@
+/**
+ * @file test_block_cache.cpp
+ * @brief Tests for the CPU predecoded block cache.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// helpers
+#include "common/roms.h"
+#include "helpers/cpu_fixtures.h"
+#include "helpers/rom_fixtures.h"
+
+// boyboy
+#include "boyboy/core/cartridge/cartridge.h"
+#include "boyboy/core/cartridge/cartridge_loader.h"
+#include "boyboy/core/cpu/block_cache.h"
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/cycles.h"
+#include "boyboy/core/cpu/opcodes.h"
+#include "boyboy/core/cpu/registers.h"
+#include "boyboy/core/io/io.h"
+#include "boyboy/core/io/registers.h"
+#include "boyboy/core/io/timer.h"
+#include "boyboy/core/mmu/constants.h"
+
+using boyboy::test::cpu::CpuTest;
+using boyboy::test::rom::ConfigROMTest;
+
+using namespace boyboy::core::cpu;
+using namespace boyboy::test::common;
+
+class BlockCacheTest : public CpuTest {
+protected:
+    void SetUp() override
+    {
+        CpuTest::SetUp();
+        cpu->set_tick_mode(TickMode::Instruction);
+        cpu->enable_block_cache(true);
+    }
+
+    void tick(int ticks = 1) const
+    {
+        while (ticks-- > 0) {
+            cpu->tick();
+        }
+    }
+
+    [[nodiscard]] const BlockCache::Stats& stats() const
+    {
+        return cpu->get_block_cache().stats();
+    }
+};
+
+// Exposes the fake ROM builder to build banked cartridges
+struct FakeRom : public boyboy::test::rom::FakeROMTest {
+    using FakeROMTest::make_fake_rom;
+};
+
+TEST_F(BlockCacheTest, Disabled)
+{
+    cpu->enable_block_cache(false);
+
+    set_next_bytes({std::to_underlying(Opcode::INC_A), std::to_underlying(Opcode::INC_A)});
+    cpu->set_register(Reg8Name::A, 0x00);
+    tick(2);
+
+    EXPECT_EQ(cpu->get_register(Reg8Name::A), 0x02);
+    EXPECT_EQ(cpu->get_block_cache().size(), 0);
+    EXPECT_EQ(stats().misses, 0);
+}
+
+TEST_F(BlockCacheTest, LoopHitsCache)
+{
+    // LD B, 10; loop: INC A; DEC B; JR NZ, loop; NOP
+    set_next_bytes({
+        std::to_underlying(Opcode::LD_B_N8),
+        0x0A,
+        std::to_underlying(Opcode::INC_A),
+        std::to_underlying(Opcode::DEC_B),
+        std::to_underlying(Opcode::JR_NZ_E8),
+        0xFC,
+        std::to_underlying(Opcode::NOP),
+    });
+    cpu->set_register(Reg8Name::A, 0x00);
+
+    tick(1 + (10 * 3));
+
+    EXPECT_EQ(cpu->get_register(Reg8Name::A), 0x0A);
+    EXPECT_EQ(cpu->get_register(Reg8Name::B), 0x00);
+    EXPECT_EQ(cpu->get_pc(), boyboy::core::mmu::WRAM0Start + 6);
+
+    // Same cycles as the interpreter: 10 INC/DEC pairs, 9 JR taken and 1 not taken
+    EXPECT_EQ(cpu->get_cycles(), 8 + (10 * 8) + (9 * 12) + 8);
+
+    // Blocks at the program start and at the loop start, the rest are hits
+    EXPECT_EQ(stats().misses, 2);
+    EXPECT_EQ(stats().hits, 8);
+    EXPECT_EQ(stats().invalidations, 0);
+}
+
+TEST_F(BlockCacheTest, WriteInvalidatesRamBlock)
+{
+    // LD A, 0x11; JR -4
+    set_next_bytes({
+        std::to_underlying(Opcode::LD_A_N8),
+        0x11,
+        std::to_underlying(Opcode::JR_E8),
+        0xFC,
+    });
+
+    tick(2);
+    EXPECT_EQ(cpu->get_register(Reg8Name::A), 0x11);
+    EXPECT_EQ(cpu->get_pc(), boyboy::core::mmu::WRAM0Start);
+
+    // Writes outside the code pages don't invalidate anything
+    mmu->write_byte(boyboy::core::mmu::WRAM1Start, 0x00);
+    EXPECT_EQ(stats().invalidations, 0);
+
+    // Patch the LD operand
+    mmu->write_byte(boyboy::core::mmu::WRAM0Start + 1, 0x22);
+    EXPECT_EQ(stats().invalidations, 1);
+    EXPECT_EQ(cpu->get_block_cache().size(), 0);
+
+    tick(1);
+    EXPECT_EQ(cpu->get_register(Reg8Name::A), 0x22);
+    EXPECT_EQ(stats().misses, 2);
+}
+
+TEST_F(BlockCacheTest, KeyedOnRomBank)
+{
+    using boyboy::core::cartridge::CartridgeType;
+
+    // Every byte of a fake ROM bank is its bank index:
+    // bank 1 -> LD BC, 0x0101 ; bank 2 -> LD [BC], A
+    auto cart = boyboy::core::cartridge::CartridgeLoader::load(
+        FakeRom::make_fake_rom(CartridgeType::MBC1, 4, 0)
+    );
+    mmu->map_rom(*cart);
+    cpu->set_register(Reg16Name::BC, 0x0000);
+
+    cpu->set_pc(boyboy::core::mmu::ROMBank1Start);
+    tick(1);
+    EXPECT_EQ(cpu->get_register(Reg16Name::BC), 0x0101);
+    EXPECT_EQ(cpu->get_pc(), boyboy::core::mmu::ROMBank1Start + 3);
+
+    // Switch to bank 2, same PC must decode a new block
+    mmu->write_byte(0x2000, 0x02);
+    cpu->set_pc(boyboy::core::mmu::ROMBank1Start);
+    tick(1);
+    EXPECT_EQ(cpu->get_register(Reg16Name::BC), 0x0101);
+    EXPECT_EQ(cpu->get_pc(), boyboy::core::mmu::ROMBank1Start + 1);
+
+    EXPECT_EQ(stats().misses, 2);
+    EXPECT_EQ(stats().invalidations, 0);
+}
+
+TEST_F(BlockCacheTest, BatchStopsBeforeIoAccess)
+{
+    cpu->enable_block_batching(true);
+    EXPECT_TRUE(cpu->is_block_cache_enabled());
+
+    // INC A; INC A; INC A; LDH [0x80], A; LDH [0x40], A; INC A; HALT
+    set_next_bytes({
+        std::to_underlying(Opcode::INC_A),
+        std::to_underlying(Opcode::INC_A),
+        std::to_underlying(Opcode::INC_A),
+        std::to_underlying(Opcode::LDH_AT_A8_A),
+        0x80,
+        std::to_underlying(Opcode::LDH_AT_A8_A),
+        0x40,
+        std::to_underlying(Opcode::INC_A),
+        std::to_underlying(Opcode::HALT),
+    });
+    cpu->set_register(Reg8Name::A, 0x00);
+
+    // The HRAM store is batched, the LCDC store is not
+    tick(1);
+    EXPECT_EQ(cpu->get_register(Reg8Name::A), 0x03);
+    EXPECT_EQ(cpu->get_pc(), boyboy::core::mmu::WRAM0Start + 5);
+    EXPECT_EQ(cpu->get_cycles(), (3 * 4) + 12);
+    EXPECT_EQ(stats().batched, 3);
+    EXPECT_EQ(mmu->read_byte(0xFF80), 0x03);
+
+    // The IO store starts a new batch on its own tick
+    tick(1);
+    EXPECT_EQ(cpu->get_register(Reg8Name::A), 0x04);
+    EXPECT_EQ(stats().batched, 4);
+}
+
+TEST_F(BlockCacheTest, BatchStopsAtNextEvent)
+{
+    using boyboy::core::io::IoReg;
+    using boyboy::core::io::Timer;
+
+    cpu->enable_block_batching(true);
+    auto timer = std::make_shared<Timer>();
+    io->register_component(timer);
+    timer->init();
+
+    // NOPs with TIMA about to overflow on the fastest timer clock (16 T-cycles)
+    std::vector<uint8_t> program(32, std::to_underlying(Opcode::NOP));
+    program.push_back(std::to_underlying(Opcode::HALT));
+    set_next_bytes(program);
+    io->write(IoReg::Timer::TIMA, 0xFF);
+    io->write(IoReg::Timer::TAC, 0x05);
+
+    // The batch ends on the NOP reaching the overflow, so the interrupt isn't requested late
+    auto event = io->cycles_to_event();
+    ASSERT_LT(event, MaxBatchCycles);
+    tick(1);
+    EXPECT_EQ(cpu->get_cycles(), std::max<TCycle>(4, (event + 3) / 4 * 4));
+}
+
+TEST_F(BlockCacheTest, FusedLoop)
+{
+    cpu->enable_fusion(true);
+    EXPECT_TRUE(cpu->is_block_cache_enabled());
+
+    // LD H, 10; loop: DEC H; JR NZ, loop; NOP
+    set_next_bytes({
+        std::to_underlying(Opcode::LD_H_N8),
+        0x0A,
+        std::to_underlying(Opcode::DEC_H),
+        std::to_underlying(Opcode::JR_NZ_E8),
+        0xFD,
+        std::to_underlying(Opcode::NOP),
+    });
+
+    // DEC H and JR NZ run as a single instruction
+    tick(1 + 10);
+
+    EXPECT_EQ(cpu->get_register(Reg8Name::H), 0x00);
+    EXPECT_EQ(cpu->get_pc(), boyboy::core::mmu::WRAM0Start + 5);
+    EXPECT_EQ(stats().fused, 10);
+
+    // Same cycles as the interpreter: 9 JR taken and 1 not taken
+    EXPECT_EQ(cpu->get_cycles(), 8 + (9 * (4 + 12)) + (4 + 8));
+}
+
+TEST_F(BlockCacheTest, FusedCopyLoop)
+{
+    using boyboy::core::cartridge::CartridgeType;
+    using boyboy::core::mmu::WRAM0Start;
+
+    // loop: LD A, [HL+]; LD [DE], A; INC E; JR NZ, loop, in ROM so the sequence may write memory
+    constexpr uint16_t Loop = 0x0200;
+    constexpr std::array<uint8_t, 5> Program = {
+        std::to_underlying(Opcode::LD_A_AT_HL_INC),
+        std::to_underlying(Opcode::LD_AT_DE_A),
+        std::to_underlying(Opcode::INC_E),
+        std::to_underlying(Opcode::JR_NZ_E8),
+        0xFB,
+    };
+    auto rom = FakeRom::make_fake_rom(CartridgeType::MBC1, 2, 0);
+    std::ranges::transform(Program, rom.begin() + Loop, [](uint8_t b) { return std::byte{b}; });
+    auto cart = boyboy::core::cartridge::CartridgeLoader::load(rom);
+    mmu->map_rom(*cart);
+    cpu->enable_fusion(true);
+
+    // Copy 16 bytes from WRAM0Start to WRAM0Start + 0x1F0, up to E wrapping around
+    for (uint8_t i = 0; i < 16; ++i) {
+        mmu->write_byte(WRAM0Start + i, i + 1);
+    }
+    cpu->set_register(Reg16Name::HL, WRAM0Start);
+    cpu->set_register(Reg16Name::DE, WRAM0Start + 0x1F0);
+    cpu->set_pc(Loop);
+
+    // The loads through HL and DE and INC E run as a single instruction, JR NZ on its own
+    tick(16 * 2);
+
+    for (uint8_t i = 0; i < 16; ++i) {
+        EXPECT_EQ(mmu->read_byte(WRAM0Start + 0x1F0 + i), i + 1);
+    }
+    EXPECT_EQ(cpu->get_pc(), Loop + Program.size());
+    EXPECT_EQ(stats().fused, 16 * 2);
+    EXPECT_EQ(cpu->get_cycles(), (16 * (8 + 8 + 4)) + (15 * 12) + 8);
+
+    // A pair pointing out of plain memory falls back to the micro-ops
+    cpu->set_register(Reg16Name::DE, 0xFEA0);
+    cpu->set_pc(Loop);
+    tick(1);
+    EXPECT_EQ(cpu->get_pc(), Loop + 1);
+    EXPECT_EQ(stats().fused, 16 * 2);
+}
+
+TEST_F(BlockCacheTest, SequenceProfile)
+{
+    // LD B, 10; loop: DEC B; JR NZ, loop; NOP
+    set_next_bytes({
+        std::to_underlying(Opcode::LD_B_N8),
+        0x0A,
+        std::to_underlying(Opcode::DEC_B),
+        std::to_underlying(Opcode::JR_NZ_E8),
+        0xFD,
+        std::to_underlying(Opcode::NOP),
+    });
+    tick(1 + (10 * 2));
+
+    auto profile = cpu->get_block_cache().profile();
+    EXPECT_EQ(profile.count({0x06, 0x05, NoFusedOpcode}), 1);
+    EXPECT_EQ(profile.count({0x06, 0x05, 0x20}), 1);
+    EXPECT_EQ(profile.count({0x05, 0x20, NoFusedOpcode}), 10);
+    EXPECT_EQ(profile.count({0x20, 0x00, NoFusedOpcode}), 0);
+
+    // Dropped blocks are still profiled
+    cpu->get_block_cache().clear();
+    EXPECT_EQ(cpu->get_block_cache().profile().count({0x05, 0x20, NoFusedOpcode}), 10);
+}
+
+struct BlockCacheConfig {
+    std::string name;
+    bool batching;
+    bool fusion;
+
+    // For pretty printing in test names
+    friend std::ostream& operator<<(std::ostream& os, const BlockCacheConfig& c)
+    {
+        os << c.name << " [Batching=" << c.batching << ", Fusion=" << c.fusion << "]";
+        return os;
+    }
+};
+
+class BlockCacheROMTest : public ConfigROMTest<BlockCacheConfig> {
+protected:
+    void SetUp() override
+    {
+        ROMTest::SetUp();
+        cpu->set_tick_mode(TickMode::Instruction);
+        cpu->enable_block_cache(true);
+        cpu->enable_block_batching(config().batching);
+        cpu->enable_fusion(config().fusion);
+    }
+};
+
+TEST_P(BlockCacheROMTest, Passes)
+{
+    load(rom());
+    run();
+}
+
+const std::array<BlockCacheConfig, 3> BlockCacheConfigs = {{
+    {.name = "Cache", .batching = false, .fusion = false},
+    {.name = "Batching", .batching = true, .fusion = false},
+    {.name = "Fusion", .batching = true, .fusion = true},
+}};
+
+INSTANTIATE_TEST_SUITE_P(
+    BlockCache,
+    BlockCacheROMTest,
+    ::testing::Combine(::testing::ValuesIn(BlockCacheConfigs), ::testing::ValuesIn(CpuTestRoms)),
+    BlockCacheROMTest::param_name
+);
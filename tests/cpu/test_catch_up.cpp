@@ -0,0 +1,127 @@
+/**
+ * @file test_catch_up.cpp
+ * @brief Tests for the CPU catch-up tick mode access timing.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// helpers
+#include "helpers/cpu_fixtures.h"
+
+// boyboy
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/cycles.h"
+#include "boyboy/core/cpu/opcodes.h"
+#include "boyboy/core/cpu/registers.h"
+#include "boyboy/core/mmu/constants.h"
+
+using boyboy::test::cpu::CpuTest;
+
+using namespace boyboy::core::cpu;
+
+class CatchUpTest : public CpuTest {
+protected:
+    static constexpr uint16_t Plain = boyboy::core::mmu::WRAM0Start + 0x100;
+    static constexpr uint16_t Vram = boyboy::core::mmu::VRAMStart;
+
+    std::vector<TCycle> syncs; // T-cycles of every sync callback call
+
+    void SetUp() override
+    {
+        CpuTest::SetUp();
+        cpu->set_tick_mode(TickMode::CatchUp);
+        cpu->set_sync_callback([this](TCycle cycles) { syncs.push_back(cycles); });
+    }
+};
+
+TEST_F(CatchUpTest, PlainAccessIsNotSynced)
+{
+    cpu->set_register(Reg16Name::HL, Plain);
+    set_next_bytes({std::to_underlying(Opcode::LD_A_AT_HL)});
+
+    EXPECT_EQ(cpu->tick(), 8);
+    EXPECT_TRUE(syncs.empty());
+}
+
+TEST_F(CatchUpTest, IoReadIsSyncedAtItsMCycle)
+{
+    // Opcode and operand fetches, then the read on the 3rd M-cycle
+    set_next_bytes({std::to_underlying(Opcode::LDH_A_AT_A8), 0x44});
+
+    auto cycles = cpu->get_cycles();
+    EXPECT_EQ(cpu->tick(), 0);
+    EXPECT_EQ(syncs, std::vector<TCycle>{12});
+    EXPECT_EQ(cpu->get_cycles(), cycles + 12);
+}
+
+TEST_F(CatchUpTest, IoWriteIsSyncedAtItsMCycle)
+{
+    set_next_bytes({std::to_underlying(Opcode::LD_AT_A16_A), 0x01, 0xFF});
+
+    EXPECT_EQ(cpu->tick(), 0);
+    EXPECT_EQ(syncs, std::vector<TCycle>{16});
+}
+
+TEST_F(CatchUpTest, ReadModifyWriteSyncsEveryAccess)
+{
+    mmu->write_byte(Vram, 0x41);
+    cpu->set_register(Reg16Name::HL, Vram);
+    set_next_bytes({std::to_underlying(Opcode::INC_AT_HL)});
+
+    EXPECT_EQ(cpu->tick(), 0);
+    EXPECT_EQ(syncs, (std::vector<TCycle>{8, 4}));
+    EXPECT_EQ(mmu->read_byte(Vram), 0x42);
+}
+
+TEST_F(CatchUpTest, RemainingCyclesAreReturned)
+{
+    // The read is synced, the following NOP is left to the caller
+    set_next_bytes(
+        {std::to_underlying(Opcode::LDH_A_AT_A8), 0x44, std::to_underlying(Opcode::NOP)}
+    );
+
+    EXPECT_EQ(cpu->tick(), 0);
+    EXPECT_EQ(cpu->tick(), 4);
+    EXPECT_EQ(syncs, std::vector<TCycle>{12});
+}
+
+TEST_F(CatchUpTest, BlockCacheAccessesAreTimed)
+{
+    // Predecoded operands advance PC like regular fetches
+    cpu->enable_block_cache(true);
+    cpu->enable_fusion(true);
+    set_next_bytes(
+        {std::to_underlying(Opcode::LDH_A_AT_A8),
+         0x44,
+         std::to_underlying(Opcode::LD_AT_A16_A),
+         0x01,
+         0xFF}
+    );
+
+    EXPECT_EQ(cpu->tick(), 0);
+    EXPECT_EQ(cpu->tick(), 0);
+    EXPECT_EQ(syncs, (std::vector<TCycle>{12, 16}));
+}
+
+TEST_F(CatchUpTest, NoCallbackReturnsWholeInstruction)
+{
+    cpu->set_sync_callback(nullptr);
+    set_next_bytes({std::to_underlying(Opcode::LDH_A_AT_A8), 0x44});
+
+    EXPECT_EQ(cpu->tick(), 12);
+}
+
+TEST_F(CatchUpTest, OtherModesAreNotTimed)
+{
+    cpu->set_tick_mode(TickMode::Instruction);
+    set_next_bytes({std::to_underlying(Opcode::LDH_A_AT_A8), 0x44});
+
+    EXPECT_EQ(cpu->tick(), 12);
+    EXPECT_TRUE(syncs.empty());
+}
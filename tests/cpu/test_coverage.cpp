@@ -0,0 +1,164 @@
+/**
+ * @file test_coverage.cpp
+ * @brief Tests for the CPU code coverage bitmaps.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <utility>
+
+// helpers
+#include "helpers/cpu_fixtures.h"
+
+// boyboy
+#include "boyboy/common/files/io.h"
+#include "boyboy/core/cpu/coverage.h"
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/opcodes.h"
+#include "boyboy/core/mmu/constants.h"
+
+using boyboy::test::cpu::CpuTest;
+
+using namespace boyboy::core::cpu;
+
+class CoverageTest : public ::testing::Test {
+protected:
+    inline static const std::filesystem::path CoverageFile =
+        std::filesystem::temp_directory_path() / "boyboy_test_coverage.bbc";
+
+    void TearDown() override { std::filesystem::remove(CoverageFile); }
+};
+
+TEST_F(CoverageTest, RomBanks)
+{
+    CoverageMap coverage;
+    coverage.set_rom_banks(2);
+
+    coverage.record(0x0150, 1);
+    coverage.record(0x4000, 1);
+    EXPECT_TRUE(coverage.is_covered(0x0150, 0));
+    EXPECT_TRUE(coverage.is_covered(0x4000, 1));
+    EXPECT_FALSE(coverage.is_covered(0x0151, 0));
+
+    // Same address in another bank, past the cartridge banks
+    EXPECT_FALSE(coverage.is_covered(0x4000, 3));
+    coverage.record(0x4000, 3);
+    EXPECT_TRUE(coverage.is_covered(0x4000, 3));
+    EXPECT_FALSE(coverage.is_covered(0x4000, 2));
+    EXPECT_EQ(coverage.rom_banks(), 4);
+
+    EXPECT_EQ(coverage.covered_bytes(0), 1);
+    EXPECT_EQ(coverage.covered_bytes(1), 1);
+    EXPECT_EQ(coverage.covered_bytes(2), 0);
+    EXPECT_EQ(coverage.covered_bytes(3), 1);
+}
+
+TEST_F(CoverageTest, RamRegions)
+{
+    using namespace boyboy::core::mmu;
+
+    CoverageMap coverage;
+    coverage.record(WRAMEnd, 1);
+    coverage.record(HRAMStart, 1);
+    coverage.record(VRAMStart, 1);
+
+    EXPECT_TRUE(coverage.is_covered(WRAMEnd, 0));
+    EXPECT_TRUE(coverage.is_covered(HRAMStart, 0));
+    EXPECT_FALSE(coverage.is_covered(VRAMStart, 0)) << "Only ROM, WRAM and HRAM are recorded";
+    EXPECT_EQ(coverage.rom_banks(), 0);
+
+    coverage.clear();
+    EXPECT_FALSE(coverage.is_covered(WRAMEnd, 0));
+}
+
+TEST_F(CoverageTest, Summary)
+{
+    CoverageMap coverage;
+    coverage.set_rom_banks(2);
+    for (uint16_t addr = 0x4000; addr < 0x5000; ++addr) {
+        coverage.record(addr, 1);
+    }
+
+    auto summary = coverage.summary();
+    EXPECT_NE(summary.find("ROM bank 000:      0/16384 bytes (  0.00%)"), std::string::npos);
+    EXPECT_NE(summary.find("ROM bank 001:   4096/16384 bytes ( 25.00%)"), std::string::npos);
+    EXPECT_NE(summary.find("ROM total   :   4096/32768 bytes ( 12.50%)"), std::string::npos);
+}
+
+TEST_F(CoverageTest, Flush)
+{
+    CoverageMap coverage;
+    coverage.set_rom_banks(2);
+    coverage.record(0x4001, 1);
+    coverage.record(boyboy::core::mmu::WRAMStart, 1);
+
+    ASSERT_TRUE(coverage.flush(CoverageFile).has_value());
+
+    auto data = boyboy::common::files::read_binary(CoverageFile);
+    ASSERT_TRUE(data.has_value());
+    ASSERT_EQ(
+        data->size(),
+        sizeof(CoverageFileHeader) + ((2 * CoverageMap::RomBankWords + CoverageMap::WramWords +
+                                       CoverageMap::HramWords) *
+                                      sizeof(CoverageMap::Word))
+    );
+
+    CoverageFileHeader header{};
+    std::memcpy(&header, data->data(), sizeof(header));
+    EXPECT_EQ(header.magic, CoverageFileHeader::Magic);
+    EXPECT_EQ(header.version, CoverageFileHeader::CurrentVersion);
+    EXPECT_EQ(header.rom_banks, 2);
+
+    // Bank 1 bitmap, then WRAM
+    CoverageMap::Word word{};
+    auto bank1 = sizeof(header) + (CoverageMap::RomBankWords * sizeof(word));
+    std::memcpy(&word, data->data() + bank1, sizeof(word));
+    EXPECT_EQ(word, 0b10);
+
+    auto wram = sizeof(header) + (2 * CoverageMap::RomBankWords * sizeof(word));
+    std::memcpy(&word, data->data() + wram, sizeof(word));
+    EXPECT_EQ(word, 0b1);
+}
+
+class CpuCoverageTest : public CpuTest {
+protected:
+    static constexpr uint16_t Start = boyboy::core::mmu::WRAM0Start;
+};
+
+TEST_F(CpuCoverageTest, Disabled)
+{
+    set_next_instruction(Opcode::NOP);
+    step();
+
+    EXPECT_FALSE(cpu->is_coverage_enabled());
+    EXPECT_FALSE(cpu->get_coverage().is_covered(Start, 0));
+}
+
+TEST_F(CpuCoverageTest, RecordsOpcodeFetches)
+{
+    cpu->enable_coverage(true);
+
+    // NOP; LD B, 0x42; NOP
+    set_next_bytes({
+        std::to_underlying(Opcode::NOP),
+        std::to_underlying(Opcode::LD_B_N8),
+        0x42,
+        std::to_underlying(Opcode::NOP),
+    });
+    step();
+    step();
+    step();
+
+    const auto& coverage = cpu->get_coverage();
+    EXPECT_TRUE(coverage.is_covered(Start, 0));
+    EXPECT_TRUE(coverage.is_covered(Start + 1, 0));
+    EXPECT_FALSE(coverage.is_covered(Start + 2, 0)) << "Operands aren't opcode fetches";
+    EXPECT_TRUE(coverage.is_covered(Start + 3, 0));
+}
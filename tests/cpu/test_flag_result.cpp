@@ -0,0 +1,149 @@
+/**
+ * @file test_flag_result.cpp
+ * @brief Unit tests for the CPU flags computation of the ALU operations.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+// Helpers
+#include "helpers/cpu_fixtures.h"
+
+// boyboy
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/flag_result.h"
+#include "boyboy/core/cpu/opcodes.h"
+#include "boyboy/core/cpu/registers.h"
+
+using boyboy::core::cpu::Flag;
+using boyboy::core::cpu::FlagOp;
+using boyboy::core::cpu::FlagResult;
+using boyboy::core::cpu::Opcode;
+using boyboy::core::cpu::Reg16Name;
+using boyboy::core::cpu::Reg8Name;
+
+using boyboy::test::cpu::CpuTest;
+
+namespace {
+
+uint8_t make_flags(bool z, bool n, bool h, bool c)
+{
+    return (z ? Flag::Zero : 0) | (n ? Flag::Substract : 0) | (h ? Flag::HalfCarry : 0) |
+           (c ? Flag::Carry : 0);
+}
+
+} // namespace
+
+TEST(FlagResultTest, AddMatchesReference)
+{
+    for (int a = 0; a <= 0xFF; ++a) {
+        for (int b = 0; b <= 0xFF; ++b) {
+            for (int carry = 0; carry <= 1; ++carry) {
+                int sum = a + b + carry;
+                auto result = static_cast<uint8_t>(sum);
+                FlagResult flags{
+                    .op = FlagOp::Add,
+                    .result = result,
+                    .lhs = static_cast<uint8_t>(a),
+                    .rhs = static_cast<uint8_t>(b),
+                    .carry = static_cast<uint8_t>(carry),
+                };
+                ASSERT_EQ(
+                    flags.flags(),
+                    make_flags(result == 0, false, ((a & 0xF) + (b & 0xF) + carry) > 0xF, sum > 0xFF)
+                ) << a << " + " << b << " + " << carry;
+            }
+        }
+    }
+}
+
+TEST(FlagResultTest, SubMatchesReference)
+{
+    for (int a = 0; a <= 0xFF; ++a) {
+        for (int b = 0; b <= 0xFF; ++b) {
+            for (int carry = 0; carry <= 1; ++carry) {
+                auto result = static_cast<uint8_t>(a - b - carry);
+                FlagResult flags{
+                    .op = FlagOp::Sub,
+                    .result = result,
+                    .lhs = static_cast<uint8_t>(a),
+                    .rhs = static_cast<uint8_t>(b),
+                    .carry = static_cast<uint8_t>(carry),
+                };
+                ASSERT_EQ(
+                    flags.flags(),
+                    make_flags(result == 0, true, (a & 0xF) < ((b & 0xF) + carry), a < (b + carry))
+                ) << a << " - " << b << " - " << carry;
+            }
+        }
+    }
+}
+
+TEST(FlagResultTest, IncDecKeepCarry)
+{
+    EXPECT_EQ((FlagResult{.op = FlagOp::Inc, .result = 0x00, .carry = 1}.flags()),
+              make_flags(true, false, true, true));
+    EXPECT_EQ((FlagResult{.op = FlagOp::Inc, .result = 0x11, .carry = 0}.flags()),
+              make_flags(false, false, false, false));
+    EXPECT_EQ((FlagResult{.op = FlagOp::Dec, .result = 0x0F, .carry = 1}.flags()),
+              make_flags(false, true, true, true));
+    EXPECT_EQ((FlagResult{.op = FlagOp::Dec, .result = 0x00, .carry = 0}.flags()),
+              make_flags(true, true, false, false));
+}
+
+TEST(FlagResultTest, LogicAndShifts)
+{
+    EXPECT_EQ((FlagResult{.op = FlagOp::And, .result = 0x00}.flags()),
+              make_flags(true, false, true, false));
+    EXPECT_EQ((FlagResult{.op = FlagOp::Logic, .result = 0x01}.flags()),
+              make_flags(false, false, false, false));
+    EXPECT_EQ((FlagResult{.op = FlagOp::Shift, .result = 0x00, .carry = 1}.flags()),
+              make_flags(true, false, false, true));
+    EXPECT_EQ((FlagResult{.op = FlagOp::RotateA, .result = 0x00, .carry = 1}.flags()),
+              make_flags(false, false, false, true));
+}
+
+class CpuFlagsTest : public CpuTest {};
+
+TEST_F(CpuFlagsTest, PushAfSeesAluFlags)
+{
+    cpu->set_register(Reg8Name::A, 0x42);
+    cpu->set_sp(0xFFFE);
+
+    run(Opcode::SUB_A_A);
+    run(Opcode::PUSH_AF);
+
+    EXPECT_EQ(cpu->read_byte(0xFFFC), make_flags(true, true, false, false));
+    EXPECT_EQ(cpu->get_register(Reg16Name::AF), 0x00C0);
+}
+
+TEST_F(CpuFlagsTest, RegisterWriteOverridesAluFlags)
+{
+    run(Opcode::XOR_A_A);
+    EXPECT_TRUE(cpu->get_flag(Flag::Zero));
+
+    cpu->set_register(Reg8Name::F, Flag::Carry);
+    EXPECT_EQ(cpu->get_flags(), Flag::Carry);
+
+    // Single flag writes keep the other flags
+    cpu->set_flag(Flag::HalfCarry, true);
+    EXPECT_EQ(cpu->get_flags(), Flag::Carry | Flag::HalfCarry);
+}
+
+TEST_F(CpuFlagsTest, IncKeepsCarry)
+{
+    cpu->set_register(Reg8Name::A, 0xF0);
+    cpu->set_register(Reg8Name::B, 0x20);
+    cpu->set_register(Reg8Name::C, 0xFF);
+
+    // ADD A, B carries out, INC C must keep it
+    run(Opcode::ADD_A_B);
+    run(Opcode::INC_C);
+
+    EXPECT_EQ(cpu->get_register(Reg8Name::A), 0x10);
+    EXPECT_EQ(cpu->get_register(Reg8Name::C), 0x00);
+    EXPECT_EQ(cpu->get_flags(), make_flags(true, false, true, true));
+}
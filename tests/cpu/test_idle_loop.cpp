@@ -0,0 +1,277 @@
+/**
+ * @file test_idle_loop.cpp
+ * @brief Tests for the CPU idle loop detection.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// helpers
+#include "helpers/cpu_fixtures.h"
+
+// boyboy
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/cycles.h"
+#include "boyboy/core/cpu/idle_loop.h"
+#include "boyboy/core/cpu/interrupts.h"
+#include "boyboy/core/cpu/opcodes.h"
+#include "boyboy/core/cpu/registers.h"
+#include "boyboy/core/io/registers.h"
+#include "boyboy/core/mmu/constants.h"
+#include "boyboy/core/mmu/watchpoints.h"
+
+using boyboy::test::cpu::CpuTest;
+
+using namespace boyboy::core::cpu;
+
+using boyboy::core::io::IoReg;
+using boyboy::core::mmu::WatchKind;
+
+class IdleLoopTest : public CpuTest {
+protected:
+    static constexpr uint16_t Start = boyboy::core::mmu::WRAM0Start;
+
+    // LDH A, [LY]; CP 0x90; JR NZ, -6
+    const std::vector<uint8_t> PollLy = {
+        std::to_underlying(Opcode::LDH_A_AT_A8),
+        0x44,
+        std::to_underlying(Opcode::CP_A_N8),
+        0x90,
+        std::to_underlying(Opcode::JR_NZ_E8),
+        0xFA,
+    };
+    static constexpr TCycle PollLyPeriod = 12 + 8 + 12;
+    static constexpr TCycle NoEvent = IdleLoopDetector::NoEvent;
+
+    void SetUp() override
+    {
+        CpuTest::SetUp();
+        cpu->set_tick_mode(TickMode::Instruction);
+        cpu->enable_idle_loop_skip(true);
+    }
+
+    void tick(int ticks = 1) const
+    {
+        while (ticks-- > 0) {
+            cpu->tick();
+        }
+    }
+
+    // Analyze a loop closed by the branch at `branch`, with the current registers
+    [[nodiscard]] IdleLoop analyze(const std::vector<uint8_t>& program, uint16_t branch) const
+    {
+        set_next_bytes(program);
+        IdleLoopDetector::RegisterSnapshot regs = {
+            cpu->get_register(Reg16Name::AF),
+            cpu->get_register(Reg16Name::BC),
+            cpu->get_register(Reg16Name::DE),
+            cpu->get_register(Reg16Name::HL),
+            cpu->get_register(Reg16Name::SP),
+        };
+        return cpu->get_idle_loop_detector().analyze(Start, Start + branch, regs);
+    }
+
+    [[nodiscard]] const IdleLoopDetector::Stats& stats() const
+    {
+        return cpu->get_idle_loop_detector().stats();
+    }
+};
+
+TEST_F(IdleLoopTest, Disabled)
+{
+    cpu->enable_idle_loop_skip(false);
+    set_next_bytes(PollLy);
+
+    tick(3 * 3);
+    EXPECT_EQ(cpu->get_pc(), Start);
+    EXPECT_EQ(cpu->skip_idle_loop(NoEvent, 1000), 0);
+    EXPECT_EQ(stats().detected, 0);
+}
+
+TEST_F(IdleLoopTest, PollingLoopIsSkipped)
+{
+    set_next_bytes(PollLy);
+
+    // The first iteration only analyzes the loop, the second one confirms it
+    tick(3);
+    EXPECT_EQ(cpu->skip_idle_loop(NoEvent, 1000), 0);
+    tick(3);
+    EXPECT_EQ(stats().detected, 1);
+
+    // Only whole iterations are skipped
+    auto cycles = cpu->get_cycles();
+    EXPECT_EQ(cpu->skip_idle_loop(NoEvent, 100), 3 * PollLyPeriod);
+    EXPECT_EQ(cpu->get_cycles(), cycles + (3 * PollLyPeriod));
+    EXPECT_EQ(cpu->get_pc(), Start);
+    EXPECT_EQ(cpu->skip_idle_loop(NoEvent, PollLyPeriod - 1), 0);
+
+    // Running another iteration keeps the loop confirmed
+    tick(3);
+    EXPECT_EQ(cpu->skip_idle_loop(NoEvent, PollLyPeriod), PollLyPeriod);
+    EXPECT_EQ(stats().detected, 1);
+    EXPECT_EQ(stats().skipped_cycles, 4 * PollLyPeriod);
+}
+
+TEST_F(IdleLoopTest, EventDuringIterationIsNotSkipped)
+{
+    set_next_bytes(PollLy);
+    tick(3);
+    EXPECT_EQ(cpu->skip_idle_loop(100, 1000), 0);
+    tick(3);
+
+    // The event 100 cycles ago fired during the last iteration, the polled value might be stale
+    EXPECT_EQ(cpu->skip_idle_loop(400, 1000), 0);
+    tick(3);
+
+    // A whole iteration ran before the same event
+    EXPECT_EQ(cpu->skip_idle_loop(400 - PollLyPeriod, 1000), (400 / PollLyPeriod - 1) * PollLyPeriod);
+}
+
+TEST_F(IdleLoopTest, PendingInterruptIsNotSkipped)
+{
+    set_next_bytes(PollLy);
+    tick(2 * 3);
+
+    cpu->set_ime(true);
+    cpu->enable_interrupt(Interrupt::VBlank);
+    cpu->request_interrupt(Interrupt::VBlank);
+    EXPECT_EQ(cpu->skip_idle_loop(NoEvent, 1000), 0);
+}
+
+TEST_F(IdleLoopTest, WatchedPollIsNotSkipped)
+{
+    set_next_bytes(PollLy);
+    tick(2 * 3);
+    ASSERT_EQ(stats().detected, 1);
+
+    // Trapping LY drops the confirmed loop, its reads aren't skipped anymore
+    mmu->add_watchpoint(IoReg::Ppu::LY, IoReg::Ppu::LY, WatchKind::Read);
+    EXPECT_EQ(cpu->skip_idle_loop(NoEvent, 1000), 0);
+    for (int i = 0; i < 3; ++i) {
+        tick(3);
+        ASSERT_TRUE(mmu->watch_hit().has_value());
+        EXPECT_EQ(mmu->watch_hit()->addr, IoReg::Ppu::LY);
+        mmu->clear_watch_hit();
+        EXPECT_EQ(cpu->skip_idle_loop(NoEvent, 1000), 0);
+    }
+    EXPECT_EQ(stats().detected, 1);
+    EXPECT_FALSE(analyze(PollLy, 4).is_idle_candidate());
+
+    // Watched code isn't skipped either
+    mmu->clear_watchpoints();
+    mmu->add_watchpoint(Start, Start, WatchKind::Execute);
+    EXPECT_FALSE(analyze(PollLy, 4).is_idle_candidate());
+}
+
+TEST_F(IdleLoopTest, CountingLoopIsNotSkipped)
+{
+    // LD B, 0x10; loop: DEC B; JR NZ, loop
+    set_next_bytes({
+        std::to_underlying(Opcode::LD_B_N8),
+        0x10,
+        std::to_underlying(Opcode::DEC_B),
+        std::to_underlying(Opcode::JR_NZ_E8),
+        0xFD,
+    });
+
+    tick(1);
+    for (int i = 0; i < 8; ++i) {
+        tick(2);
+        EXPECT_EQ(cpu->skip_idle_loop(NoEvent, 1000), 0);
+    }
+    EXPECT_EQ(stats().detected, 0);
+}
+
+TEST_F(IdleLoopTest, AnalyzeLoopBodies)
+{
+    // Static poll, see PollLy
+    auto loop = analyze(PollLy, 4);
+    EXPECT_TRUE(loop.is_idle_candidate());
+    EXPECT_EQ(loop.period, PollLyPeriod);
+    EXPECT_FALSE(loop.indirect);
+
+    // JR @
+    loop = analyze({std::to_underlying(Opcode::JR_E8), 0xFE}, 0);
+    EXPECT_EQ(loop.period, 12);
+
+    // BIT 1, [HL]; JR NZ, -4
+    cpu->set_register(Reg16Name::HL, 0xFF41);
+    loop = analyze(
+        {0xCB,
+         std::to_underlying(CBOpcode::BIT_1_AT_HL),
+         std::to_underlying(Opcode::JR_NZ_E8),
+         0xFC},
+        2
+    );
+    EXPECT_EQ(loop.period, 12 + 12);
+    EXPECT_TRUE(loop.indirect);
+
+    // LDH A, [LY]; CP 0x90; JR Z, exit; JR -8
+    loop = analyze(
+        {std::to_underlying(Opcode::LDH_A_AT_A8),
+         0x44,
+         std::to_underlying(Opcode::CP_A_N8),
+         0x90,
+         std::to_underlying(Opcode::JR_Z_E8),
+         0x02,
+         std::to_underlying(Opcode::JR_E8),
+         0xF8},
+        6
+    );
+    EXPECT_EQ(loop.period, 12 + 8 + 8 + 12);
+}
+
+TEST_F(IdleLoopTest, AnalyzeRejectsSideEffects)
+{
+    // LDH A, [LY]; LDH [0x80], A; JR -6
+    auto loop = analyze(
+        {std::to_underlying(Opcode::LDH_A_AT_A8),
+         0x44,
+         std::to_underlying(Opcode::LDH_AT_A8_A),
+         0x80,
+         std::to_underlying(Opcode::JR_E8),
+         0xFA},
+        4
+    );
+    EXPECT_FALSE(loop.is_idle_candidate());
+
+    // LDH A, [DIV]; AND 0x01; JR Z, -6 (DIV counts between events)
+    loop = analyze(
+        {std::to_underlying(Opcode::LDH_A_AT_A8),
+         0x04,
+         std::to_underlying(Opcode::AND_A_N8),
+         0x01,
+         std::to_underlying(Opcode::JR_Z_E8),
+         0xFA},
+        4
+    );
+    EXPECT_FALSE(loop.is_idle_candidate());
+
+    // BIT 1, [HL]; INC L; JR NZ, -5 (the polled address changes)
+    cpu->set_register(Reg16Name::HL, 0xFF41);
+    loop = analyze(
+        {0xCB,
+         std::to_underlying(CBOpcode::BIT_1_AT_HL),
+         std::to_underlying(Opcode::INC_L),
+         std::to_underlying(Opcode::JR_NZ_E8),
+         0xFB},
+        3
+    );
+    EXPECT_FALSE(loop.is_idle_candidate());
+
+    // CALL 0x0000; JR -5
+    loop = analyze(
+        {std::to_underlying(Opcode::CALL_A16),
+         0x00,
+         0x00,
+         std::to_underlying(Opcode::JR_E8),
+         0xFB},
+        3
+    );
+    EXPECT_FALSE(loop.is_idle_candidate());
+}
@@ -7,7 +7,11 @@
 
 #include <gtest/gtest.h>
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <set>
+#include <string>
 #include <string_view>
 
 #include "boyboy/core/cpu/instructions.h"
@@ -18,12 +22,12 @@ using namespace boyboy::core::cpu;
 namespace {
 
 void check_unique_function_names(
-    const std::array<Instruction, 256>& table, const std::string& table_name
+    const std::array<std::string_view, 256>& table, const std::string& table_name
 )
 {
     std::set<std::string_view> func_names;
-    for (const auto& instr : table) {
-        func_names.insert(instr.mnemonic); // Or instr.func_name if available
+    for (const auto& mnemonic : table) {
+        func_names.insert(mnemonic);
     }
     EXPECT_EQ(func_names.size(), table.size())
         << "Duplicate function names detected in " << table_name;
@@ -36,33 +40,48 @@ void check_mnemonic_contains(const Instruction& instr, const std::string& substr
 
 } // namespace
 
-TEST(InstructionTableTest, OpcodesSize) { EXPECT_EQ(InstructionTable::Opcodes.size(), 256); }
+constexpr auto Unprefixed = static_cast<size_t>(InstructionType::Unprefixed);
+constexpr auto CBPrefixed = static_cast<size_t>(InstructionType::CBPrefixed);
 
-TEST(InstructionTableTest, CBOpcodesSize) { EXPECT_EQ(InstructionTable::CBOpcodes.size(), 256); }
+// The tables are usable at compile time
+static_assert(InstructionTable::cycles(InstructionType::Unprefixed, 0x00) == 4);
+static_assert(InstructionTable::mnemonic(InstructionType::CBPrefixed, 0x37) == "SWAP A");
+
+TEST(InstructionTableTest, OpcodesSize)
+{
+    EXPECT_EQ(InstructionTable::Handlers[Unprefixed].size(), 256);
+    EXPECT_EQ(InstructionTable::Mnemonics[Unprefixed].size(), 256);
+}
+
+TEST(InstructionTableTest, CBOpcodesSize)
+{
+    EXPECT_EQ(InstructionTable::Handlers[CBPrefixed].size(), 256);
+    EXPECT_EQ(InstructionTable::Mnemonics[CBPrefixed].size(), 256);
+}
 
 TEST(InstructionTableTest, UniqueFunctionNames)
 {
-    check_unique_function_names(InstructionTable::Opcodes, "unprefixed opcodes");
-    check_unique_function_names(InstructionTable::CBOpcodes, "CB-prefixed opcodes");
+    check_unique_function_names(InstructionTable::Mnemonics[Unprefixed], "unprefixed opcodes");
+    check_unique_function_names(InstructionTable::Mnemonics[CBPrefixed], "CB-prefixed opcodes");
 }
 
 TEST(InstructionTableTest, MnemonicFormatting)
 {
     // Example: unprefixed
-    check_mnemonic_contains(InstructionTable::Opcodes[0x00], "NOP");
-    check_mnemonic_contains(InstructionTable::Opcodes[0x34], "[HL]");
+    check_mnemonic_contains(InstructionTable::get_instruction(Opcode::NOP), "NOP");
+    check_mnemonic_contains(InstructionTable::get_instruction(Opcode::INC_AT_HL), "[HL]");
 
     // Example: CB-prefixed
-    check_mnemonic_contains(InstructionTable::CBOpcodes[0x11], "C");
-    check_mnemonic_contains(InstructionTable::CBOpcodes[0x11], "RL");
+    check_mnemonic_contains(InstructionTable::get_instruction(CBOpcode::RL_C), "C");
+    check_mnemonic_contains(InstructionTable::get_instruction(CBOpcode::RL_C), "RL");
 }
 
 TEST(InstructionTableTest, IllegalOpcodes)
 {
     // Ensure illegal opcodes point to a handler (non-null execute)
-    const auto& illegal_opcodes = {0xFC, 0xFD, 0xFE, 0xFF};
+    const auto& illegal_opcodes = {uint8_t{0xFC}, uint8_t{0xFD}, uint8_t{0xFE}, uint8_t{0xFF}};
     for (auto code : illegal_opcodes) {
-        EXPECT_NE(InstructionTable::Opcodes.at(code).execute, nullptr)
+        EXPECT_NE(InstructionTable::handler(InstructionType::Unprefixed, code), nullptr)
             << "Illegal opcode 0x" << std::hex << static_cast<int>(code) << " has no handler";
     }
 }
@@ -70,48 +89,60 @@ TEST(InstructionTableTest, IllegalOpcodes)
 TEST(InstructionTableTest, OperandFormatting)
 {
     // Check that memory-pointer operands are wrapped in parentheses
-    const auto& ptr_opcodes = {0x34, 0x36}; // Example opcodes that use (HL)
+    const auto& ptr_opcodes = {uint8_t{0x34}, uint8_t{0x36}}; // Example opcodes that use (HL)
     for (auto code : ptr_opcodes) {
-        const auto& instr = InstructionTable::Opcodes.at(code);
+        auto instr = InstructionTable::get_instruction(InstructionType::Unprefixed, code);
         EXPECT_NE(instr.mnemonic.find("[HL]"), std::string::npos)
             << "Opcode 0x" << std::hex << static_cast<int>(code)
             << " should have [HL] in mnemonic: " << instr.mnemonic;
     }
 
     // Check that increment/decrement operators include + or -
-    const auto& inc_opcodes = {0x22, 0x2A}; // Example INC opcodes
+    const auto& inc_opcodes = {uint8_t{0x22}, uint8_t{0x2A}}; // Example INC opcodes
     for (auto code : inc_opcodes) {
-        const auto& instr = InstructionTable::Opcodes.at(code);
+        auto instr = InstructionTable::get_instruction(InstructionType::Unprefixed, code);
         EXPECT_NE(instr.mnemonic.find('+'), std::string::npos)
             << "Opcode 0x" << std::hex << static_cast<int>(code)
             << " should have '+' in mnemonic: " << instr.mnemonic;
     }
 
-    const auto& dec_opcodes = {0x32, 0x3A}; // Example DEC opcodes
+    const auto& dec_opcodes = {uint8_t{0x32}, uint8_t{0x3A}}; // Example DEC opcodes
     for (auto code : dec_opcodes) {
-        const auto& instr = InstructionTable::Opcodes.at(code);
+        auto instr = InstructionTable::get_instruction(InstructionType::Unprefixed, code);
         EXPECT_NE(instr.mnemonic.find('-'), std::string::npos)
             << "Opcode 0x" << std::hex << static_cast<int>(code)
             << " should have '-' in mnemonic: " << instr.mnemonic;
     }
 }
 
-TEST(InstructionTableTest, GetInstructionTable)
+TEST(InstructionTableTest, HotAndColdTablesMatch)
 {
-    const auto& unprefixed = InstructionTable::get_instruction_table(InstructionType::Unprefixed);
-    EXPECT_EQ(unprefixed.size(), 256);
+    for (auto type : {InstructionType::Unprefixed, InstructionType::CBPrefixed}) {
+        for (size_t code = 0; code < 256; ++code) {
+            auto opcode = static_cast<uint8_t>(code);
+            auto instr = InstructionTable::get_instruction(type, opcode);
+            EXPECT_EQ(instr.execute, InstructionTable::handler(type, opcode));
+            EXPECT_EQ(instr.cycles, InstructionTable::cycles(type, opcode));
+            EXPECT_EQ(instr.cycles_no_branch, InstructionTable::cycles_no_branch(type, opcode));
+            EXPECT_EQ(instr.mnemonic, InstructionTable::mnemonic(type, opcode));
+            EXPECT_EQ(instr.length, InstructionTable::length(type, opcode));
+        }
+    }
 
-    const auto& cbprefixed = InstructionTable::get_instruction_table(InstructionType::CBPrefixed);
-    EXPECT_EQ(cbprefixed.size(), 256);
+    // Branching instructions only
+    EXPECT_EQ(InstructionTable::cycles_no_branch(InstructionType::Unprefixed, 0x20), 8); // JR NZ
+    EXPECT_EQ(InstructionTable::cycles(InstructionType::Unprefixed, 0x20), 12);
+    EXPECT_EQ(InstructionTable::cycles_no_branch(InstructionType::Unprefixed, 0x00), 0); // NOP
+    EXPECT_EQ(InstructionTable::length(InstructionType::Unprefixed, 0xFA), 3); // LD A, [a16]
 }
 
 TEST(InstructionTableTest, GetInstruction)
 {
-    const auto& instr = InstructionTable::get_instruction(InstructionType::Unprefixed, 0x00);
+    auto instr = InstructionTable::get_instruction(InstructionType::Unprefixed, 0x00);
     EXPECT_EQ(instr.mnemonic, "NOP");
     EXPECT_NE(instr.execute, nullptr);
 
-    const auto& cb_instr = InstructionTable::get_instruction(InstructionType::CBPrefixed, 0x11);
+    auto cb_instr = InstructionTable::get_instruction(InstructionType::CBPrefixed, 0x11);
     EXPECT_NE(cb_instr.mnemonic.find('C'), std::string::npos);
     EXPECT_NE(cb_instr.mnemonic.find("RL"), std::string::npos);
     EXPECT_NE(cb_instr.execute, nullptr);
@@ -15,12 +15,14 @@
 #include "boyboy/core/cpu/interrupt_handler.h"
 #include "boyboy/core/cpu/interrupts.h"
 #include "boyboy/core/cpu/state.h"
+#include "boyboy/core/io/registers.h"
 
 // Helpers
 #include "helpers/cpu_fixtures.h"
 
 using boyboy::core::cpu::Interrupt;
 using boyboy::core::cpu::InterruptVector;
+using boyboy::core::cpu::is_instruction_stepped;
 using boyboy::core::cpu::Stage;
 using boyboy::core::cpu::TickMode;
 
@@ -127,7 +129,7 @@ TEST_F(CpuInterruptsTest, VBlankInterrupt)
     EXPECT_TRUE(cpu->is_halted() == false) << "CPU should not be in HALT state";
 
     auto expected_pc = initial_pc;
-    if (cpu->get_tick_mode() != TickMode::Instruction) {
+    if (!is_instruction_stepped(cpu->get_tick_mode())) {
         ++expected_pc;
     }
     EXPECT_EQ(cpu->read_word(cpu->get_sp()), expected_pc) << "PC should be pushed to stack";
@@ -148,7 +150,7 @@ TEST_F(CpuInterruptsTest, NoInterruptWhenIMEOff)
     EXPECT_TRUE(interrupt_handler.is_enabled(Interrupt::VBlank));
     EXPECT_TRUE(interrupt_handler.is_requested(Interrupt::VBlank));
 
-    if (cpu->get_tick_mode() == TickMode::Instruction) {
+    if (is_instruction_stepped(cpu->get_tick_mode())) {
         service_interrupts();
     }
     else {
@@ -185,7 +187,7 @@ TEST_F(CpuInterruptsTest, NoInterruptWhenNoneRequested)
     EXPECT_TRUE(interrupt_handler.is_enabled(Interrupt::VBlank));
     EXPECT_FALSE(interrupt_handler.is_requested(Interrupt::VBlank));
 
-    if (cpu->get_tick_mode() == TickMode::Instruction) {
+    if (is_instruction_stepped(cpu->get_tick_mode())) {
         service_interrupts();
     }
     else {
@@ -244,7 +246,7 @@ TEST_F(CpuInterruptsTest, MultipleInterrupts)
     EXPECT_EQ(cpu->get_sp(), initial_sp - 2) << "SP should be decremented by 2";
 
     auto expected_pc = initial_pc;
-    if (cpu->get_tick_mode() != TickMode::Instruction) {
+    if (!is_instruction_stepped(cpu->get_tick_mode())) {
         ++expected_pc;
     }
     EXPECT_EQ(cpu->read_word(cpu->get_sp()), expected_pc) << "PC should be pushed to stack";
@@ -266,7 +268,7 @@ TEST_F(CpuInterruptsTest, MultipleInterrupts)
     EXPECT_EQ(cpu->get_sp(), initial_sp - 4) << "SP should be decremented by another 2";
 
     expected_pc = initial_pc;
-    if (cpu->get_tick_mode() != TickMode::Instruction) {
+    if (!is_instruction_stepped(cpu->get_tick_mode())) {
         ++expected_pc;
     }
     EXPECT_EQ(cpu->read_word(cpu->get_sp()), expected_pc)
@@ -308,7 +310,7 @@ TEST_F(CpuInterruptsTest, HaltThenInterrupt)
     EXPECT_EQ(cpu->get_sp(), initial_sp - 2) << "SP should be decremented by 2";
     // In "cycle" mode SP is PC+2 because of fetch/execute overlap
     auto expected_sp = initial_pc +
-                       ((cpu->get_tick_mode() == boyboy::core::cpu::TickMode::Instruction ||
+                       ((is_instruction_stepped(cpu->get_tick_mode()) ||
                          !cpu->is_fe_overlap_enabled())
                             ? 1
                             : 2);
@@ -341,4 +343,105 @@ TEST_F(CpuInterruptsTest, WakeUpIMEOff)
     EXPECT_FALSE(cpu->is_halted());
     EXPECT_TRUE(interrupt_handler.is_enabled(Interrupt::VBlank));
     EXPECT_TRUE(interrupt_handler.is_requested(Interrupt::VBlank));
-}
\ No newline at end of file
+}
+// A halted CPU skips idle cycles in one go until something can wake it up
+TEST_F(CpuInterruptsTest, HaltFastForward)
+{
+    using boyboy::core::cpu::TickMode;
+
+    cpu->set_ime(true);
+    cpu->enable_interrupt(Interrupt::VBlank);
+    EXPECT_EQ(cpu->fast_forward(8), 0) << "Running CPU can't be fast-forwarded";
+
+    set_next_instruction(boyboy::core::cpu::Opcode::HALT);
+    step();
+    ASSERT_TRUE(cpu->is_halted());
+
+    // Skipped cycles are rounded up to the tick granularity
+    auto expected = (cpu->get_tick_mode() == TickMode::TCycle) ? 10U : 12U;
+    auto cycles = cpu->get_cycles();
+    EXPECT_EQ(cpu->fast_forward(10), expected);
+    EXPECT_EQ(cpu->get_cycles(), cycles + expected);
+    EXPECT_TRUE(cpu->is_halted());
+
+    // Pending interrupts wake the CPU up, no more skipping
+    cpu->request_interrupt(Interrupt::VBlank);
+    EXPECT_EQ(cpu->fast_forward(10), 0);
+
+    service_interrupts();
+    EXPECT_FALSE(cpu->is_halted());
+    EXPECT_EQ(cpu->get_pc(), std::to_underlying(InterruptVector::VBlank));
+}
+
+// HALT with IME off and a pending interrupt doesn't halt, the next byte is fetched twice
+TEST_F(CpuInterruptsTest, HaltBug)
+{
+    using boyboy::core::cpu::Opcode;
+    using boyboy::core::cpu::Reg8Name;
+
+    cpu->set_tick_mode(TickMode::Instruction);
+    cpu->set_ime(false);
+    cpu->enable_interrupt(Interrupt::VBlank);
+    cpu->request_interrupt(Interrupt::VBlank);
+    cpu->set_register(Reg8Name::B, 0x00);
+
+    auto start = cpu->get_pc();
+    set_next_bytes({std::to_underlying(Opcode::HALT), std::to_underlying(Opcode::INC_B)});
+
+    cpu->tick();
+    EXPECT_FALSE(cpu->is_halted());
+    EXPECT_EQ(cpu->get_pc(), start + 1);
+
+    // INC B runs twice
+    cpu->tick();
+    EXPECT_EQ(cpu->get_pc(), start + 1);
+    cpu->tick();
+    EXPECT_EQ(cpu->get_pc(), start + 2);
+    EXPECT_EQ(cpu->get_register(Reg8Name::B), 0x02);
+}
+
+// IE & IF is cached and kept in sync with writes through the memory bus
+TEST_F(CpuInterruptsTest, PendingMaskFollowsWrites)
+{
+    using boyboy::core::io::IoReg;
+
+    auto& interrupt_handler = cpu->get_interrupt_handler();
+    EXPECT_EQ(interrupt_handler.pending(), 0);
+
+    mmu->write_byte(IoReg::Interrupts::IF, 0x05);
+    EXPECT_EQ(interrupt_handler.pending(), 0) << "Nothing enabled yet";
+
+    mmu->write_byte(IoReg::Interrupts::IE, 0x04);
+    EXPECT_EQ(interrupt_handler.pending(), 0x04);
+    EXPECT_EQ(mmu->read_byte(IoReg::Interrupts::IE), 0x04);
+    EXPECT_EQ(mmu->read_byte(IoReg::Interrupts::IF), 0x05);
+
+    // Requests keep the other interrupts requested
+    io->interrupts().request(Interrupt::Serial);
+    EXPECT_EQ(mmu->read_byte(IoReg::Interrupts::IF), 0x0D);
+
+    mmu->write_byte(IoReg::Interrupts::IF, 0x00);
+    EXPECT_EQ(interrupt_handler.pending(), 0);
+}
+
+// Upper IF/IE bits have no interrupt source and can't wake the CPU up
+TEST_F(CpuInterruptsTest, UnusedBitsAreNotPending)
+{
+    using boyboy::core::io::IoReg;
+
+    cpu->set_halted(true);
+    mmu->write_byte(IoReg::Interrupts::IE, 0xFF);
+    mmu->write_byte(IoReg::Interrupts::IF, 0xE0);
+
+    EXPECT_EQ(cpu->get_interrupt_handler().pending(), 0);
+    EXPECT_FALSE(cpu->get_interrupt_handler().should_wake_up());
+}
+
+TEST_F(CpuInterruptsTest, HighestPriorityIsLowestBit)
+{
+    using boyboy::core::cpu::InterruptRegisters;
+
+    EXPECT_EQ(InterruptRegisters::highest_priority(0x1F), Interrupt::VBlank);
+    EXPECT_EQ(InterruptRegisters::highest_priority(0x16), Interrupt::LCDStat);
+    EXPECT_EQ(InterruptRegisters::highest_priority(0x10), Interrupt::Joypad);
+}
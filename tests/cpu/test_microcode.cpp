@@ -0,0 +1,213 @@
+/**
+ * @file test_microcode.cpp
+ * @brief Tests for the CPU M-cycle microprograms.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+
+// helpers
+#include "common/roms.h"
+#include "helpers/cpu_fixtures.h"
+#include "helpers/rom_fixtures.h"
+
+// boyboy
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/cycles.h"
+#include "boyboy/core/cpu/instructions.h"
+#include "boyboy/core/cpu/instructions_table.h"
+#include "boyboy/core/cpu/microcode.h"
+#include "boyboy/core/cpu/opcodes.h"
+#include "boyboy/core/cpu/registers.h"
+#include "boyboy/core/mmu/constants.h"
+
+using boyboy::test::cpu::CpuTest;
+using boyboy::test::rom::ConfigROMTest;
+
+using namespace boyboy::core::cpu;
+using namespace boyboy::test::common;
+
+class MicrocodeTest : public CpuTest {
+protected:
+    static constexpr uint16_t Data = boyboy::core::mmu::WRAM0Start + 0x100;
+    static constexpr uint16_t Stack = boyboy::core::mmu::WRAM1Start;
+
+    void SetUp() override
+    {
+        CpuTest::SetUp();
+        cpu->set_tick_mode(TickMode::MCycle);
+        cpu->enable_microcode(true);
+        cpu->set_sp(Stack);
+    }
+
+    void tick(int mcycles = 1) const
+    {
+        while (mcycles-- > 0) {
+            cpu->tick();
+        }
+    }
+};
+
+TEST_F(MicrocodeTest, ProgramsMatchInstructionTable)
+{
+    for (auto type : {InstructionType::Unprefixed, InstructionType::CBPrefixed}) {
+        int fetches = (type == InstructionType::CBPrefixed) ? 2 : 1;
+        for (int i = 0; i < 256; ++i) {
+            auto opcode = static_cast<uint8_t>(i);
+            const auto& program = MicrocodeTable::get(type, opcode);
+            if (program.length == 0) {
+                continue;
+            }
+            const auto& instr = InstructionTable::get_instruction(type, opcode);
+            int cycles_no_branch = (instr.cycles_no_branch != 0) ? instr.cycles_no_branch
+                                                                 : instr.cycles;
+
+            int mcycles = 0;
+            for (int step = 0; step < program.length; ++step) {
+                mcycles += (program.steps.at(step).action != MicroAction::Execute) ? 1 : 0;
+            }
+            EXPECT_EQ(program.mcycles, (cycles_no_branch / 4) - fetches) << instr.mnemonic;
+            EXPECT_EQ(mcycles, (instr.cycles / 4) - fetches) << instr.mnemonic;
+            EXPECT_EQ(program.operands, (fetches == 1) ? instr.length - 1 : 0) << instr.mnemonic;
+        }
+    }
+}
+
+TEST_F(MicrocodeTest, PushWritesOnTheirMCycles)
+{
+    cpu->set_register(Reg16Name::BC, 0x1234);
+    set_next_instruction(Opcode::PUSH_BC);
+
+    // Fetch and internal M-cycles
+    tick(2);
+    EXPECT_EQ(mmu->read_byte(Stack - 1), 0x00);
+
+    tick();
+    EXPECT_EQ(mmu->read_byte(Stack - 1), 0x12);
+    EXPECT_EQ(mmu->read_byte(Stack - 2), 0x00);
+
+    tick();
+    EXPECT_EQ(mmu->read_byte(Stack - 2), 0x34);
+    EXPECT_EQ(cpu->get_sp(), Stack - 2);
+}
+
+TEST_F(MicrocodeTest, RetReadsOnTheirMCycles)
+{
+    cpu->set_sp(Stack - 2);
+    mmu->write_byte(Stack - 2, 0x00);
+    mmu->write_byte(Stack - 1, 0xC1);
+    set_next_instruction(Opcode::RET);
+
+    // The low byte is read on the 2nd M-cycle, the high byte on the 3rd
+    tick(2);
+    mmu->write_byte(Stack - 2, 0x11);
+    mmu->write_byte(Stack - 1, 0xC2);
+
+    tick(2);
+    EXPECT_EQ(cpu->get_pc(), 0xC200);
+    EXPECT_EQ(cpu->get_sp(), Stack);
+}
+
+TEST_F(MicrocodeTest, ReadModifyWrite)
+{
+    mmu->write_byte(Data, 0x41);
+    cpu->set_register(Reg16Name::HL, Data);
+    set_next_instruction(Opcode::INC_AT_HL);
+
+    tick(2);
+    EXPECT_EQ(mmu->read_byte(Data), 0x41);
+
+    tick();
+    EXPECT_EQ(mmu->read_byte(Data), 0x42);
+}
+
+TEST_F(MicrocodeTest, TakenCallWritesAfterTheBranch)
+{
+    set_next_bytes({std::to_underlying(Opcode::CALL_NZ_A16), 0x00, 0xC2});
+
+    tick(5);
+    EXPECT_EQ(mmu->read_byte(Stack - 1), 0xC0);
+    EXPECT_EQ(mmu->read_byte(Stack - 2), 0x00);
+
+    tick();
+    EXPECT_EQ(mmu->read_byte(Stack - 2), 0x03);
+    EXPECT_EQ(cpu->get_pc(), 0xC200);
+    EXPECT_EQ(cpu->get_sp(), Stack - 2);
+}
+
+TEST_F(MicrocodeTest, NotTakenCall)
+{
+    set_flags(true, false, false, false);
+    set_next_bytes(
+        {std::to_underlying(Opcode::CALL_NZ_A16), 0x00, 0xC2, std::to_underlying(Opcode::NOP)}
+    );
+
+    tick(3);
+    EXPECT_EQ(cpu->get_pc(), boyboy::core::mmu::WRAM0Start + 3);
+    EXPECT_EQ(cpu->get_sp(), Stack);
+}
+
+TEST_F(MicrocodeTest, TCycleMode)
+{
+    cpu->set_tick_mode(TickMode::TCycle);
+    cpu->set_register(Reg16Name::BC, 0x1234);
+    set_next_instruction(Opcode::PUSH_BC);
+
+    tick(to_tcycles(3) - 1);
+    EXPECT_EQ(mmu->read_byte(Stack - 1), 0x00);
+
+    tick();
+    EXPECT_EQ(mmu->read_byte(Stack - 1), 0x12);
+    EXPECT_EQ(mmu->read_byte(Stack - 2), 0x00);
+
+    tick(to_tcycles(1));
+    EXPECT_EQ(mmu->read_byte(Stack - 2), 0x34);
+}
+
+struct MicrocodeConfig {
+    std::string name;
+    TickMode tick_mode;
+
+    // For pretty printing in test names
+    friend std::ostream& operator<<(std::ostream& os, const MicrocodeConfig& c)
+    {
+        os << c.name << " [TickMode=" << to_string(c.tick_mode) << "]";
+        return os;
+    }
+};
+
+class MicrocodeROMTest : public ConfigROMTest<MicrocodeConfig> {
+protected:
+    void SetUp() override
+    {
+        ROMTest::SetUp();
+        cpu->set_tick_mode(config().tick_mode);
+        cpu->enable_microcode(true);
+    }
+};
+
+TEST_P(MicrocodeROMTest, Passes)
+{
+    load(rom());
+    ASSERT_TRUE(cpu->is_microcode_enabled());
+    run();
+}
+
+const std::array<MicrocodeConfig, 2> MicrocodeConfigs = {{
+    {.name = "MCycle", .tick_mode = TickMode::MCycle},
+    {.name = "TCycle", .tick_mode = TickMode::TCycle},
+}};
+
+INSTANTIATE_TEST_SUITE_P(
+    Microcode,
+    MicrocodeROMTest,
+    ::testing::Combine(::testing::ValuesIn(MicrocodeConfigs), ::testing::ValuesIn(CpuTestRoms)),
+    MicrocodeROMTest::param_name
+);
@@ -23,20 +23,23 @@ class Register16Test : public ::testing::TestWithParam<Reg16TestParam> {};
 TEST_P(Register16Test, HighLowAccess)
 {
     Reg16TestParam p = GetParam();
-    Register16 reg(p.val);
+    Registers regs;
+    regs.bc(p.val);
 
-    EXPECT_EQ(reg.high(), p.high);
-    EXPECT_EQ(reg.low(), p.low);
+    EXPECT_EQ(regs.b(), p.high);
+    EXPECT_EQ(regs.c(), p.low);
 
     // Modify high
     auto new_high = static_cast<uint8_t>(p.high + 1); // wrap if overflow
-    reg.high(new_high);
-    EXPECT_EQ(reg.high(), new_high);
+    regs.b(new_high);
+    EXPECT_EQ(regs.b(), new_high);
+    EXPECT_EQ(regs.bc() >> 8, new_high);
 
     // Modify low
     auto new_low = static_cast<uint8_t>(p.low + 1); // wrap if overflow
-    reg.low(new_low);
-    EXPECT_EQ(reg.low(), new_low);
+    regs.c(new_low);
+    EXPECT_EQ(regs.c(), new_low);
+    EXPECT_EQ(regs.bc() & 0xFF, new_low);
 }
 
 INSTANTIATE_TEST_SUITE_P(
@@ -50,30 +53,67 @@ INSTANTIATE_TEST_SUITE_P(
     )
 );
 
-// ===== Prefix and postfix 16-bit register operations test =====
-TEST(Register16Test, PrefixPostfixOperations)
+// ===== Flat register file layout =====
+TEST(RegisterFileTest, IndexedAccess)
+{
+    // Pairs are stored low byte first
+    static_assert(Registers::index(Reg16Name::AF) == Registers::index(Reg8Name::F));
+    static_assert(Registers::index(Reg16Name::BC) == Registers::index(Reg8Name::C));
+    static_assert(Registers::index(Reg16Name::DE) == Registers::index(Reg8Name::E));
+    static_assert(Registers::index(Reg16Name::HL) == Registers::index(Reg8Name::L));
+    static_assert(Registers::index(Reg8Name::A) == Registers::index(Reg8Name::F) + 1);
+    static_assert(Registers::index(Reg8Name::H) == Registers::index(Reg8Name::L) + 1);
+
+    Registers regs;
+    regs.set(Reg16Name::DE, 0x1234);
+    EXPECT_EQ(regs.bytes.at(Registers::index(Reg8Name::D)), 0x12);
+    EXPECT_EQ(regs.bytes.at(Registers::index(Reg8Name::E)), 0x34);
+    EXPECT_EQ(regs.get(Reg8Name::D), 0x12);
+    EXPECT_EQ(regs.get<Reg8Name::E>(), 0x34);
+
+    regs.set(Reg8Name::H, 0xAB);
+    regs.set<Reg8Name::L>(0xCD);
+    EXPECT_EQ(regs.get(Reg16Name::HL), 0xABCD);
+    EXPECT_EQ(regs.hl(), 0xABCD);
+
+    regs.set<Reg16Name::SP>(0xFFFE);
+    regs.set(Reg16Name::PC, 0x0100);
+    EXPECT_EQ(regs.sp(), 0xFFFE);
+    EXPECT_EQ(regs.get<Reg16Name::PC>(), 0x0100);
+
+    // Registers are plain values
+    Registers copy = regs;
+    EXPECT_EQ(copy.bytes, regs.bytes);
+}
+
+TEST(RegisterFileTest, FlagsMasked)
+{
+    Registers regs;
+
+    regs.set(Reg8Name::F, 0xFF);
+    EXPECT_EQ(regs.f(), 0xF0);
+
+    regs.set<Reg8Name::F>(0x3C);
+    EXPECT_EQ(regs.f(), 0x30);
+
+    regs.set(Reg16Name::AF, 0x12FF);
+    EXPECT_EQ(regs.a(), 0x12);
+    EXPECT_EQ(regs.af(), 0x12F0);
+
+    regs.af(0x345A);
+    EXPECT_EQ(regs.get(Reg16Name::AF), 0x3450);
+}
+
+TEST(RegisterFileTest, AdvancePc)
 {
-    Register16 reg(0x0000);
-
-    // Postfix increment
-    Register16 old = reg++;
-    EXPECT_EQ(old, 0x0000);
-    EXPECT_EQ(reg, 0x0001);
-
-    // Postfix decrement
-    old = reg--;
-    EXPECT_EQ(old, 0x0001);
-    EXPECT_EQ(reg, 0x0000);
-
-    // Prefix increment
-    Register16& new_ref = ++reg;
-    EXPECT_EQ(reg, 0x0001);
-    EXPECT_EQ(&new_ref, &reg); // same object
-
-    // Prefix decrement
-    new_ref = --reg;
-    EXPECT_EQ(reg, 0x0000);
-    EXPECT_EQ(&new_ref, &reg); // same object
+    Registers regs;
+    regs.pc(0xFFFF);
+
+    EXPECT_EQ(regs.advance_pc(), 0xFFFF);
+    EXPECT_EQ(regs.pc(), 0x0000); // wraps around
+
+    EXPECT_EQ(regs.advance_pc(2), 0x0000);
+    EXPECT_EQ(regs.pc(), 0x0002);
 }
 
 // ===== Parameterized test for AF register with flag handling =====
@@ -82,51 +122,22 @@ class AFRegisterFlagTest : public ::testing::TestWithParam<uint8_t> {};
 TEST_P(AFRegisterFlagTest, FlagSetAndClear)
 {
     uint8_t flag = GetParam();
-    AFRegister af;
+    Registers regs;
 
     // Initially cleared
-    af.low(0);
-    EXPECT_FALSE((af.low() & flag));
+    regs.f(0);
+    EXPECT_FALSE(regs.flag(flag));
 
     // Set flag
-    switch (flag) {
-        case Flag::Zero:
-            af.zero_flag(true);
-            break;
-        case Flag::Carry:
-            af.carry_flag(true);
-            break;
-        case Flag::Substract:
-            af.substract_flag(true);
-            break;
-        case Flag::HalfCarry:
-            af.half_carry_flag(true);
-            break;
-        default:
-            FAIL() << "Unknown flag";
-    }
-
-    EXPECT_TRUE((af.low() & flag));
+    regs.flag(flag, true);
+    EXPECT_TRUE(regs.flag(flag));
+    EXPECT_TRUE((regs.f() & flag));
+    EXPECT_EQ(regs.f(), flag); // other flags untouched
 
     // Clear flag
-    switch (flag) {
-        case Flag::Zero:
-            af.zero_flag(false);
-            break;
-        case Flag::Carry:
-            af.carry_flag(false);
-            break;
-        case Flag::Substract:
-            af.substract_flag(false);
-            break;
-        case Flag::HalfCarry:
-            af.half_carry_flag(false);
-            break;
-        default:
-            FAIL() << "Unknown flag";
-    }
-
-    EXPECT_FALSE((af.low() & flag));
+    regs.flag(flag, false);
+    EXPECT_FALSE(regs.flag(flag));
+    EXPECT_EQ(regs.f(), 0);
 }
 
 static std::string FlagNameGenerator(const ::testing::TestParamInfo<uint8_t>& info) // NOLINT
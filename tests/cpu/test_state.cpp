@@ -19,6 +19,7 @@
 #include "boyboy/core/cpu/instructions_table.h"
 #include "boyboy/core/cpu/interrupts.h"
 #include "boyboy/core/cpu/opcodes.h"
+#include "boyboy/core/cpu/registers.h"
 #include "boyboy/core/cpu/state.h"
 
 using boyboy::test::cpu::CpuTest;
@@ -209,4 +210,54 @@ TEST_F(CpuExecutionState, InterruptService)
 
     // Total cycles ticked
     EXPECT_EQ(cpu->get_cycles(), FetchCycles + InterruptServiceCycles + instr.cycles);
-}
\ No newline at end of file
+}
+
+TEST_F(CpuExecutionState, SpecializedTick)
+{
+    const auto& nop_instr = InstructionTable::get_instruction(Opcode::NOP);
+    const auto& inc_instr = InstructionTable::get_instruction(Opcode::INC_A);
+
+    set_next_bytes({std::to_underlying(Opcode::NOP), std::to_underlying(Opcode::INC_A)});
+    cpu->set_register(Reg8Name::A, 0x00);
+
+    // Same stages as tick() with fetch/execute overlap, without checking the configuration
+    const auto& state = cpu->get_execution_state();
+    for (int i = 0; i < FetchCycles + nop_instr.cycles; ++i) {
+        EXPECT_EQ((cpu->tick<TickMode::TCycle, true>()), 1);
+    }
+    EXPECT_EQ(state.stage, Stage::Execute);
+    EXPECT_EQ(state.fetched, std::to_underlying(Opcode::INC_A));
+
+    for (int i = 0; i < inc_instr.cycles; ++i) {
+        cpu->tick<TickMode::TCycle, true>();
+    }
+    EXPECT_EQ(cpu->get_register(Reg8Name::A), 0x01);
+    EXPECT_EQ(cpu->get_cycles(), FetchCycles + nop_instr.cycles + inc_instr.cycles);
+}
+
+TEST_F(CpuExecutionState, SnapshotRestore)
+{
+    cpu->set_tick_mode(TickMode::Instruction);
+    cpu->set_register(Reg16Name::BC, 0x1234);
+    cpu->set_flag(Flag::Carry, true);
+
+    auto start = cpu->get_pc();
+    set_next_bytes({std::to_underlying(Opcode::INC_B), std::to_underlying(Opcode::INC_B)});
+    auto state = cpu->snapshot();
+
+    cpu->tick();
+    cpu->tick();
+    EXPECT_EQ(cpu->get_register(Reg8Name::B), 0x14);
+    EXPECT_EQ(cpu->get_pc(), start + 2);
+
+    cpu->restore(state);
+    EXPECT_EQ(cpu->get_register(Reg16Name::BC), 0x1234);
+    EXPECT_EQ(cpu->get_pc(), start);
+    EXPECT_EQ(cpu->get_cycles(), state.cycles);
+    EXPECT_TRUE(cpu->get_flag(Flag::Carry));
+
+    // Same instructions run again from the restored state
+    cpu->tick();
+    EXPECT_EQ(cpu->get_register(Reg8Name::B), 0x13);
+    EXPECT_EQ(cpu->get_pc(), start + 1);
+}
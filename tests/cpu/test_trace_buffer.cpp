@@ -0,0 +1,197 @@
+/**
+ * @file test_trace_buffer.cpp
+ * @brief Tests for the CPU trace ring buffer.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+// helpers
+#include "helpers/cpu_fixtures.h"
+
+// boyboy
+#include "boyboy/common/files/io.h"
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/opcodes.h"
+#include "boyboy/core/cpu/registers.h"
+#include "boyboy/core/cpu/trace_buffer.h"
+#include "boyboy/core/mmu/constants.h"
+
+using boyboy::test::cpu::CpuTest;
+
+using namespace boyboy::core::cpu;
+
+namespace {
+
+TraceRecord make_record(uint16_t pc)
+{
+    return TraceRecord{.cycles = pc, .pc = pc};
+}
+
+} // namespace
+
+class TraceBufferTest : public ::testing::Test {
+protected:
+    inline static const std::filesystem::path TraceFile =
+        std::filesystem::temp_directory_path() / "boyboy_test_trace.bbt";
+
+    void TearDown() override { std::filesystem::remove(TraceFile); }
+};
+
+TEST_F(TraceBufferTest, CapacityRoundedToPowerOfTwo)
+{
+    EXPECT_EQ(TraceBuffer(1).capacity(), 1);
+    EXPECT_EQ(TraceBuffer(5).capacity(), 8);
+    EXPECT_EQ(TraceBuffer(64).capacity(), 64);
+    EXPECT_EQ(TraceBuffer().capacity(), TraceBuffer::DefaultCapacity);
+}
+
+TEST_F(TraceBufferTest, Wraparound)
+{
+    TraceBuffer buffer(4);
+    buffer.enable(true);
+    EXPECT_EQ(buffer.size(), 0);
+
+    for (uint16_t pc = 0; pc < 3; ++pc) {
+        buffer.push(make_record(pc));
+    }
+    EXPECT_EQ(buffer.size(), 3);
+
+    for (uint16_t pc = 3; pc < 10; ++pc) {
+        buffer.push(make_record(pc));
+    }
+    EXPECT_EQ(buffer.size(), 4);
+
+    // Oldest first
+    auto records = buffer.snapshot();
+    ASSERT_EQ(records.size(), 4);
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(records[i].pc, 6 + i);
+    }
+
+    buffer.clear();
+    EXPECT_EQ(buffer.size(), 0);
+    EXPECT_TRUE(buffer.snapshot().empty());
+}
+
+TEST_F(TraceBufferTest, FlushAndLoad)
+{
+    TraceBuffer buffer(4);
+    buffer.enable(true);
+    for (uint16_t pc = 0; pc < 6; ++pc) {
+        buffer.push(make_record(pc));
+    }
+
+    ASSERT_TRUE(buffer.flush(TraceFile).has_value());
+
+    auto records = TraceBuffer::load(TraceFile);
+    ASSERT_TRUE(records.has_value());
+    ASSERT_EQ(records->size(), 4);
+    for (size_t i = 0; i < records->size(); ++i) {
+        EXPECT_EQ((*records)[i].pc, 2 + i);
+        EXPECT_EQ((*records)[i].cycles, 2 + i);
+    }
+}
+
+TEST_F(TraceBufferTest, FlushEmpty)
+{
+    TraceBuffer buffer(4);
+
+    ASSERT_TRUE(buffer.flush(TraceFile).has_value());
+
+    auto records = TraceBuffer::load(TraceFile);
+    ASSERT_TRUE(records.has_value());
+    EXPECT_TRUE(records->empty());
+}
+
+TEST_F(TraceBufferTest, LoadInvalid)
+{
+    using boyboy::common::files::write_text;
+
+    EXPECT_FALSE(TraceBuffer::load(TraceFile).has_value()); // missing
+
+    ASSERT_TRUE(write_text(TraceFile, "A:01 F:B0 B:00 C:13").has_value());
+    EXPECT_FALSE(TraceBuffer::load(TraceFile).has_value()); // not a trace file
+
+    TraceBuffer buffer(4);
+    buffer.enable(true);
+    buffer.push(make_record(0x0100));
+    ASSERT_TRUE(buffer.flush(TraceFile).has_value());
+    std::filesystem::resize_file(TraceFile, std::filesystem::file_size(TraceFile) - 1);
+    EXPECT_FALSE(TraceBuffer::load(TraceFile).has_value()); // truncated
+}
+
+TEST_F(TraceBufferTest, DoctorFormat)
+{
+    TraceRecord record{
+        .pc = 0x0100,
+        .sp = 0xFFFE,
+        .af = 0x01B0,
+        .bc = 0x0013,
+        .de = 0x00D8,
+        .hl = 0x014D,
+        .mem = {0x00, 0xC3, 0x13, 0x02},
+    };
+
+    EXPECT_EQ(
+        TraceBuffer::to_doctor(record),
+        "A:01 F:B0 B:00 C:13 D:00 E:D8 H:01 L:4D SP:FFFE PC:0100 PCMEM:00,C3,13,02"
+    );
+}
+
+class CpuTraceTest : public CpuTest {
+protected:
+    static constexpr uint16_t Start = boyboy::core::mmu::WRAM0Start;
+
+    void SetUp() override
+    {
+        CpuTest::SetUp();
+        cpu->set_tick_mode(TickMode::Instruction);
+    }
+};
+
+TEST_F(CpuTraceTest, Disabled)
+{
+    set_next_instruction(Opcode::NOP);
+    cpu->tick();
+
+    EXPECT_FALSE(cpu->is_trace_enabled());
+    EXPECT_EQ(cpu->get_trace_buffer().size(), 0);
+}
+
+TEST_F(CpuTraceTest, RecordsInstructions)
+{
+    cpu->enable_trace(true);
+
+    // NOP; LD B, 0x42; NOP
+    set_next_bytes({
+        std::to_underlying(Opcode::NOP),
+        std::to_underlying(Opcode::LD_B_N8),
+        0x42,
+        std::to_underlying(Opcode::NOP),
+    });
+    cpu->tick();
+    cpu->tick();
+    cpu->tick();
+
+    auto records = cpu->get_trace_buffer().snapshot();
+    ASSERT_EQ(records.size(), 3);
+
+    EXPECT_EQ(records[0].pc, Start);
+    EXPECT_EQ(records[1].pc, Start + 1);
+    EXPECT_EQ(records[2].pc, Start + 3);
+
+    EXPECT_EQ(records[1].mem[0], std::to_underlying(Opcode::LD_B_N8));
+    EXPECT_EQ(records[1].mem[1], 0x42);
+    EXPECT_EQ(records[2].bc >> 8, 0x42);
+    EXPECT_LT(records[0].cycles, records[1].cycles);
+    EXPECT_LT(records[1].cycles, records[2].cycles);
+}
@@ -0,0 +1,111 @@
+/**
+ * @file test_emulator.cpp
+ * @brief Tests for the emulator watchpoint breaks and pause control.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// helpers
+#include "common/paths.h"
+#include "common/roms.h"
+
+// boyboy
+#include "boyboy/common/config/config.h"
+#include "boyboy/common/config/config_limits.h"
+#include "boyboy/core/emulator/emulator.h"
+#include "boyboy/core/mmu/constants.h"
+#include "boyboy/core/mmu/watchpoints.h"
+
+using namespace boyboy::test::common;
+
+using boyboy::core::emulator::Emulator;
+using boyboy::core::mmu::WatchHit;
+using boyboy::core::mmu::WatchKind;
+using boyboy::core::mmu::WRAM0Start;
+
+class EmulatorWatchTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        emulator = std::make_unique<Emulator>();
+        emulator->init();
+
+        // One instruction per CPU tick
+        boyboy::common::config::Config config;
+        config.emulator.tick_mode =
+            std::string(boyboy::common::config::ConfigLimits::Emulator::FastMode);
+        emulator->apply_config(config);
+
+        // The ROM starts by copying its code from 0x4000 to WRAM with LD [DE], A; INC E; JR NZ
+        emulator->load(local_file("../" + CpuTest06Rom, __FILE__));
+    }
+
+    std::unique_ptr<Emulator> emulator;
+};
+
+TEST_F(EmulatorWatchTest, RunUntilWatch)
+{
+    auto id = emulator->add_watchpoint(WRAM0Start, WRAM0Start + 0x0F, WatchKind::Write);
+
+    auto hit = emulator->run_until_watch(1);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->id, id);
+    EXPECT_EQ(hit->addr, WRAM0Start);
+    EXPECT_EQ(hit->value, 0xC3);
+    EXPECT_TRUE(emulator->is_paused());
+
+    // Resuming carries on from the break, up to the next write
+    hit = emulator->run_until_watch(1);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->addr, WRAM0Start + 1);
+    EXPECT_EQ(hit->value, 0x20);
+
+    // Without watchpoints the frames run to the end
+    EXPECT_TRUE(emulator->remove_watchpoint(id));
+    EXPECT_FALSE(emulator->run_until_watch(2).has_value());
+    EXPECT_FALSE(emulator->is_paused());
+}
+
+TEST_F(EmulatorWatchTest, Step)
+{
+    emulator->add_watchpoint(WRAM0Start, WRAM0Start + 0x0F, WatchKind::Write);
+    ASSERT_TRUE(emulator->run_until_watch(1).has_value());
+
+    // INC E; JR NZ; LD A, [HL+]; LD [DE], A
+    for (int i = 0; i < 3; ++i) {
+        emulator->step();
+        EXPECT_FALSE(emulator->watch_hit().has_value());
+        EXPECT_TRUE(emulator->is_paused());
+    }
+    emulator->step();
+    ASSERT_TRUE(emulator->watch_hit().has_value());
+    EXPECT_EQ(emulator->watch_hit()->addr, WRAM0Start + 1);
+    EXPECT_TRUE(emulator->is_paused());
+
+    emulator->resume();
+    EXPECT_FALSE(emulator->watch_hit().has_value());
+    EXPECT_FALSE(emulator->is_paused());
+}
+
+TEST_F(EmulatorWatchTest, Callback)
+{
+    // The callback sees every hit and only breaks on the last one
+    std::vector<uint16_t> hits;
+    emulator->set_watch_callback([&hits](const WatchHit& hit) {
+        hits.push_back(hit.addr);
+        return hit.addr == WRAM0Start + 0x03;
+    });
+    emulator->add_watchpoint(WRAM0Start, WRAM0Start + 0x0F, WatchKind::Write);
+
+    auto hit = emulator->run_until_watch(1);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->addr, WRAM0Start + 0x03);
+    EXPECT_EQ(hits, (std::vector<uint16_t>{0xC000, 0xC001, 0xC002, 0xC003}));
+}
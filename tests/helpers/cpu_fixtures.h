@@ -64,7 +64,7 @@ struct CpuTest : public ::testing::Test {
      */
     void step() const
     {
-        if (cpu->get_tick_mode() == core::cpu::TickMode::Instruction) {
+        if (core::cpu::is_instruction_stepped(cpu->get_tick_mode())) {
             cpu->tick();
             return;
         }
@@ -106,7 +106,7 @@ struct CpuTest : public ::testing::Test {
 
     void service_interrupts() const
     {
-        if (cpu->get_tick_mode() == boyboy::core::cpu::TickMode::Instruction) {
+        if (boyboy::core::cpu::is_instruction_stepped(cpu->get_tick_mode())) {
             cpu->get_interrupt_handler().service();
             return;
         }
@@ -7,7 +7,10 @@
 
 #include "helpers/rom_fixtures.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cstddef>
+#include <filesystem>
 #include <memory>
 #include <stdexcept>
 
@@ -87,9 +90,12 @@ void ROMTest::SetUp()
         serial_new_line(new_line);
     });
 
-    mmu->set_io_write_callback([this](uint16_t addr, uint8_t value) {
-        serial_capturer.write_hook(addr, value);
-    });
+    mmu->set_io_write_callback(
+        [](void* context, uint16_t addr, uint8_t value) {
+            static_cast<ROMTest*>(context)->serial_capturer.write_hook(addr, value);
+        },
+        this
+    );
 }
 
 void ROMTest::TearDown()
@@ -168,6 +174,13 @@ void ROMTest::run()
                         << serial_output;
 }
 
+std::string rom_param_name(const std::string& path)
+{
+    auto name = std::filesystem::path(path).stem().string();
+    std::ranges::replace_if(name, [](unsigned char c) { return std::isalnum(c) == 0; }, '_');
+    return name;
+}
+
 void ROMTest::serial_new_line(const std::string& line)
 {
     if (line.empty() || line == "\n") {
@@ -12,6 +12,8 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <tuple>
 #include <vector>
 
 #include "helpers/cpu_fixtures.h"
@@ -65,6 +67,30 @@ protected:
     void serial_new_line(const std::string& line);
 };
 
+// Test name suffix for a ROM path: its file name without extension, alphanumeric
+std::string rom_param_name(const std::string& path);
+
+/**
+ * @brief ROM test fixture parameterized on a CPU configuration and the ROM to run.
+ *
+ * @tparam Config Configuration type, with a name used in the test names.
+ */
+template <typename Config>
+class ConfigROMTest : public ROMTest,
+                      public ::testing::WithParamInterface<std::tuple<Config, std::string>> {
+public:
+    using ParamType = std::tuple<Config, std::string>;
+
+    static std::string param_name(const ::testing::TestParamInfo<ParamType>& info)
+    {
+        return std::get<0>(info.param).name + "_" + rom_param_name(std::get<1>(info.param));
+    }
+
+protected:
+    [[nodiscard]] const Config& config() const { return std::get<0>(this->GetParam()); }
+    [[nodiscard]] const std::string& rom() const { return std::get<1>(this->GetParam()); }
+};
+
 struct MBCParam {
     core::cartridge::CartridgeType type;
     uint16_t rom_banks;
@@ -530,4 +530,33 @@ TEST_F(IoTimerTest, TimaIncWithTimerDisable)
         EXPECT_EQ(read_tima(), 1) << "TIMA should be incremented after disable for " << cycles
                                   << " cycles with clock " << clk;
     }
-}
\ No newline at end of file
+}
+// Next event is the TIMA overflow, as long as the timer is enabled
+TEST_F(IoTimerTest, CyclesToEvent)
+{
+    EXPECT_EQ(timer_->cycles_to_event(), Timer::NoEvent);
+
+    for (auto clk = 0; clk <= Timer::Flags::ClockSelectMask; ++clk) {
+        write_tac(Timer::Flags::TimerEnable | clk);
+        reset_div();
+        write_tima(0xFC);
+
+        // Start out of phase with the TIMA increments
+        timer_->tick(12);
+
+        auto cycles = timer_->cycles_to_event();
+        ASSERT_NE(cycles, Timer::NoEvent);
+        timer_->tick(static_cast<uint16_t>(cycles - 1));
+        EXPECT_EQ(read_tima(), 0xFF) << "Clock " << clk;
+
+        timer_->tick(1);
+        EXPECT_EQ(read_tima(), 0x00) << "Clock " << clk;
+        EXPECT_EQ(timer_->cycles_to_event(), 0) << "Clock " << clk;
+
+        // Let the overflow complete
+        timer_->tick(2 * Timer::TimaDelayCycles);
+    }
+
+    timer_->stop();
+    EXPECT_EQ(timer_->cycles_to_event(), Timer::NoEvent);
+}
@@ -7,9 +7,19 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <tuple>
+#include <vector>
 
+// helpers
+#include "helpers/rom_fixtures.h"
+
+// boyboy
 #include "boyboy/common/utils.h"
+#include "boyboy/core/cartridge/cartridge.h"
+#include "boyboy/core/cartridge/cartridge_loader.h"
 #include "boyboy/core/io/io.h"
 #include "boyboy/core/mmu/constants.h"
 #include "boyboy/core/mmu/mmu.h"
@@ -30,6 +40,11 @@ protected:
     std::unique_ptr<Mmu> mmu;
 };
 
+// Exposes the fake ROM builder to build banked cartridges
+struct FakeRom : public boyboy::test::rom::FakeROMTest {
+    using FakeROMTest::make_fake_rom;
+};
+
 TEST_F(MmuTest, ReadWriteByte)
 {
     uint16_t address = VRAMStart;
@@ -133,6 +148,8 @@ TEST_F(MmuTest, MemoryRegionsRW)
     mmu->write_byte(WRAM0Start, 0xFF);
     EXPECT_EQ(mmu->read_byte(WRAM0Start), 0xFF) << "WRAM0 should be writable";
     EXPECT_EQ(mmu->read_byte(ECHOStart), 0xFF) << "WRAM0 should mirror ECHO";
+    mmu->write_byte(ECHOEnd, 0xE1);
+    EXPECT_EQ(mmu->read_byte(WRAM0Start + ECHOSize - 1), 0xE1) << "ECHO end should mirror WRAM1";
 
     // OAM
     mmu->write_byte(OAMStart, 0x11);
@@ -209,4 +226,183 @@ TEST_F(MmuTest, RegionLock)
     mmu->write_byte(OAMStart, TestByte);
     EXPECT_EQ(mmu->read_byte(VRAMStart), TestByte);
     EXPECT_EQ(mmu->read_byte(OAMStart), TestByte);
-}
\ No newline at end of file
+}
+
+TEST_F(MmuTest, FetchPage)
+{
+    using boyboy::core::cartridge::CartridgeLoader;
+    using boyboy::core::cartridge::CartridgeType;
+
+    // WRAM pages are read directly, writes are seen through them
+    const auto* wram = mmu->fetch_page(WRAM1Start + 0x0142);
+    ASSERT_NE(wram, nullptr);
+    mmu->write_byte(WRAM1Start + 0x0142, 0xAB);
+    EXPECT_EQ(wram[0x42], 0xAB);
+
+    // Regions with side effects, locks or mirroring aren't
+    EXPECT_EQ(mmu->fetch_page(ROMBank0Start), nullptr); // no cartridge
+    EXPECT_EQ(mmu->fetch_page(VRAMStart), nullptr);
+    EXPECT_EQ(mmu->fetch_page(SRAMStart), nullptr);
+    EXPECT_EQ(mmu->fetch_page(ECHOStart), nullptr);
+    EXPECT_EQ(mmu->fetch_page(OAMStart), nullptr);
+    EXPECT_EQ(mmu->fetch_page(HRAMStart), nullptr);
+
+    // Every byte of a fake ROM bank is its bank index
+    auto cart = CartridgeLoader::load(FakeRom::make_fake_rom(CartridgeType::MBC1, 4, 0));
+    mmu->map_rom(*cart);
+
+    const auto* bank1 = mmu->fetch_page(ROMBank1Start + 0x0210);
+    ASSERT_NE(bank1, nullptr);
+    EXPECT_EQ(bank1[0x10], 0x01);
+
+    // Bank switches invalidate the pages
+    auto generation = mmu->map_generation();
+    mmu->write_byte(0x2000, 0x02);
+    EXPECT_NE(mmu->map_generation(), generation);
+
+    const auto* bank2 = mmu->fetch_page(ROMBank1Start + 0x0210);
+    ASSERT_NE(bank2, nullptr);
+    EXPECT_EQ(bank2[0x10], 0x02);
+    EXPECT_EQ(mmu->read_byte(ROMBank1Start + 0x0210), 0x02);
+
+    // Resetting unmaps the ROM
+    generation = mmu->map_generation();
+    mmu->reset();
+    EXPECT_NE(mmu->map_generation(), generation);
+    EXPECT_EQ(mmu->fetch_page(ROMBank1Start), nullptr);
+}
+
+TEST_F(MmuTest, PageTable)
+{
+    using boyboy::core::cartridge::CartridgeLoader;
+    using boyboy::core::cartridge::CartridgeType;
+
+    // Writes to watched code pages, directly or through ECHO, still notify
+    std::vector<uint16_t> code_writes;
+    mmu->set_code_write_callback([&](uint16_t addr) { code_writes.push_back(addr); });
+    mmu->write_byte(WRAM0Start, 0x01);
+    mmu->watch_code_page(WRAM0Start >> 8, true);
+    mmu->write_byte(WRAM0Start + 1, 0x02);
+    mmu->write_byte(ECHOStart + 2, 0x03);
+    mmu->watch_code_page(WRAM0Start >> 8, false);
+    mmu->write_byte(WRAM0Start + 3, 0x04);
+
+    ASSERT_EQ(code_writes.size(), 2);
+    EXPECT_EQ(code_writes[0], WRAM0Start + 1);
+    EXPECT_EQ(code_writes[1], WRAM0Start + 2);
+    EXPECT_EQ(mmu->read_byte(WRAM0Start + 2), 0x03);
+    EXPECT_EQ(mmu->read_byte(WRAM0Start + 3), 0x04);
+
+    // HRAM code is tracked too, the I/O registers sharing its page aren't code
+    code_writes.clear();
+    mmu->watch_code_page(HRAMStart >> 8, true);
+    mmu->write_byte(HRAMStart, 0x05);
+    mmu->write_byte(IOStart + 0x01, 0x06); // SB
+    mmu->watch_code_page(HRAMStart >> 8, false);
+
+    ASSERT_EQ(code_writes.size(), 1);
+    EXPECT_EQ(code_writes[0], HRAMStart);
+    EXPECT_EQ(mmu->read_byte(HRAMStart), 0x05);
+
+    // VRAM pages follow the lock transitions
+    mmu->write_byte(VRAMEnd, 0x5A);
+    mmu->lock_vram(true);
+    EXPECT_EQ(mmu->cpu_read(VRAMEnd), OpenBusValue);
+    EXPECT_EQ(mmu->ppu_read(VRAMEnd), 0x5A);
+    mmu->lock_vram(false);
+    EXPECT_EQ(mmu->cpu_read(VRAMEnd), 0x5A);
+
+    // SRAM pages follow the RAM enable and bank registers
+    auto cart = CartridgeLoader::load(FakeRom::make_fake_rom(CartridgeType::MBC1RAM, 4, 4));
+    mmu->map_rom(*cart);
+    mmu->write_byte(0x0000, 0x0A); // enable RAM
+    mmu->write_byte(SRAMStart + 0x0110, 0x33);
+    EXPECT_EQ(mmu->read_byte(SRAMStart + 0x0110), 0x33);
+
+    mmu->write_byte(0x6000, 0x01); // RAM banking mode
+    mmu->write_byte(0x4000, 0x01); // RAM bank 1
+    EXPECT_EQ(mmu->read_byte(SRAMStart + 0x0110), 0x00);
+    mmu->write_byte(0x4000, 0x00);
+    EXPECT_EQ(mmu->read_byte(SRAMStart + 0x0110), 0x33);
+
+    mmu->write_byte(0x0000, 0x00); // disable RAM
+    EXPECT_EQ(mmu->read_byte(SRAMStart + 0x0110), OpenBusValue);
+}
+
+TEST_F(MmuTest, Dma)
+{
+    for (uint16_t i = 0; i < DMATransferSize; ++i) {
+        mmu->write_byte(WRAM0Start + i, static_cast<uint8_t>(i + 1));
+    }
+
+    mmu->start_dma(WRAM0Start >> 8);
+    EXPECT_TRUE(mmu->is_dma_active());
+
+    // OAM belongs to the transfer: CPU reads are OpenBus and writes are ignored
+    mmu->write_byte(OAMStart, 0xAA);
+    EXPECT_EQ(mmu->cpu_read(OAMStart), OpenBusValue);
+
+    // The PPU sees the bytes copied so far
+    mmu->tick_dma(4 * 10);
+    EXPECT_EQ(mmu->ppu_read(OAMStart + 9), 10);
+    EXPECT_EQ(mmu->ppu_read(OAMStart + 10), 0x00);
+
+    // Bytes already transferred keep their value, source changes are seen by the others
+    mmu->tick_dma(4 * 20);
+    mmu->write_byte(WRAM0Start + 5, 0x55);
+    mmu->write_byte(WRAM0Start + 25, 0x55);
+    mmu->write_byte(ECHOStart + 27, 0x55);
+    mmu->write_byte(WRAM0Start + 40, 0x66);
+
+    mmu->tick_dma(DMATransferCycles - (4 * 30) - 1);
+    EXPECT_TRUE(mmu->is_dma_active());
+    mmu->tick_dma(4);
+    EXPECT_FALSE(mmu->is_dma_active());
+
+    EXPECT_EQ(mmu->cpu_read(OAMStart), 1);
+    EXPECT_EQ(mmu->cpu_read(OAMStart + 5), 6);
+    EXPECT_EQ(mmu->cpu_read(OAMStart + 25), 26);
+    EXPECT_EQ(mmu->cpu_read(OAMStart + 27), 28);
+    EXPECT_EQ(mmu->cpu_read(OAMStart + 40), 0x66);
+    EXPECT_EQ(mmu->cpu_read(OAMEnd), DMATransferSize);
+    EXPECT_EQ(mmu->cpu_read(WRAM0Start + 27), 0x55);
+
+    // Sources without a direct page are read through their region (ROM before a cartridge)
+    mmu->start_dma(ROMBank0Start >> 8);
+    mmu->tick_dma(DMATransferCycles);
+    EXPECT_EQ(mmu->cpu_read(OAMStart), OpenBusValue);
+    EXPECT_EQ(mmu->cpu_read(OAMEnd), OpenBusValue);
+
+    mmu->write_byte(OAMStart, 0xAA);
+    EXPECT_EQ(mmu->cpu_read(OAMStart), 0xAA);
+}
+
+TEST_F(MmuTest, FlatRam)
+{
+    std::vector<uint8_t> ram(MemoryMapSize);
+    std::vector<std::tuple<uint16_t, uint8_t, bool>> accesses;
+    mmu->map_flat_ram(
+        std::span<uint8_t, MemoryMapSize>(ram),
+        [&](uint16_t addr, uint8_t value, bool write) { accesses.emplace_back(addr, value, write); }
+    );
+
+    // ROM, I/O and IE are plain RAM
+    for (uint16_t addr : {ROMBank0Start, ECHOStart, IOStart, IEAddr}) {
+        mmu->write_byte(addr, 0x42);
+        EXPECT_EQ(mmu->read_byte(addr), 0x42);
+        EXPECT_EQ(ram[addr], 0x42);
+    }
+    EXPECT_EQ(ram[WRAM0Start], 0x00) << "ECHO isn't mirrored";
+    EXPECT_EQ(io->interrupts().ie(), 0x00);
+    EXPECT_EQ(mmu->fetch_page(WRAM0Start), nullptr);
+
+    ASSERT_EQ(accesses.size(), 8);
+    EXPECT_EQ(accesses[0], std::make_tuple(ROMBank0Start, 0x42, true));
+    EXPECT_EQ(accesses[1], std::make_tuple(ROMBank0Start, 0x42, false));
+
+    // Init restores the memory map
+    mmu->init();
+    mmu->write_byte(IEAddr, 0x1F);
+    EXPECT_EQ(io->interrupts().ie(), 0x1F);
+    EXPECT_EQ(ram[IEAddr], 0x42);
+}
@@ -0,0 +1,249 @@
+/**
+ * @file test_watchpoints.cpp
+ * @brief Tests for the MMU watchpoints and page trapping.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// helpers
+#include "helpers/cpu_fixtures.h"
+
+// boyboy
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/opcodes.h"
+#include "boyboy/core/io/io.h"
+#include "boyboy/core/mmu/constants.h"
+#include "boyboy/core/mmu/mmu.h"
+#include "boyboy/core/mmu/watchpoints.h"
+
+using boyboy::test::cpu::CpuTest;
+
+using namespace boyboy::core::mmu;
+
+TEST(WatchpointsTest, Pages)
+{
+    Watchpoints watchpoints;
+    EXPECT_TRUE(watchpoints.empty());
+
+    auto read = watchpoints.add(0xC0F0, 0xC110, WatchKind::Read);
+    auto write = watchpoints.add(0xC180, 0xC180, WatchKind::Write | WatchKind::Execute);
+    EXPECT_EQ(watchpoints.page_kinds(0xC0), WatchKind::Read);
+    EXPECT_EQ(
+        watchpoints.page_kinds(0xC1), WatchKind::Read | WatchKind::Write | WatchKind::Execute
+    );
+    EXPECT_EQ(watchpoints.page_kinds(0xC2), WatchKind::None);
+
+    EXPECT_TRUE(watchpoints.remove(write));
+    EXPECT_FALSE(watchpoints.remove(write));
+    EXPECT_EQ(watchpoints.page_kinds(0xC1), WatchKind::Read);
+
+    EXPECT_TRUE(watchpoints.remove(read));
+    EXPECT_TRUE(watchpoints.empty());
+    EXPECT_EQ(watchpoints.page_kinds(0xC0), WatchKind::None);
+}
+
+TEST(WatchpointsTest, Check)
+{
+    Watchpoints watchpoints;
+    auto id = watchpoints.add(0xC010, 0xC01F, WatchKind::Write);
+
+    // Exact range and kind only
+    EXPECT_FALSE(watchpoints.check(0xC00F, 0x01, WatchKind::Write));
+    EXPECT_FALSE(watchpoints.check(0xC010, 0x01, WatchKind::Read));
+    EXPECT_FALSE(watchpoints.hit().has_value());
+
+    EXPECT_TRUE(watchpoints.check(0xC01F, 0x42, WatchKind::Write));
+    ASSERT_TRUE(watchpoints.hit().has_value());
+    EXPECT_EQ(watchpoints.hit()->id, id);
+    EXPECT_EQ(watchpoints.hit()->addr, 0xC01F);
+    EXPECT_EQ(watchpoints.hit()->value, 0x42);
+    EXPECT_EQ(watchpoints.hit()->kind, WatchKind::Write);
+    watchpoints.clear_hit();
+
+    // The callback sees every hit and decides whether to break
+    std::vector<uint16_t> hits;
+    watchpoints.set_callback([&hits](const WatchHit& hit) {
+        hits.push_back(hit.addr);
+        return hit.value != 0;
+    });
+    EXPECT_TRUE(watchpoints.check(0xC010, 0x00, WatchKind::Write));
+    EXPECT_FALSE(watchpoints.hit().has_value());
+    EXPECT_TRUE(watchpoints.check(0xC011, 0x01, WatchKind::Write));
+    EXPECT_TRUE(watchpoints.hit().has_value());
+    EXPECT_EQ(hits, (std::vector<uint16_t>{0xC010, 0xC011}));
+}
+
+class WatchpointMmuTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        io  = std::make_shared<boyboy::core::io::Io>();
+        mmu = std::make_unique<Mmu>(io);
+        mmu->init();
+    }
+    std::shared_ptr<boyboy::core::io::Io> io;
+    std::unique_ptr<Mmu> mmu;
+};
+
+TEST_F(WatchpointMmuTest, TrappedPages)
+{
+    mmu->write_byte(WRAM0Start + 0x10, 0x5A);
+    auto generation = mmu->map_generation();
+
+    auto id = mmu->add_watchpoint(WRAM0Start + 0x10, WRAM0Start + 0x10, WatchKind::Read);
+    EXPECT_NE(mmu->map_generation(), generation);
+    EXPECT_EQ(mmu->fetch_page(WRAM0Start), nullptr);
+    EXPECT_NE(mmu->fetch_page(WRAM1Start), nullptr);
+
+    // Other addresses of the page, writes and PPU reads don't hit
+    EXPECT_EQ(mmu->read_byte(WRAM0Start + 0x11), 0x00);
+    mmu->write_byte(WRAM0Start + 0x10, 0x5B);
+    EXPECT_EQ(mmu->ppu_read(WRAM0Start + 0x10), 0x5B);
+    EXPECT_FALSE(mmu->watch_hit().has_value());
+
+    EXPECT_EQ(mmu->cpu_read(WRAM0Start + 0x10), 0x5B);
+    ASSERT_TRUE(mmu->watch_hit().has_value());
+    EXPECT_EQ(mmu->watch_hit()->addr, WRAM0Start + 0x10);
+    EXPECT_EQ(mmu->watch_hit()->kind, WatchKind::Read);
+    mmu->clear_watch_hit();
+
+    // Released pages are direct again
+    EXPECT_TRUE(mmu->remove_watchpoint(id));
+    EXPECT_NE(mmu->fetch_page(WRAM0Start), nullptr);
+    EXPECT_EQ(mmu->cpu_read(WRAM0Start + 0x10), 0x5B);
+    EXPECT_FALSE(mmu->watch_hit().has_value());
+}
+
+TEST_F(WatchpointMmuTest, Writes)
+{
+    // Writes are seen even when they are ignored (locked VRAM here)
+    mmu->add_watchpoint(VRAMStart, VRAMStart + 0x0F, WatchKind::Write);
+    mmu->lock_vram(true);
+    mmu->write_byte(VRAMStart + 0x08, 0x77);
+    mmu->lock_vram(false);
+
+    ASSERT_TRUE(mmu->watch_hit().has_value());
+    EXPECT_EQ(mmu->watch_hit()->addr, VRAMStart + 0x08);
+    EXPECT_EQ(mmu->watch_hit()->value, 0x77);
+    EXPECT_EQ(mmu->read_byte(VRAMStart + 0x08), 0x00);
+
+    mmu->clear_watchpoints();
+    EXPECT_FALSE(mmu->watch_hit().has_value());
+    mmu->write_byte(VRAMStart + 0x08, 0x77);
+    EXPECT_FALSE(mmu->watch_hit().has_value());
+    EXPECT_EQ(mmu->read_byte(VRAMStart + 0x08), 0x77);
+}
+
+TEST_F(WatchpointMmuTest, EchoRam)
+{
+    // ECHO RAM accesses are checked against the WRAM range they land on
+    auto generation = mmu->map_generation();
+    mmu->add_watchpoint(WRAM0Start, WRAM0Start + 0xFF, WatchKind::Write | WatchKind::Execute);
+    EXPECT_NE(mmu->map_generation(), generation);
+    EXPECT_EQ(mmu->fetch_page(ECHOStart), nullptr);
+
+    mmu->write_byte(ECHOStart + 0x100, 0x11);
+    EXPECT_FALSE(mmu->watch_hit().has_value());
+
+    mmu->write_byte(ECHOStart + 0x20, 0x22);
+    ASSERT_TRUE(mmu->watch_hit().has_value());
+    EXPECT_EQ(mmu->watch_hit()->addr, WRAM0Start + 0x20);
+    EXPECT_EQ(mmu->watch_hit()->value, 0x22);
+    EXPECT_EQ(mmu->watch_hit()->kind, WatchKind::Write);
+    EXPECT_EQ(mmu->read_byte(WRAM0Start + 0x20), 0x22);
+    mmu->clear_watch_hit();
+
+    // Fetches through ECHO RAM are trapped too
+    EXPECT_TRUE(mmu->is_fetch_trapped(ECHOStart + 0x20));
+    mmu->check_fetch(ECHOStart + 0x20, 0x22);
+    ASSERT_TRUE(mmu->watch_hit().has_value());
+    EXPECT_EQ(mmu->watch_hit()->kind, WatchKind::Execute);
+}
+
+class WatchpointCpuTest : public CpuTest {
+protected:
+    static constexpr uint16_t Start = WRAM0Start;
+
+    void SetUp() override
+    {
+        CpuTest::SetUp();
+
+        // NOP; NOP; LD A, 0x42
+        set_next_bytes({
+            std::to_underlying(boyboy::core::cpu::Opcode::NOP),
+            std::to_underlying(boyboy::core::cpu::Opcode::NOP),
+            std::to_underlying(boyboy::core::cpu::Opcode::LD_A_N8),
+            0x42,
+        });
+    }
+};
+
+TEST_F(WatchpointCpuTest, Execute)
+{
+    mmu->add_watchpoint(Start + 1, Start + 1, WatchKind::Execute);
+
+    step();
+    EXPECT_FALSE(mmu->watch_hit().has_value());
+    step();
+    ASSERT_TRUE(mmu->watch_hit().has_value());
+    EXPECT_EQ(mmu->watch_hit()->addr, Start + 1);
+    EXPECT_EQ(mmu->watch_hit()->kind, WatchKind::Execute);
+}
+
+TEST_F(WatchpointCpuTest, BlockCache)
+{
+    cpu->set_tick_mode(boyboy::core::cpu::TickMode::Instruction);
+    cpu->enable_block_cache(true);
+    mmu->add_watchpoint(Start + 3, Start + 3, WatchKind::Read);
+
+    // Trapped pages aren't predecoded, their fetches go through the MMU
+    cpu->tick();
+    cpu->tick();
+    cpu->tick();
+    EXPECT_EQ(cpu->get_block_cache().size(), 0);
+    EXPECT_EQ(cpu->get_register(boyboy::core::cpu::Reg8Name::A), 0x42);
+    ASSERT_TRUE(mmu->watch_hit().has_value());
+    EXPECT_EQ(mmu->watch_hit()->addr, Start + 3);
+    EXPECT_EQ(mmu->watch_hit()->value, 0x42);
+}
+
+TEST_F(WatchpointCpuTest, Batching)
+{
+    using boyboy::core::cpu::Opcode;
+
+    cpu->set_tick_mode(boyboy::core::cpu::TickMode::Instruction);
+    cpu->enable_block_cache(true);
+    cpu->enable_block_batching(true);
+    mmu->add_watchpoint(WRAM0Start + 0x100, WRAM0Start + 0x101, WatchKind::Write);
+
+    // LD HL, 0xC100; LD A, 0x11; LD [HL+], A; LD [HL], A; NOP
+    set_next_bytes({
+        std::to_underlying(Opcode::LD_HL_N16),
+        0x00,
+        0xC1,
+        std::to_underlying(Opcode::LD_A_N8),
+        0x11,
+        std::to_underlying(Opcode::LD_AT_HL_INC_A),
+        std::to_underlying(Opcode::LD_AT_HL_A),
+        std::to_underlying(Opcode::NOP),
+    });
+
+    // The batch stops right after the trapped write
+    cpu->tick();
+    EXPECT_EQ(cpu->get_register(boyboy::core::cpu::Reg16Name::PC), Start + 6);
+    ASSERT_TRUE(mmu->watch_hit().has_value());
+    EXPECT_EQ(mmu->watch_hit()->addr, WRAM0Start + 0x100);
+    EXPECT_EQ(mmu->watch_hit()->value, 0x11);
+
+    // Later hits don't replace the pending one
+    cpu->tick();
+    EXPECT_EQ(mmu->read_byte(WRAM0Start + 0x101), 0x11);
+    EXPECT_EQ(mmu->watch_hit()->addr, WRAM0Start + 0x100);
+}
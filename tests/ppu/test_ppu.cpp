@@ -135,6 +135,26 @@ TEST_F(PpuTest, ModeTransitions)
     EXPECT_EQ(total_cycles, CyclesPerFrame) << "Total cycles should match CyclesPerFrame";
 }
 
+TEST_F(PpuTest, CyclesToEvent)
+{
+    ppu_->enable_lcd(false);
+    EXPECT_EQ(ppu_->cycles_to_event(), Ppu::NoEvent);
+
+    ppu_->enable_lcd(true);
+    EXPECT_EQ(ppu_->cycles_to_event(), Cycles::OAMScan);
+
+    // Next event is always the next mode transition
+    ppu_->tick(20);
+    EXPECT_EQ(ppu_->cycles_to_event(), Cycles::OAMScan - 20);
+    ppu_->tick(Cycles::OAMScan - 20);
+    EXPECT_EQ(ppu_->mode(), Mode::Transfer);
+    EXPECT_EQ(ppu_->cycles_to_event(), Cycles::Transfer);
+
+    ppu_->tick(Cycles::Transfer);
+    EXPECT_EQ(ppu_->mode(), Mode::HBlank);
+    EXPECT_EQ(ppu_->cycles_to_event(), Cycles::HBlank);
+}
+
 TEST_F(PpuTest, VBlankInterrupt)
 {
     bool vblank_irq_triggered = false;
@@ -0,0 +1,98 @@
+/**
+ * @file test_call_profiler.cpp
+ * @brief Tests for the guest call-stack profiler.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// boyboy
+#include "boyboy/core/profiling/call_profiler.h"
+
+using boyboy::core::profiling::CallProfiler;
+
+class CallProfilerTest : public ::testing::Test {
+protected:
+    static constexpr uint16_t Stack = 0xDFFF;
+
+    CallProfiler profiler;
+};
+
+TEST_F(CallProfilerTest, NestedCalls)
+{
+    profiler.add_cycles(4);
+    profiler.call(0, 0x0150, Stack - 2);
+    profiler.add_cycles(24);
+    profiler.call(1, 0x4A2F, Stack - 4);
+    profiler.add_cycles(100);
+    EXPECT_EQ(profiler.depth(), 2);
+
+    profiler.ret(Stack - 4);
+    profiler.add_cycles(16);
+    profiler.ret(Stack - 2);
+    profiler.add_cycles(8);
+    EXPECT_EQ(profiler.depth(), 0);
+
+    EXPECT_EQ(profiler.to_folded(), "root 12\n"
+                                    "root;00:0150 40\n"
+                                    "root;00:0150;01:4A2F 100\n");
+}
+
+TEST_F(CallProfilerTest, SameRoutineFromDifferentCallers)
+{
+    profiler.call(0, 0x0200, Stack - 2);
+    profiler.call(0, 0x0038, Stack - 4);
+    profiler.add_cycles(10);
+    profiler.ret(Stack - 4);
+    profiler.ret(Stack - 2);
+
+    profiler.call(0, 0x0300, Stack - 2);
+    profiler.call(0, 0x0038, Stack - 4);
+    profiler.add_cycles(20);
+    profiler.ret(Stack - 4);
+    profiler.call(0, 0x0038, Stack - 4);
+    profiler.add_cycles(5);
+
+    EXPECT_EQ(profiler.to_folded(), "root;00:0200;00:0038 10\n"
+                                    "root;00:0300;00:0038 25\n");
+}
+
+TEST_F(CallProfilerTest, RetUnwindsBySp)
+{
+    // The inner routine drops its return address and returns straight to the outer caller
+    profiler.call(0, 0x0150, Stack - 2);
+    profiler.call(0, 0x0200, Stack - 4);
+    profiler.call(0, 0x0300, Stack - 6);
+    profiler.ret(Stack - 2);
+    EXPECT_EQ(profiler.depth(), 0);
+
+    // A RET from a pushed address above the frame doesn't unwind it
+    profiler.call(0, 0x0150, Stack - 2);
+    profiler.ret(Stack - 4);
+    EXPECT_EQ(profiler.depth(), 1);
+}
+
+TEST_F(CallProfilerTest, MaxDepth)
+{
+    for (size_t i = 1; i <= CallProfiler::MaxDepth + 10; ++i) {
+        profiler.call(0, 0x0100, static_cast<uint16_t>(Stack - (2 * i)));
+    }
+    EXPECT_EQ(profiler.depth(), CallProfiler::MaxDepth);
+
+    profiler.ret(Stack - 2);
+    EXPECT_EQ(profiler.depth(), 0);
+}
+
+TEST_F(CallProfilerTest, Reset)
+{
+    profiler.call(0, 0x0150, Stack - 2);
+    profiler.add_cycles(4);
+    profiler.reset();
+
+    EXPECT_EQ(profiler.depth(), 0);
+    EXPECT_TRUE(profiler.to_folded().empty());
+}
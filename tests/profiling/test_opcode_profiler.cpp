@@ -0,0 +1,92 @@
+/**
+ * @file test_opcode_profiler.cpp
+ * @brief Tests for the per-opcode execution profiler.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// boyboy
+#include "boyboy/core/profiling/opcode_profiler.h"
+
+using boyboy::core::profiling::OpcodeProfiler;
+
+class OpcodeProfilerTest : public ::testing::Test {
+protected:
+    OpcodeProfiler profiler;
+    std::array<std::string_view, OpcodeProfiler::OpcodeCount> mnemonics{};
+
+    void SetUp() override
+    {
+        mnemonics.at(OpcodeProfiler::index(false, 0x05)) = "DEC B";
+        mnemonics.at(OpcodeProfiler::index(true, 0x7C)) = "BIT 7, H";
+    }
+};
+
+TEST_F(OpcodeProfilerTest, RecordsCountsAndCycles)
+{
+    for (int i = 0; i < 10; ++i) {
+        profiler.start();
+        profiler.stop(false, 0x05, 4);
+    }
+    profiler.record(true, 0x7C, 8);
+
+    const auto& dec_b = profiler.stats(false, 0x05);
+    EXPECT_EQ(dec_b.count, 10);
+    EXPECT_EQ(dec_b.cycles, 40);
+    EXPECT_EQ(dec_b.samples, 1); // only the first execution of the interval is timed
+
+    // Untimed executions are counted without samples
+    const auto& bit = profiler.stats(true, 0x7C);
+    EXPECT_EQ(bit.count, 1);
+    EXPECT_EQ(bit.cycles, 8);
+    EXPECT_EQ(bit.samples, 0);
+    EXPECT_EQ(bit.avg_ns(), 0.0);
+
+    // Prefixed and unprefixed opcodes are kept apart
+    EXPECT_EQ(profiler.stats(true, 0x05).count, 0);
+
+    profiler.reset();
+    EXPECT_EQ(profiler.stats(false, 0x05).count, 0);
+}
+
+TEST_F(OpcodeProfilerTest, SamplesOncePerInterval)
+{
+    for (uint64_t i = 0; i < OpcodeProfiler::SampleInterval * 3; ++i) {
+        profiler.start();
+        profiler.stop(false, 0x05, 4);
+    }
+    EXPECT_EQ(profiler.stats(false, 0x05).samples, 3);
+}
+
+TEST_F(OpcodeProfilerTest, ExportsExecutedOpcodes)
+{
+    profiler.record(false, 0x05, 4);
+    profiler.record(true, 0x7C, 8);
+
+    auto csv = profiler.to_csv(mnemonics);
+    EXPECT_EQ(
+        csv,
+        "opcode,mnemonic,count,cycles,samples,avg_ns,total_ns\n"
+        "05,\"DEC B\",1,4,0,0.00,0.00\n"
+        "CB7C,\"BIT 7, H\",1,8,0,0.00,0.00\n"
+    );
+
+    auto json = profiler.to_json(mnemonics);
+    EXPECT_NE(
+        json.find(R"({"opcode": "05", "mnemonic": "DEC B", "count": 1, "cycles": 4)"),
+        std::string::npos
+    );
+    EXPECT_NE(json.find("\"opcode\": \"CB7C\""), std::string::npos);
+    EXPECT_EQ(json.front(), '[');
+
+    // Nothing executed, nothing exported
+    profiler.reset();
+    EXPECT_EQ(profiler.to_json(mnemonics), "[]\n");
+}
@@ -0,0 +1,210 @@
+/**
+ * @file sst_main.cpp
+ * @brief Main entry point for the SM83 single-step conformance tests.
+ *
+ * Usage: boyboy_sst <vectors dir> [--jobs=N] [--max-reports=N] [--top=N] [--timings=file.csv]
+ *
+ * Runs every *.json test vector file of the directory across a pool of threads, each with its own
+ * CPU, and prints the failures followed by the opcodes with the most host time per case.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "sst_runner.h"
+
+// boyboy
+#include "boyboy/common/files/io.h"
+#include "boyboy/common/log/logging.h"
+#include "boyboy/core/cpu/instructions.h"
+#include "boyboy/core/cpu/instructions_table.h"
+
+using boyboy::test::sst::FileResult;
+using boyboy::test::sst::OpcodeTiming;
+using boyboy::test::sst::SstRunner;
+
+namespace {
+
+struct Options {
+    std::filesystem::path dir;
+    size_t jobs = std::max(1U, std::thread::hardware_concurrency());
+    size_t max_reports = 5; // per file
+    size_t top = 20;
+    std::filesystem::path timings;
+};
+
+std::string_view mnemonic(size_t index)
+{
+    using namespace boyboy::core::cpu;
+    auto type = (index >= 256) ? InstructionType::CBPrefixed : InstructionType::Unprefixed;
+    return InstructionTable::mnemonic(type, static_cast<uint8_t>(index % 256));
+}
+
+double mean_ns(const OpcodeTiming& timing)
+{
+    return (timing.cases > 0)
+               ? static_cast<double>(timing.nanoseconds) / static_cast<double>(timing.cases)
+               : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i]; // NOLINT
+        auto value = [&arg](std::string_view option) {
+            return std::string(arg.substr(option.size()));
+        };
+        if (arg.starts_with("--jobs=")) {
+            options.jobs = std::max<size_t>(1, std::stoul(value("--jobs=")));
+        }
+        else if (arg.starts_with("--max-reports=")) {
+            options.max_reports = std::stoul(value("--max-reports="));
+        }
+        else if (arg.starts_with("--top=")) {
+            options.top = std::stoul(value("--top="));
+        }
+        else if (arg.starts_with("--timings=")) {
+            options.timings = value("--timings=");
+        }
+        else {
+            options.dir = arg;
+        }
+    }
+
+    if (options.dir.empty() || !std::filesystem::is_directory(options.dir)) {
+        std::cerr << "Usage: " << argv[0] // NOLINT
+                  << " <vectors dir> [--jobs=N] [--max-reports=N] [--top=N] [--timings=file]\n";
+        return 1;
+    }
+
+#ifdef ENABLE_PROFILING
+    // The global profilers aren't thread safe
+    options.jobs = 1;
+#endif
+
+    // Keep logging out of the measured instructions
+    boyboy::common::log::init("logs/sst_boyboy.log", true);
+    boyboy::common::log::set_level(boyboy::common::log::LogLevel::Warn);
+
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(options.dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".json") {
+            files.push_back(entry.path());
+        }
+    }
+    std::ranges::sort(files);
+
+    // Each worker pulls the next file, with its own CPU and timings
+    std::vector<FileResult> results(files.size());
+    std::vector<std::array<OpcodeTiming, SstRunner::OpcodeCount>> timings(options.jobs);
+    std::atomic<size_t> next_file{0};
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> workers;
+        for (size_t job = 0; job < options.jobs; ++job) {
+            workers.emplace_back([&, job]() {
+                SstRunner runner(options.max_reports);
+                for (size_t file = next_file++; file < files.size(); file = next_file++) {
+                    results[file] = runner.run_file(files[file]);
+                }
+                timings[job] = runner.timings();
+            });
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    // Failures
+    size_t cases = 0;
+    size_t failed = 0;
+    for (const auto& result : results) {
+        cases += result.cases;
+        failed += result.failed;
+        for (const auto& report : result.reports) {
+            std::cout << report;
+        }
+        if (result.failed > result.reports.size()) {
+            std::cout << std::format(
+                "{}: {} more failures\n", result.file, result.failed - result.reports.size()
+            );
+        }
+    }
+
+    // Host time per opcode
+    std::array<OpcodeTiming, SstRunner::OpcodeCount> total{};
+    for (const auto& job_timings : timings) {
+        for (size_t index = 0; index < total.size(); ++index) {
+            total.at(index).cases += job_timings.at(index).cases;
+            total.at(index).nanoseconds += job_timings.at(index).nanoseconds;
+        }
+    }
+
+    std::vector<size_t> opcodes(total.size());
+    std::iota(opcodes.begin(), opcodes.end(), 0);
+    std::ranges::sort(opcodes, [&total](size_t lhs, size_t rhs) {
+        return mean_ns(total.at(lhs)) > mean_ns(total.at(rhs));
+    });
+
+    std::cout << std::format("\nSlowest opcodes (host ns per case):\n");
+    for (size_t index : opcodes | std::views::take(options.top)) {
+        if (total.at(index).cases == 0) {
+            break;
+        }
+        std::cout << std::format(
+            "  {}{:02X} {:<14} {:8.1f} ns ({} cases)\n",
+            (index >= 256) ? "CB " : "   ",
+            index % 256,
+            mnemonic(index),
+            mean_ns(total.at(index)),
+            total.at(index).cases
+        );
+    }
+
+    if (!options.timings.empty()) {
+        std::string csv = "opcode,mnemonic,cases,total_ns,mean_ns\n";
+        for (size_t index = 0; index < total.size(); ++index) {
+            csv += std::format(
+                "{}{:02X},\"{}\",{},{},{:.1f}\n",
+                (index >= 256) ? "CB" : "",
+                index % 256,
+                mnemonic(index),
+                total.at(index).cases,
+                total.at(index).nanoseconds,
+                mean_ns(total.at(index))
+            );
+        }
+        if (auto res = boyboy::common::files::write_text(options.timings, csv); !res) {
+            std::cerr << "Error writing timings: " << res.error().error_message() << "\n";
+        }
+    }
+
+    std::cout << std::format(
+        "\n{}/{} cases passed, {} files, {} threads, {:.2f}s\n",
+        cases - failed,
+        cases,
+        files.size(),
+        options.jobs,
+        elapsed.count()
+    );
+
+    boyboy::common::log::shutdown();
+    return (failed == 0 && !files.empty()) ? 0 : 1;
+}
@@ -0,0 +1,262 @@
+/**
+ * @file sst_runner.cpp
+ * @brief SM83 single-step test runner.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#include "sst_runner.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// boyboy
+#include "boyboy/common/files/io.h"
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/cpu_constants.h"
+#include "boyboy/core/cpu/cycles.h"
+#include "boyboy/core/cpu/registers.h"
+#include "boyboy/core/io/io.h"
+#include "boyboy/core/mmu/constants.h"
+#include "boyboy/core/mmu/mmu.h"
+
+namespace boyboy::test::sst {
+
+using namespace boyboy::core;
+using nlohmann::json;
+
+namespace {
+
+constexpr std::array<std::pair<std::string_view, cpu::Reg8Name>, 8> Reg8Fields = {{
+    {"a", cpu::Reg8Name::A},
+    {"f", cpu::Reg8Name::F},
+    {"b", cpu::Reg8Name::B},
+    {"c", cpu::Reg8Name::C},
+    {"d", cpu::Reg8Name::D},
+    {"e", cpu::Reg8Name::E},
+    {"h", cpu::Reg8Name::H},
+    {"l", cpu::Reg8Name::L},
+}};
+
+// Opcode of a case from its name, e.g. "cb 7c 0012" -> (true, 0x7C)
+std::pair<bool, uint8_t> parse_opcode(std::string_view name)
+{
+    auto byte = [&name](size_t pos) {
+        return static_cast<uint8_t>(std::stoul(std::string(name.substr(pos, 2)), nullptr, 16));
+    };
+    if (name.starts_with("cb ")) {
+        return {true, byte(3)};
+    }
+    return {false, byte(0)};
+}
+
+// Initial RAM value of a case, 0 if not set
+uint8_t ram_value(const json& state, uint16_t addr)
+{
+    for (const auto& entry : state.at("ram")) {
+        if (entry.at(0).get<uint16_t>() == addr) {
+            return entry.at(1).get<uint8_t>();
+        }
+    }
+    return 0;
+}
+
+void expect_eq(std::string& report, std::string_view field, unsigned expected, unsigned actual)
+{
+    if (expected != actual) {
+        report += std::format("  {}: expected {:#06x}, got {:#06x}\n", field, expected, actual);
+    }
+}
+
+} // namespace
+
+SstRunner::SstRunner(size_t max_reports)
+    : max_reports_(max_reports), io_(std::make_shared<io::Io>()),
+      mmu_(std::make_shared<mmu::Mmu>(io_)), cpu_(std::make_unique<cpu::Cpu>(mmu_)),
+      ram_(mmu::MemoryMapSize)
+{
+    mmu_->init();
+    mmu_->map_flat_ram(
+        std::span<uint8_t, mmu::MemoryMapSize>(ram_),
+        [this](uint16_t addr, uint8_t value, bool write) {
+            bus_.push_back({.addr = addr, .value = value, .write = write});
+        }
+    );
+
+    cpu_->init();
+    cpu_->set_tick_mode(cpu::TickMode::Instruction);
+    initial_state_ = cpu_->snapshot();
+}
+
+FileResult SstRunner::run_file(const std::filesystem::path& path)
+{
+    FileResult result{.file = path.filename().string()};
+
+    auto fail = [&result, this](std::string report) {
+        result.failed++;
+        if (result.reports.size() < max_reports_) {
+            result.reports.push_back(std::move(report));
+        }
+    };
+
+    auto text = common::files::read_text(path);
+    if (!text) {
+        fail(std::format("{}: {}\n", result.file, text.error().error_message()));
+        return result;
+    }
+
+    json cases;
+    try {
+        cases = json::parse(*text);
+    }
+    catch (const json::exception& e) {
+        fail(std::format("{}: {}\n", result.file, e.what()));
+        return result;
+    }
+
+    // The vectors either start at the opcode, or right after it with the opcode fetched by the
+    // previous instruction and the next one fetched on the last M-cycle
+    bool prefetched = std::ranges::any_of(cases, [](const json& test) {
+        const auto& initial = test.at("initial");
+        auto [prefixed, opcode] = parse_opcode(test.at("name").get<std::string>());
+        auto pc = initial.at("pc").get<uint16_t>();
+        return ram_value(initial, pc) != (prefixed ? cpu::CBInstructionPrefix : opcode) ||
+               (prefixed && ram_value(initial, static_cast<uint16_t>(pc + 1)) != opcode);
+    });
+
+    for (const auto& test : cases) {
+        result.cases++;
+
+        const auto name = test.at("name").get<std::string>();
+        const auto& initial = test.at("initial");
+        const auto& final_state = test.at("final");
+        auto [prefixed, opcode] = parse_opcode(name);
+
+        // Initial state
+        cpu_->restore(initial_state_);
+        for (auto [field, reg] : Reg8Fields) {
+            cpu_->set_register(reg, initial.at(field).get<uint8_t>());
+        }
+        cpu_->set_sp(initial.at("sp").get<uint16_t>());
+        cpu_->set_ime(initial.at("ime").get<int>() != 0);
+        for (const auto& entry : initial.at("ram")) {
+            ram_[entry.at(0).get<uint16_t>()] = entry.at(1).get<uint8_t>();
+        }
+
+        auto pc = initial.at("pc").get<uint16_t>();
+        cpu_->set_pc(prefetched ? static_cast<uint16_t>(pc - 1) : pc);
+
+        bus_.clear();
+        auto start = std::chrono::steady_clock::now();
+        cpu::TCycle cycles = cpu_->tick();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        auto& timing = timings_.at(index(prefixed, opcode));
+        timing.cases++;
+        timing.nanoseconds += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()
+        );
+
+        // Bus activity in the prefetch model
+        std::vector<BusAccess> bus = bus_;
+        if (prefetched) {
+            if (!bus.empty()) {
+                bus.erase(bus.begin());
+            }
+            uint16_t next = cpu_->get_pc();
+            bus.push_back({.addr = next, .value = ram_[next], .write = false});
+        }
+
+        // Final state
+        std::string report;
+        for (auto [field, reg] : Reg8Fields) {
+            expect_eq(report, field, final_state.at(field).get<uint8_t>(), cpu_->get_register(reg));
+        }
+        expect_eq(report, "sp", final_state.at("sp").get<uint16_t>(), cpu_->get_sp());
+        expect_eq(
+            report,
+            "pc",
+            final_state.at("pc").get<uint16_t>(),
+            static_cast<uint16_t>(cpu_->get_pc() + (prefetched ? 1 : 0))
+        );
+        if (final_state.contains("ei")) {
+            expect_eq(report, "ime", final_state.at("ime").get<int>(), cpu_->get_ime() ? 1 : 0);
+            expect_eq(
+                report, "ei", final_state.at("ei").get<int>(), cpu_->is_ime_scheduled() ? 1 : 0
+            );
+        }
+        else {
+            bool ime = cpu_->get_ime() || cpu_->is_ime_scheduled();
+            expect_eq(report, "ime", final_state.at("ime").get<int>(), ime ? 1 : 0);
+        }
+        for (const auto& entry : final_state.at("ram")) {
+            auto addr = entry.at(0).get<uint16_t>();
+            expect_eq(
+                report, std::format("[{:#06x}]", addr), entry.at(1).get<uint8_t>(), ram_[addr]
+            );
+        }
+
+        // Cycles and bus activity, internal M-cycles are null or "---"
+        const auto& expected_cycles = test.at("cycles");
+        expect_eq(report, "cycles", static_cast<unsigned>(expected_cycles.size() * 4), cycles);
+
+        std::vector<BusAccess> expected_bus;
+        for (const auto& cycle : expected_cycles) {
+            if (cycle.is_null()) {
+                continue;
+            }
+            auto kind = cycle.at(2).get<std::string>();
+            bool write = kind.contains('w');
+            if (!write && !kind.contains('r')) {
+                continue;
+            }
+            expected_bus.push_back({
+                .addr = cycle.at(0).get<uint16_t>(),
+                .value = cycle.at(1).get<uint8_t>(),
+                .write = write,
+            });
+        }
+        if (bus != expected_bus) {
+            auto to_string = [](const std::vector<BusAccess>& accesses) {
+                std::string text;
+                for (const auto& access : accesses) {
+                    text += std::format(
+                        " {}{:04x}={:02x}", access.write ? 'W' : 'R', access.addr, access.value
+                    );
+                }
+                return text;
+            };
+            report += std::format("  bus: expected{}\n", to_string(expected_bus));
+            report += std::format("       got     {}\n", to_string(bus));
+        }
+
+        if (!report.empty()) {
+            fail(std::format("{} ({}):\n{}", name, result.file, report));
+        }
+
+        // Clear the RAM for the next case
+        for (const auto& entry : initial.at("ram")) {
+            ram_[entry.at(0).get<uint16_t>()] = 0;
+        }
+        for (const auto& access : bus_) {
+            ram_[access.addr] = 0;
+        }
+    }
+
+    return result;
+}
+
+} // namespace boyboy::test::sst
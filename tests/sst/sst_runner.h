@@ -0,0 +1,93 @@
+/**
+ * @file sst_runner.h
+ * @brief SM83 single-step test runner.
+ *
+ * Runs the per-opcode JSON test vectors of the SingleStepTests project
+ * (https://github.com/SingleStepTests/sm83): each case sets the CPU registers and RAM, executes
+ * one instruction and checks the final registers, RAM, cycles and bus activity.
+ *
+ * The cases run against an Mmu mapped as flat 64KB RAM (see Mmu::map_flat_ram), in
+ * TickMode::Instruction.
+ *
+ * @license GPLv3 (see LICENSE file)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// boyboy
+#include "boyboy/core/cpu/cpu.h"
+#include "boyboy/core/cpu/state.h"
+#include "boyboy/core/io/io.h"
+#include "boyboy/core/mmu/mmu.h"
+
+namespace boyboy::test::sst {
+
+// Host time spent executing the cases of an opcode
+struct OpcodeTiming {
+    uint64_t cases = 0;
+    uint64_t nanoseconds = 0;
+};
+
+// Results of a test vector file
+struct FileResult {
+    std::string file;
+    size_t cases = 0;
+    size_t failed = 0;
+    std::vector<std::string> reports; // first failures, one multi-line report each
+};
+
+class SstRunner {
+public:
+    // Unprefixed opcodes first, then CB-prefixed ones
+    static constexpr size_t OpcodeCount = 512;
+    static constexpr size_t index(bool prefixed, uint8_t opcode)
+    {
+        return (prefixed ? 256 : 0) + opcode;
+    }
+
+    /**
+     * @brief Create a runner with its own CPU, MMU and I/O (one per thread).
+     *
+     * @param max_reports Max failure reports kept per file.
+     */
+    explicit SstRunner(size_t max_reports);
+
+    /**
+     * @brief Run all the cases of a test vector file.
+     *
+     * @param path JSON test vector file.
+     * @return FileResult Results of the file, a file that can't be read or parsed is one failure.
+     */
+    FileResult run_file(const std::filesystem::path& path);
+
+    [[nodiscard]] const std::array<OpcodeTiming, OpcodeCount>& timings() const { return timings_; }
+
+private:
+    struct BusAccess {
+        uint16_t addr;
+        uint8_t value;
+        bool write;
+
+        bool operator==(const BusAccess&) const = default;
+    };
+
+    size_t max_reports_;
+    std::shared_ptr<core::io::Io> io_;
+    std::shared_ptr<core::mmu::Mmu> mmu_;
+    std::unique_ptr<core::cpu::Cpu> cpu_;
+    core::cpu::CpuState initial_state_;
+
+    std::vector<uint8_t> ram_;
+    std::vector<BusAccess> bus_;
+    std::array<OpcodeTiming, OpcodeCount> timings_{};
+};
+
+} // namespace boyboy::test::sst
@@ -9,6 +9,7 @@
 
 #include <filesystem>
 #include <iostream>
+#include <string>
 
 // helpers
 #include "helpers/global_tick_mode.h"
@@ -27,7 +28,7 @@ int main(int argc, char** argv)
     using boyboy::core::cpu::TickMode;
     using boyboy::tests::g_tick_mode;
 
-    // Optional argument: --tick-mode=[instruction|mcycle|tcycle]
+    // Optional argument: --tick-mode=[instruction|mcycle|tcycle|catchup]
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i]; // NOLINT
         if (arg == "--tick-mode=instruction") {
@@ -39,6 +40,14 @@ int main(int argc, char** argv)
         else if (arg == "--tick-mode=tcycle") {
             g_tick_mode = TickMode::TCycle;
         }
+        else if (arg == "--tick-mode=catchup") {
+            g_tick_mode = TickMode::CatchUp;
+        }
+        else if (arg.starts_with("--tick-mode=")) {
+            std::cerr << "Unknown tick mode: " << arg << '\n';
+            boyboy::common::log::shutdown();
+            return 1;
+        }
     }
 
     std::cout << "\n=== Running tests with TickMode = " << to_string(g_tick_mode) << " ===\n";